@@ -5,6 +5,13 @@
 #include <Adafruit_MLX90614.h>
 #include <MAX3010x.h>
 #include "filters.h"
+#include "scheduler.h"
+#include "ring_buffer.h"
+#include "spsc_queue.h"
+#include "ecg_sampler.h"
+#include "frame_protocol.h"
+#include "i2c_bus.h"
+#include "strip_chart.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
@@ -17,7 +24,8 @@ Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 const int LOADCELL_DOUT_PIN = 4;
 const int LOADCELL_SCK_PIN = 5;
 HX711 scale;
-float calibration_factor = 205.8;
+// Counts per gram, negative as the load cell reads negative under load (205.8 / 0.24)
+float calibration_factor = -857.5;
 
 // Temperature Sensor
 Adafruit_MLX90614 mlx = Adafruit_MLX90614();
@@ -26,12 +34,22 @@ Adafruit_MLX90614 mlx = Adafruit_MLX90614();
 MAX30105 sensor;
 const auto kSamplingRate = sensor.SAMPLING_RATE_400SPS;
 const float kSamplingFrequency = 400.0;
+const int MAX30102_INT_PIN = 19; // Open drain, active low
+const uint8_t kSpO2AlmostFull = 15; // Interrupt with 17 of 32 samples stored, 42 ms at 400 SPS
+
+// Keeps the red and IR DC level in the middle of the ADC range, one step per 40 samples (0.1 s)
+MAX3010xGainControl<MAX30105> gainControl(sensor);
 
 const unsigned long kFingerThreshold = 10000;
 const unsigned int kFingerCooldownMs = 500;
 
 const float kEdgeThreshold = -2000.0;
 
+// Beat detection on the green LED, which is less sensitive to motion than red.
+// Needs a MAX30105, the MAX30102 has no green LED. SpO2 still uses red and IR.
+const bool kGreenPPG = false;
+typedef MAX3010xUnpacker<MAX30105, MAX30105::SLOT_RED, MAX30105::SLOT_IR, MAX30105::SLOT_GREEN> GreenPPGSlots;
+
 const float kLowPassCutoff = 5.0;
 const float kHighPassCutoff = 0.5;
 
@@ -39,6 +57,36 @@ const bool kEnableAveraging = true;
 const int kAveragingSamples = 5;
 const int kSampleThreshold = 5;
 
+// Session Timing (ms)
+const unsigned long kDisplayRefreshMs = 100;
+const unsigned long kEcgDisplayRefreshMs = 40; // 25 fps while the ECG strip chart runs
+const unsigned long kResultHoldMs = 1000;
+const unsigned long kWeightTimeoutMs = 6000; // Reports the last second when the load never settles
+const unsigned long kSpO2WindowMs = 15000;
+const unsigned long kSpO2DrainMs = 25; // 10 samples at 400 SPS, the 32 sample FIFO lasts 80 ms
+const unsigned long kTempWindowMs = 10000; // Reports the latest prediction when it never gets tight enough
+const unsigned long kEcgWindowMs = 30000;
+const unsigned long kUploadTimeoutMs = 30000;
+const unsigned long kStatusRefreshMs = 500;
+
+// Weight settling, the reading is taken as soon as it is steady
+const int kWeightStableSamples = 10; // 1 s at the 10 SPS of most HX711 boards
+const float kWeightToleranceG = 2.0; // Largest standard deviation of a steady reading
+const float kWeightDriftG = 1.0;     // Largest rise or fall of the reading across the 1 s window, load cell creep
+const float kWeightMinimumG = 10.0;  // Anything lighter counts as an empty scale
+
+// Temperature prediction, the final reading is extrapolated from the warm-up
+const float kTempToleranceC = 0.15; // Largest half-width of the 95% interval of the prediction
+const float kTempMinimumC = 30.0;   // Anything colder is the room, not the forehead
+const int kTempFitSamples = 64;     // 6.4 s at the 100 ms update period of the MLX90614
+
+// ECG sampling rate (Hz), 250 to 500 Hz is needed for clinical ECG features
+const uint32_t kEcgSampleRateHz = 250;
+
+// Sample all sensors at once instead of WEIGHT -> SPO2 -> TEMP -> ECG.
+// Each sensor finishes on its own criterion, the session ends when all are done.
+const bool kConcurrentAcquisition = false;
+
 // State Management
 enum SensorState
 {
@@ -47,29 +95,402 @@ enum SensorState
   SPO2,
   TEMP,
   ECG,
-  IDLE
+  UPLOAD,
+  RESULT,
+  IDLE,
+  ACQUIRE,
+  STATE_COUNT
 };
-SensorState currentState = WAIT_PATIENT;
-unsigned long stateStartTime = 0;
-String ecgData = "";
+
+void enterWaitPatient();
+void tickWaitPatient();
+void enterWeight();
+void tickWeight();
+void enterSPO2();
+void tickSPO2();
+void enterTemperature();
+void tickTemperature();
+void enterECG();
+void tickECG();
+void exitECG();
+void tickUpload();
+void tickResult();
+void enterAcquire();
+void tickAcquire();
+void exitAcquire();
+void refreshDisplay();
+void pollSerial();
+void sampleWeight();
+void sampleTemperature();
+void sampleECG();
+void pollECG();
+void drawAcquireStatus();
+
+const StateHooks kStates[STATE_COUNT] = {
+  { enterWaitPatient, tickWaitPatient, nullptr }, // WAIT_PATIENT
+  { enterWeight, tickWeight, nullptr },           // WEIGHT
+  { enterSPO2, tickSPO2, nullptr },               // SPO2
+  { enterTemperature, tickTemperature, nullptr }, // TEMP
+  { enterECG, tickECG, exitECG },                 // ECG
+  { nullptr, tickUpload, nullptr },               // UPLOAD
+  { nullptr, tickResult, nullptr },               // RESULT
+  { nullptr, nullptr, nullptr },                  // IDLE
+  { enterAcquire, tickAcquire, exitAcquire }      // ACQUIRE
+};
+
+Scheduler<8> scheduler(millis, kStates, STATE_COUNT);
+PeriodicTask displayTask(refreshDisplay, kDisplayRefreshMs);
+PeriodicTask serialTask(pollSerial, 0);
+PeriodicTask weightTask(sampleWeight, 0);
+PeriodicTask tempTask(sampleTemperature, MLX90614_DEFAULT_UPDATE_PERIOD); // Set from the sensor in setup()
+PeriodicTask ecgTask(pollECG, 0); // Paced by the sampler on micros(), a period in ms would round the rate
+PeriodicTask statusTask(drawAcquireStatus, kStatusRefreshMs);
+
+// Per-sensor sample buffers between the sampling tasks and the state ticks.
+// The MAX30102 buffers its samples in its own 32 entry FIFO, on the ESP32 the
+// reader task moves them into spo2Queue when the almost full interrupt fires.
+// The ECG is sampled by its own task on the ESP32, the sampler buffers in a lock-free queue.
+RingBuffer<float, 16> weightBuffer;
+SettlingDetector<kWeightStableSamples> weightSettling(kWeightToleranceG, kWeightDriftG, kWeightMinimumG);
+// Drop single readings disturbed by a glitch or a knock on the scale before
+// they reach the settling detector or the temperature prediction
+SlidingMedianFilter<3> weightDespike;
+SlidingMedianFilter<5> tempDespike;
+ExponentialApproachEstimator<kTempFitSamples> tempPrediction(kTempToleranceC, kTempMinimumC);
+
+// Object temperature with the time it was read, the fit needs the actual spacing
+struct TempReading
+{
+  unsigned long ms;
+  float celsius;
+};
+RingBuffer<TempReading, 16> tempBuffer;
+const int ECG_PIN = 35;
+int readECGAdc(uint8_t pin);
+EcgSampler<128> ecgSampler(readECGAdc, micros, ECG_PIN, kEcgSampleRateHz);
+
+// Live ECG below the title line, 4 samples per column sweep the 128 columns in about 2 s
+const int16_t kEcgChartTop = 8;
+const uint16_t kEcgSamplesPerColumn = 4;
+const int16_t kEcgChartMinSpan = 40; // ADC counts over the chart height, about 1.2 mV at the electrodes
+StripChart ecgChart(display, 0, kEcgChartTop, SCREEN_WIDTH, SCREEN_HEIGHT - kEcgChartTop, kEcgSamplesPerColumn, kEcgChartMinSpan);
+
+// Serial output (text lines and binary frames), written on core 1 and sent from core 0 on the ESP32
+const size_t kOutputLineLength = 32; // Longest text line without the line end, longer ones are cut
+struct OutputChunk
+{
+  uint8_t length;
+  uint8_t bytes[kFrameMaxSize];
+};
+static_assert(kOutputLineLength + 2 <= kFrameMaxSize, "A text line and its line end must fit in a chunk");
+SpscQueue<OutputChunk, 32> outputQueue;
+// Chunks of the session so far and the ones dropped on a full queue, reported with DATA_END
+unsigned long outputQueued = 0;
+unsigned long outputLost = 0;
+FrameEncoder frameEncoder;
+EcgFramePacker ecgPacker;
+
+#if defined(ARDUINO_ARCH_ESP32)
+// Acquisition (loop() and the ECG sampler) runs on core 1,
+// display refresh and serial output run on core 0
+const BaseType_t kAcquisitionCore = 1;
+const BaseType_t kTransportCore = 0;
+const UBaseType_t kEcgSamplerPriority = 3;
+const UBaseType_t kSpO2ReaderPriority = 2;
+const UBaseType_t kTransportPriority = 1;
+const unsigned long kTransportPeriodMs = 5;
+const unsigned long kSpO2ReaderTimeoutMs = 30; // Fallback drain if an interrupt edge is missed, below the 37 ms left after almost full
+
+// The ECG is paced by a hardware timer instead of the 1 ms FreeRTOS tick
+const uint8_t kEcgTimerId = 0;
+hw_timer_t *ecgTimer = nullptr;
+TaskHandle_t ecgSamplerHandle = nullptr;
+TaskHandle_t spo2ReaderHandle = nullptr;
+SpscQueue<MAX30105Sample, 64> spo2Queue;
+
+std::atomic<bool> ecgSampling(false);
+#endif
+
+// Shared I2C bus. The display is flushed from core 0 while the sensors are read from core 1.
+// A whole frame takes 23 ms at the 400 kHz the display is written with, the MAX30102 FIFO
+// only has 37 ms left after its almost full interrupt. Frames are therefore pushed in chunks
+// of at most kDisplayBusBudgetUs and a waiting sensor gets the bus before the next chunk.
+const uint32_t kDisplayI2CClock = 400000; // Adafruit_SSD1306 default
+const unsigned long kDisplayBusBudgetUs = 2000;
+const size_t kDisplayChunkOverhead = 10; // Address window command and data prefix of a chunk
+const uint16_t kDisplayBufferBytes = SCREEN_WIDTH * ((SCREEN_HEIGHT + 7) / 8);
+I2CBus i2cBus(kDisplayI2CClock, kDisplayBusBudgetUs);
+
+SensorState resultNextState = IDLE;
 String patientID = "";
 String patientName = "";
-const int ECG_PIN = 35;
 
-void showMessage(String msg, unsigned long delayTime = 2000)
+// Serial line assembled by pollSerial()
+String serialLine = "";
+bool serialLineReady = false;
+
+// Display frame is pushed by refreshDisplay() instead of on every draw
+std::atomic<bool> displayDirty(false);
+
+void requestDisplay()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  // Double buffered, only copies the changes for the push on core 0
+  display.display();
+#endif
+  displayDirty = true;
+}
+
+// Display refresh period, shortened while the ECG strip chart runs
+std::atomic<unsigned long> displayRefreshMs(kDisplayRefreshMs);
+
+void setDisplayRefresh(unsigned long periodMs)
+{
+  displayRefreshMs = periodMs;
+  displayTask.setPeriod(periodMs);
+}
+
+void refreshDisplay()
+{
+  if (displayDirty.exchange(false))
+  {
+    uint16_t chunk = i2cBus.displayChunkBytes(kDisplayChunkOverhead);
+    for (uint16_t offset = 0; offset < kDisplayBufferBytes;)
+    {
+      I2CBusLock lock(i2cBus, I2C_PRIORITY_DISPLAY);
+      offset = display.displayChunk(offset, chunk);
+    }
+  }
+}
+
+// Hands a chunk to the transport task. On a full queue the chunk is dropped and counted,
+// unless it has to arrive, then sampling waits for the transport task to make room.
+void queueOutput(const OutputChunk &chunk, bool mustArrive)
+{
+  outputQueued++;
+#if defined(ARDUINO_ARCH_ESP32)
+  while (!outputQueue.push(chunk))
+  {
+    if (!mustArrive)
+    {
+      outputLost++;
+      return;
+    }
+    vTaskDelay(1);
+  }
+#else
+  (void)mustArrive;
+  Serial.write(chunk.bytes, chunk.length);
+#endif
+}
+
+// Text lines are cut at kOutputLineLength characters
+void makeLine(const char *text, OutputChunk &chunk)
+{
+  size_t length = strnlen(text, kOutputLineLength);
+  memcpy(chunk.bytes, text, length);
+  chunk.bytes[length++] = '\r';
+  chunk.bytes[length++] = '\n';
+  chunk.length = length;
+}
+
+// Queues a line for the PC so that serial output never stalls sampling
+void sendLine(const char *text)
+{
+  OutputChunk chunk;
+  makeLine(text, chunk);
+  queueOutput(chunk, false);
+}
+
+// Queues a binary frame for the PC, see frame_protocol.h
+void sendFrame(FrameType type, const uint8_t *payload, size_t length)
+{
+  OutputChunk chunk;
+  chunk.length = frameEncoder.encode(type, payload, length, chunk.bytes);
+  queueOutput(chunk, false);
+}
+
+// Ends the session upload, neither the loss count nor DATA_END may be dropped
+void sendDataEnd()
+{
+  OutputChunk chunk;
+  char line[kOutputLineLength];
+  snprintf(line, sizeof(line), "OUTPUT_LOSS:%lu/%lu", outputLost, outputQueued + 2);
+  makeLine(line, chunk);
+  queueOutput(chunk, true);
+  chunk.length = frameEncoder.encode(FRAME_DATA_END, nullptr, 0, chunk.bytes);
+  queueOutput(chunk, true);
+}
+
+void sendValue(FrameType type, float value)
+{
+  uint8_t payload[sizeof(float)];
+  memcpy(payload, &value, sizeof(float)); // Little endian on the ESP32
+  sendFrame(type, payload, sizeof(payload));
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void IRAM_ATTR onECGTimer()
+{
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(ecgSamplerHandle, &woken);
+  if (woken)
+  {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void startECGTimer()
+{
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  ecgTimer = timerBegin(1000000);
+  timerAttachInterrupt(ecgTimer, onECGTimer);
+  timerAlarm(ecgTimer, ecgSampler.periodUs(), true, 0);
+#else
+  ecgTimer = timerBegin(kEcgTimerId, 80, true); // 80 MHz APB clock / 80 = 1 us ticks
+  timerAttachInterrupt(ecgTimer, onECGTimer, true);
+  timerAlarmWrite(ecgTimer, ecgSampler.periodUs(), true);
+  timerAlarmEnable(ecgTimer);
+#endif
+}
+
+void ecgSamplerTask(void *)
+{
+  for (;;)
+  {
+    // The ADC driver is not ISR safe, the timer interrupt only wakes this task
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (ecgSampling)
+    {
+      sampleECG();
+    }
+  }
+}
+
+void IRAM_ATTR onSpO2Interrupt()
+{
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(spo2ReaderHandle, &woken);
+  if (woken)
+  {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void spo2ReaderTask(void *)
+{
+  MAX30105Sample samples[32];
+  for (;;)
+  {
+    // I2C is not ISR safe, the almost full interrupt only wakes this task
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kSpO2ReaderTimeoutMs));
+    // Pushed under the lock so that startSPO2() never sees samples from before clearFIFO()
+    I2CBusLock lock(i2cBus);
+    // Release the INT line before draining, so that the next almost full is a new falling edge
+    sensor.clearInterrupts();
+    size_t count = sensor.readSamples(samples, 32);
+    for (size_t i = 0; i < count; i++)
+    {
+      spo2Queue.push(samples[i]);
+    }
+  }
+}
+
+void transportTask(void *)
+{
+  OutputChunk chunk;
+  unsigned long lastRefresh = 0;
+  for (;;)
+  {
+    while (outputQueue.pop(chunk))
+    {
+      Serial.write(chunk.bytes, chunk.length);
+    }
+    if (millis() - lastRefresh >= displayRefreshMs)
+    {
+      lastRefresh = millis();
+      refreshDisplay();
+    }
+    vTaskDelay(pdMS_TO_TICKS(kTransportPeriodMs));
+  }
+}
+#endif
+
+void setECGSampling(bool enabled)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  ecgSampling = enabled;
+#else
+  if (enabled) {
+    ecgSampler.start();
+    ecgTask.start(scheduler.now());
+  } else {
+    ecgTask.stop();
+  }
+#endif
+}
+
+void pollSerial()
+{
+  while (!serialLineReady && Serial.available())
+  {
+    char c = Serial.read();
+    if (c == '\n')
+    {
+      serialLine.trim();
+      serialLineReady = true;
+    }
+    else
+    {
+      serialLine += c;
+    }
+  }
+}
+
+bool readSerialLine(String &line)
+{
+  if (!serialLineReady)
+  {
+    return false;
+  }
+  line = serialLine;
+  serialLine = "";
+  serialLineReady = false;
+  return true;
+}
+
+void showMessage(String msg, unsigned long delayTime = 0)
 {
   display.clearDisplay();
   display.setCursor(0, 0);
   display.println(msg);
-  display.display();
   if (delayTime > 0) {
+    display.display();
     delay(delayTime);
+  } else {
+    requestDisplay();
+  }
+}
+
+// Keeps the current screen for kResultHoldMs, then continues with next
+void holdResult(SensorState next)
+{
+  resultNextState = next;
+  scheduler.transition(RESULT);
+}
+
+void tickResult()
+{
+  if (scheduler.elapsed() >= kResultHoldMs)
+  {
+    scheduler.transition(resultNextState);
   }
 }
 
 void setup()
 {
   delay(BOOT_DELAY);
+  i2cBus.begin();
   Serial.begin(115200);
   Wire.begin();
   while (!Serial);
@@ -104,9 +525,15 @@ void setup()
     showMessage("MLX90614 Error!", 3000);
     while (1) { delay(100); }
   }
+  // Reading faster than the sensor refreshes its RAM only returns the same values again
+  tempTask.setPeriod(mlx.getUpdatePeriod());
 
   // MAX30102 Initialization (Daniel Wiese's library)
-  if (sensor.begin() && sensor.setSamplingRate(kSamplingRate))
+  if (sensor.begin() && sensor.setSamplingRate(kSamplingRate) &&
+      sensor.setFIFOAlmostFull(kSpO2AlmostFull) && sensor.enableInterrupt(sensor.INT_A_FULL) &&
+      gainControl.apply() &&
+      (!kGreenPPG || (sensor.setMultiLedConfiguration(GreenPPGSlots::configuration()) &&
+                      sensor.setMode(MAX30105::MODE_MULTI_LED))))
   {
     Serial.println("Sensor initialized");
   }
@@ -127,11 +554,40 @@ void setup()
   display.println("System Ready");
   display.println("Awaiting Data...");
   display.display();
-  currentState = WAIT_PATIENT;
-  stateStartTime = millis();
+
+  scheduler.addTask(serialTask);
+  scheduler.addTask(weightTask);
+  scheduler.addTask(tempTask);
+  scheduler.addTask(statusTask);
+  serialTask.start(millis());
+#if defined(ARDUINO_ARCH_ESP32)
+  xTaskCreatePinnedToCore(ecgSamplerTask, "ecg", 2048, nullptr, kEcgSamplerPriority, &ecgSamplerHandle, kAcquisitionCore);
+  startECGTimer();
+  xTaskCreatePinnedToCore(spo2ReaderTask, "spo2", 3072, nullptr, kSpO2ReaderPriority, &spo2ReaderHandle, kAcquisitionCore);
+  pinMode(MAX30102_INT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(MAX30102_INT_PIN), onSpO2Interrupt, FALLING);
+  // The power ready flag holds INT low from power-up on, no edge would ever come
+  {
+    I2CBusLock lock(i2cBus);
+    sensor.clearInterrupts();
+  }
+  // Core 1 draws into the back buffer while the transport task pushes the front buffer
+  if (!display.setDoubleBuffer(true))
+  {
+    Serial.println("OLED allocation failed");
+    while (1) { delay(100); }
+  }
+  xTaskCreatePinnedToCore(transportTask, "transport", 4096, nullptr, kTransportPriority, nullptr, kTransportCore);
+#else
+  scheduler.addTask(displayTask);
+  scheduler.addTask(ecgTask);
+  displayTask.start(millis());
+#endif
+  scheduler.begin(WAIT_PATIENT);
 }
 
 LowPassFilter low_pass_filter_red(kLowPassCutoff, kSamplingFrequency);
+LowPassFilter low_pass_filter_green(kLowPassCutoff, kSamplingFrequency);
 LowPassFilter low_pass_filter_ir(kLowPassCutoff, kSamplingFrequency);
 HighPassFilter high_pass_filter(kHighPassCutoff, kSamplingFrequency);
 Differentiator differentiator(kSamplingFrequency);
@@ -139,9 +595,11 @@ MovingAverageFilter<kAveragingSamples> averager_bpm;
 MovingAverageFilter<kAveragingSamples> averager_r;
 MovingAverageFilter<kAveragingSamples> averager_spo2;
 
-// Statistic for pulse oximetry
-MinMaxAvgStatistic stat_red;
-MinMaxAvgStatistic stat_ir;
+// Statistic for pulse oximetry, a sliding window over the last few beats
+// (2.5 s covers two to three beats at rest)
+const int kPerfusionWindowSamples = 1000;
+SlidingMinMaxAvgStatistic<kPerfusionWindowSamples> stat_red;
+SlidingMinMaxAvgStatistic<kPerfusionWindowSamples> stat_ir;
 
 // R value to SpO2 calibration factors
 // See https://www.maximintegrated.com/en/design/technical-documents/app-notes/6/6845.html
@@ -161,70 +619,135 @@ float last_diff = NAN;
 bool crossed = false;
 long crossed_time = 0;
 
-unsigned long spo2StartTime = 0;
+// Sample sequence of the SpO2 measurement, gaps come from FIFO overflows
+// or a full reader queue and are reported as lost samples
+uint32_t spo2NextSequence = 0;
+unsigned long spo2Lost = 0;
 
-void handleWaitPatient()
+void enterWaitPatient()
 {
-  showMessage("Enter patient ID\nand Name via PC", 0);
-  if (Serial.available())
+  showMessage("Enter patient ID\nand Name via PC");
+}
+
+void tickWaitPatient()
+{
+  String line;
+  if (!readSerialLine(line) || line == "")
   {
-    if (patientID == "")
-    {
-      patientID = Serial.readStringUntil('\n');
-      patientID.trim();
-    }
-    else if (patientName == "")
-    {
-      patientName = Serial.readStringUntil('\n');
-      patientName.trim();
-    }
+    return;
+  }
+
+  if (patientID == "")
+  {
+    patientID = line;
+  }
+  else if (patientName == "")
+  {
+    patientName = line;
+  }
 
-    if (patientID != "" && patientName != "")
+  if (patientID != "" && patientName != "")
+  {
+    outputQueued = 0;
+    outputLost = 0;
+    sendLine("PATIENT_RECEIVED");
+    scheduler.transition(kConcurrentAcquisition ? ACQUIRE : WEIGHT);
+  }
+}
+
+unsigned long weightStableMs = 0;
+
+void sampleWeight()
+{
+  if (scale.is_continuous())
+  {
+    // The DOUT interrupt took the readings already
+    long raw;
+    while (scale.pop(raw))
     {
-      Serial.println("PATIENT_RECEIVED");
-      showMessage("Patient Data Received.\nStarting Vitals...", 2000);
-      currentState = WEIGHT;
-      stateStartTime = millis();
+      weightBuffer.push((raw - scale.get_offset()) / scale.get_scale());
     }
+    return;
+  }
+
+  // Only read when a conversion is ready so the loop never blocks on the HX711
+  if (scale.is_ready())
+  {
+    weightBuffer.push(scale.get_units(1));
   }
 }
 
-void handleWeight()
+void startWeight()
 {
-  showMessage("Weight meas in 2 sec...", 2000);
-  delay(2000);
-  showMessage("Measuring....", 0);
-  unsigned long startTime = millis();
-  float weightSum = 0;
-  int count = 0;
+  weightSettling.reset();
+  weightDespike.reset();
+  weightBuffer.reset();
+  // Polls is_ready() instead if DOUT has no interrupt
+  scale.start_continuous();
+  weightTask.start(scheduler.now());
+}
 
-  while (millis() - startTime < 5000)
+void consumeWeight()
+{
+  float weight;
+  while (weightBuffer.pop(weight))
   {
-    if (scale.is_ready())
+    if (!weightSettling.settled() && weightSettling.process(weightDespike.process(weight)))
     {
-      weightSum += scale.get_units(5);
-      count++;
+      weightStableMs = scheduler.elapsed();
     }
-    delay(100);
+  }
+}
+
+bool weightComplete()
+{
+  return weightSettling.settled() || scheduler.elapsed() >= kWeightTimeoutMs;
+}
+
+float finishWeight()
+{
+  weightTask.stop();
+  scale.stop_continuous();
+  float weight = weightSettling.value();
+
+  char line[kOutputLineLength];
+  if (weightSettling.settled())
+  {
+    snprintf(line, sizeof(line), "WEIGHT_STABLE_MS:%lu", weightStableMs);
+  }
+  else
+  {
+    snprintf(line, sizeof(line), "WEIGHT_UNSTABLE");
+  }
+  sendLine(line);
+  sendValue(FRAME_WEIGHT, weight);
+  return weight;
+}
+
+void enterWeight()
+{
+  showMessage("Patient Data Received.\nWeight meas...");
+  startWeight();
+}
+
+void tickWeight()
+{
+  consumeWeight();
+  if (!weightComplete())
+  {
+    return;
   }
 
-  float avgWeight = count > 0 ? weightSum / count : 0;
-  avgWeight *= 240;
+  float weight = finishWeight();
   display.clearDisplay();
   display.setCursor(0, 0);
   display.setTextSize(2);
   display.print("Weight:");
   display.setCursor(0, 30);
-  display.print(-avgWeight/1000, 2);
+  display.print(weight, 2);
   display.print(" g");
-  display.display();
-  delay(3000);
-
-  Serial.print("WEIGHT:");
-  Serial.println(-avgWeight/1000, 2);
-  showMessage("Weight recorded.\nNext: SpO2 in 2 sec", 2000);
-  currentState = SPO2;
-  stateStartTime = millis();
+  requestDisplay();
+  holdResult(SPO2);
 }
 
 void initDrawScreen(void)
@@ -238,11 +761,17 @@ void initDrawScreen(void)
   display.setCursor(5, display.getCursorY());
   display.setTextSize(2);
   display.println(F("BPM  %SpO2"));
-  display.display();
+  requestDisplay();
 }
 bool display_reset = true;
 void displayMeasuredValues(bool no_finger, int32_t beatAvg, int32_t spo2)
 {
+  // The concurrent screen shows its own summary
+  if (scheduler.state() == ACQUIRE)
+  {
+    return;
+  }
+
   display.setCursor(5, 35);
   display.setTextColor(WHITE, BLACK);
   if (no_finger)
@@ -250,14 +779,14 @@ void displayMeasuredValues(bool no_finger, int32_t beatAvg, int32_t spo2)
     display.setTextSize(2);
     display.println(F("NO Finger            "));
     display_reset = true;
-    display.display();
+    requestDisplay();
   }
   else if (beatAvg < 30 && display_reset)
   {
     display.setTextSize(2);
     display.println(F("Pls.  Wait             "));
     display_reset = false;
-    display.display();
+    requestDisplay();
   }
   else if (beatAvg >= 30)
   {
@@ -279,7 +808,7 @@ void displayMeasuredValues(bool no_finger, int32_t beatAvg, int32_t spo2)
       display.print(F("--"));
     }
     display.println(F("    "));
-    display.display();
+    requestDisplay();
   }
 }
 
@@ -287,212 +816,439 @@ int average_bpm;
 int average_r;
 int average_spo2;
 
-void handleSPO2()
+unsigned long spo2DrainTime;
+
+void startSPO2()
 {
-  if (spo2StartTime == 0)
+  average_bpm = 0;
+  average_spo2 = 0;
+  spo2DrainTime = scheduler.now();
+  spo2NextSequence = 0;
+  spo2Lost = 0;
+  last_heartbeat = 0;
+  I2CBusLock lock(i2cBus);
+  sensor.clearFIFO();
+#if defined(ARDUINO_ARCH_ESP32)
+  spo2Queue.clear();
+#endif
+}
+
+void enterSPO2()
+{
+  display.clearDisplay();
+  initDrawScreen();
+  startSPO2();
+}
+
+void processSPO2Sample(const MAX30105Sample &sample)
+{
+  float current_value_red = sample.red;
+  float current_value_ir = sample.ir;
+
+  if (sample.sequence != spo2NextSequence)
   {
-    spo2StartTime = millis();
-    display.clearDisplay();
-    initDrawScreen();
+    // Samples are missing, do not detect an edge across the gap
+    spo2Lost += sample.sequence - spo2NextSequence;
+    last_diff = NAN;
+    crossed = false;
   }
+  spo2NextSequence = sample.sequence + 1;
 
-  // 20-second measurement window
-  while (millis() - spo2StartTime < 20000)
-  {
-    auto sample = sensor.readSample(1000);
-    float current_value_red = sample.red;
-    float current_value_ir = sample.ir;
+  // Time of the sample from its index, bursts and gaps do not distort the beat intervals
+  long sample_time = (long)(sample.sequence * (1000.0f / kSamplingFrequency));
 
-    // Original finger detection and processing logic
-    if (sample.red > kFingerThreshold)
+  if (gainControl.process(sample.red, sample.ir))
+  {
     {
-      if (millis() - finger_timestamp > kFingerCooldownMs)
-      {
-        finger_detected = true;
-      }
+      I2CBusLock lock(i2cBus);
+      gainControl.apply();
     }
-    else
+    // The DC level jumps, start the filters and the perfusion window over
+    low_pass_filter_red.reset();
+    low_pass_filter_green.reset();
+    low_pass_filter_ir.reset();
+    high_pass_filter.reset();
+    differentiator.reset();
+    stat_red.reset();
+    stat_ir.reset();
+    last_diff = NAN;
+    crossed = false;
+  }
+
+  // Original finger detection and processing logic
+  if (sample.red > kFingerThreshold)
+  {
+    if (scheduler.now() - finger_timestamp > kFingerCooldownMs)
     {
-      differentiator.reset();
-      averager_bpm.reset();
-      averager_r.reset();
-      averager_spo2.reset();
-      low_pass_filter_red.reset();
-      low_pass_filter_ir.reset();
-      high_pass_filter.reset();
-      stat_red.reset();
-      stat_ir.reset();
-      finger_detected = false;
-      finger_timestamp = millis();
+      finger_detected = true;
     }
+  }
+  else
+  {
+    differentiator.reset();
+    averager_bpm.reset();
+    averager_r.reset();
+    averager_spo2.reset();
+    low_pass_filter_red.reset();
+    low_pass_filter_green.reset();
+    low_pass_filter_ir.reset();
+    high_pass_filter.reset();
+    stat_red.reset();
+    stat_ir.reset();
+    finger_detected = false;
+    finger_timestamp = scheduler.now();
+  }
 
-    if (finger_detected)
-    {
-      displayMeasuredValues(false, 0, 0);
-      current_value_red = low_pass_filter_red.process(current_value_red);
-      current_value_ir = low_pass_filter_ir.process(current_value_ir);
-      stat_red.process(current_value_red);
-      stat_ir.process(current_value_ir);
+  if (finger_detected)
+  {
+    displayMeasuredValues(false, 0, 0);
+    current_value_red = low_pass_filter_red.process(current_value_red);
+    current_value_ir = low_pass_filter_ir.process(current_value_ir);
+    stat_red.process(current_value_red);
+    stat_ir.process(current_value_ir);
 
-      float current_value = high_pass_filter.process(current_value_red);
-      float current_diff = differentiator.process(current_value);
+    float current_value_pulse = kGreenPPG ? low_pass_filter_green.process(sample.slot[2]) : current_value_red;
+    float current_value = high_pass_filter.process(current_value_pulse);
+    float current_diff = differentiator.process(current_value);
 
-      if (!isnan(current_diff) && !isnan(last_diff))
+    if (!isnan(current_diff) && !isnan(last_diff))
+    {
+      if (last_diff > 0 && current_diff < 0)
       {
-        if (last_diff > 0 && current_diff < 0)
-        {
-          crossed = true;
-          crossed_time = millis();
-        }
-        if (current_diff > 0)
-          crossed = false;
+        crossed = true;
+        crossed_time = sample_time;
+      }
+      if (current_diff > 0)
+        crossed = false;
 
-        if (crossed && current_diff < kEdgeThreshold)
+      if (crossed && current_diff < kEdgeThreshold)
+      {
+        if (last_heartbeat != 0 && crossed_time - last_heartbeat > 300)
         {
-          if (last_heartbeat != 0 && crossed_time - last_heartbeat > 300)
-          {
-            int bpm = 60000 / (crossed_time - last_heartbeat);
-            float rred = (stat_red.maximum() - stat_red.minimum()) / stat_red.average();
-            float rir = (stat_ir.maximum() - stat_ir.minimum()) / stat_ir.average();
-            float r = rred / rir;
-            float spo2 = kSpO2_A * r * r + kSpO2_B * r + kSpO2_C;
+          int bpm = 60000 / (crossed_time - last_heartbeat);
+          float rred = (stat_red.maximum() - stat_red.minimum()) / stat_red.average();
+          float rir = (stat_ir.maximum() - stat_ir.minimum()) / stat_ir.average();
+          float r = rred / rir;
+          float spo2 = kSpO2_A * r * r + kSpO2_B * r + kSpO2_C;
 
-            if (bpm > 50 && bpm < 250)
+          if (bpm > 50 && bpm < 250)
+          {
+            if (kEnableAveraging)
             {
-              if (kEnableAveraging)
-              {
-                average_bpm = averager_bpm.process(bpm);
-                average_r = averager_r.process(r);
-                average_spo2 = averager_spo2.process(spo2);
-                if (averager_bpm.count() >= kSampleThreshold)
-                {
-                  displayMeasuredValues(false, average_bpm, average_spo2);
-                }
-              }
-              else
+              average_bpm = averager_bpm.process(bpm);
+              average_r = averager_r.process(r);
+              average_spo2 = averager_spo2.process(spo2);
+              if (averager_bpm.count() >= kSampleThreshold)
               {
-                displayMeasuredValues(false, bpm, spo2);
+                displayMeasuredValues(false, average_bpm, average_spo2);
               }
             }
-            stat_red.reset();
-            stat_ir.reset();
+            else
+            {
+              displayMeasuredValues(false, bpm, spo2);
+            }
           }
-          crossed = false;
-          last_heartbeat = crossed_time;
         }
+        crossed = false;
+        last_heartbeat = crossed_time;
       }
-      last_diff = current_diff;
-    } else {
-      displayMeasuredValues(true, 0, 0);
     }
+    last_diff = current_diff;
+  } else {
+    displayMeasuredValues(true, 0, 0);
+  }
+}
+
+void consumeSPO2()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  // Drained by spo2ReaderTask
+  MAX30105Sample sample;
+  while (spo2Queue.pop(sample))
+  {
+    processSPO2Sample(sample);
+  }
+#else
+  // Let samples accumulate so that the FIFO is drained in a few burst reads
+  if (scheduler.now() - spo2DrainTime < kSpO2DrainMs)
+  {
+    return;
+  }
+  spo2DrainTime = scheduler.now();
+
+  MAX30105Sample samples[32];
+  size_t count;
+  {
+    I2CBusLock lock(i2cBus);
+    count = sensor.readSamples(samples, 32);
+  }
+  for (size_t i = 0; i < count; i++)
+  {
+    processSPO2Sample(samples[i]);
+  }
+#endif
+}
+
+bool spo2Complete()
+{
+  // Enough averaged beats or out of time
+  if (kEnableAveraging && averager_bpm.count() >= kSampleThreshold)
+  {
+    return true;
   }
+  return scheduler.elapsed() >= kSpO2WindowMs;
+}
 
-  // After 20 seconds, finalize and move to next state
-  Serial.print("SPO2:");
+void finishSPO2()
+{
   if(average_spo2 > 99) {average_spo2 = 99;}
-  Serial.println(average_spo2, 1);
-  Serial.print("PULSE:");
-  Serial.println(average_bpm);
+  sendValue(FRAME_SPO2, average_spo2);
+  sendValue(FRAME_PULSE, average_bpm);
+
+  char line[kOutputLineLength];
+  snprintf(line, sizeof(line), "SPO2_LOSS:%lu/%lu", spo2Lost, (unsigned long)spo2NextSequence);
+  sendLine(line);
+}
+
+void tickSPO2()
+{
+  consumeSPO2();
+  if (!spo2Complete())
+  {
+    return;
+  }
+
+  finishSPO2();
   displayMeasuredValues(true, average_bpm, average_spo2);
-  currentState = TEMP;
-  spo2StartTime = 0;
-  stateStartTime = millis();
+  scheduler.transition(TEMP);
 }
 
-void handleTemperature()
+int tempCount = 0;
+float tempLast = NAN;
+unsigned long tempPredictedMs = 0;
+uint32_t tempPecErrorsAtStart = 0;
+
+void sampleTemperature()
+{
+  I2CBusLock lock(i2cBus);
+  // tempTask already runs once per sensor update, and the ambient temperature is
+  // never used, so one PEC checked word of TOBJ1 per update is enough
+  float celsius = mlx.readObjectTempC();
+  if (!isnan(celsius))
+  {
+    TempReading reading = { scheduler.elapsed(), celsius };
+    tempBuffer.push(reading);
+  }
+}
+
+void startTemperature()
+{
+  tempCount = 0;
+  tempLast = NAN;
+  tempPrediction.reset();
+  tempDespike.reset();
+  tempBuffer.reset();
+  tempPecErrorsAtStart = mlx.getPECErrors();
+  tempTask.start(scheduler.now());
+}
+
+void consumeTemperature()
+{
+  TempReading reading;
+  while (tempBuffer.pop(reading))
+  {
+    float tempC = tempDespike.process(reading.celsius);
+    tempCount++;
+    tempLast = tempC;
+    if (!tempPrediction.settled() && tempPrediction.process(reading.ms / 1000.0f, tempC))
+    {
+      tempPredictedMs = scheduler.elapsed();
+    }
+  }
+}
+
+bool temperatureComplete()
+{
+  return tempPrediction.settled() || scheduler.elapsed() >= kTempWindowMs;
+}
+
+float finishTemperature()
+{
+  tempTask.stop();
+  float tempC = tempPrediction.value();
+
+  char line[kOutputLineLength];
+  if (tempPrediction.settled())
+  {
+    snprintf(line, sizeof(line), "TEMP_PREDICTED_MS:%lu", tempPredictedMs);
+  }
+  else
+  {
+    snprintf(line, sizeof(line), "TEMP_UNSETTLED");
+    // Never pointed at a forehead, report what the sensor saw
+    if (tempC == 0 && !isnan(tempLast))
+    {
+      tempC = tempLast;
+    }
+  }
+  sendLine(line);
+  snprintf(line, sizeof(line), "TEMP_PEC_ERRORS:%lu", (unsigned long)(mlx.getPECErrors() - tempPecErrorsAtStart));
+  sendLine(line);
+  sendValue(FRAME_TEMP, tempC);
+  return tempC;
+}
+
+void enterTemperature()
 {
   display.setTextSize(2);
-  showMessage("Temp sense in 2 sec", 2000);
-  delay(2000);
   showMessage("Sensing Temp: ");
-  delay(1000);
-
-  unsigned long startTime = millis();
-  float tempSum = 0;
-  int count = 0;
+  startTemperature();
+}
 
-  while (millis() - startTime < 10000)
+void tickTemperature()
+{
+  int before = tempCount;
+  consumeTemperature();
+  if (tempCount != before)
   {
-    float tempC = mlx.readObjectTempC();
     display.clearDisplay();
     display.setCursor(0, 0);
     display.setTextSize(2);
     display.print("Temp:");
     display.setCursor(0, 30);
-    display.print(tempC, 1);
+    display.print(tempLast, 1);
     display.print(" C");
-    display.display();
-    tempSum += tempC;
-    count++;
-    delay(50);
+    requestDisplay();
   }
 
-  float avgTemp = count > 0 ? tempSum / count : 0;
+  if (!temperatureComplete())
+  {
+    return;
+  }
 
+  float tempC = finishTemperature();
   display.clearDisplay();
   display.setCursor(0, 0);
   display.setTextSize(2);
   display.print("Final Temp:");
   display.setCursor(0, 30);
-  display.print(avgTemp, 1);
+  display.print(tempC, 1);
   display.print(" C");
-  display.display();
-  delay(2000);
+  requestDisplay();
+  holdResult(ECG);
+}
 
-  Serial.print("TEMP:");
-  Serial.println(avgTemp, 1);
-  showMessage("Temp recorded.\nNext: ECG in 2 sec", 2000);
-  currentState = ECG;
-  stateStartTime = millis();
+int readECGAdc(uint8_t pin)
+{
+  return analogRead(pin) / 4;
 }
 
-void handleECG()
+void sampleECG()
 {
-  showMessage("ECG meas in 2 sec...", 2000);
-  delay(2000);
+  ecgSampler.sample();
+}
 
-  display.clearDisplay();
-  display.setCursor(0, 0);
-  display.println("Recording ECG");
-  display.display();
+void pollECG()
+{
+  ecgSampler.poll();
+}
+
+// Samples of the recording so far and the sampler's drop count when it started
+unsigned long ecgConsumed = 0;
+unsigned long ecgDroppedAtStart = 0;
 
-  Serial.println("ECG_START");
-  ecgData = "";
-  unsigned long startTime = millis();
+void startECG()
+{
+  uint16_t rate = ecgSampler.rate();
+  uint8_t payload[sizeof(rate)] = { (uint8_t)(rate & 0xFF), (uint8_t)(rate >> 8) };
+  sendFrame(FRAME_ECG_START, payload, sizeof(payload));
+  ecgPacker.reset();
+  ecgSampler.clear();
+  ecgConsumed = 0;
+  ecgDroppedAtStart = ecgSampler.dropped();
+  setECGSampling(true);
+}
 
-  while (millis() - startTime < 30000)
+void sendECGFrame()
+{
+  sendFrame(FRAME_ECG_SAMPLES, ecgPacker.payload(), ecgPacker.length());
+  ecgPacker.clear();
+}
+
+void consumeECG()
+{
+  // Only the ECG screen shows the strip chart
+  bool plot = scheduler.state() == ECG;
+  bool plotted = false;
+  EcgSample sample;
+  while (ecgSampler.read(sample))
+  {
+    ecgConsumed++;
+    if (ecgPacker.add(sample.value))
+    {
+      sendECGFrame();
+    }
+    if (plot && ecgChart.add(sample.value))
+    {
+      plotted = true;
+    }
+  }
+  if (plotted)
   {
-    int ecgValue = analogRead(ECG_PIN) / 4;
-    Serial.println(ecgValue);
-    ecgData += String(ecgValue) + ",";
-    delay(20);
+    requestDisplay();
   }
+}
 
-  if (ecgData.endsWith(","))
+bool ecgComplete()
+{
+  return scheduler.elapsed() >= kEcgWindowMs;
+}
+
+void finishECG()
+{
+  setECGSampling(false);
+  consumeECG();
+  if (!ecgPacker.empty())
   {
-    ecgData.remove(ecgData.length() - 1);
+    sendECGFrame();
   }
 
-  Serial.println("DATA_END");
+  unsigned long lost = ecgSampler.dropped() - ecgDroppedAtStart;
+  char line[kOutputLineLength];
+  snprintf(line, sizeof(line), "ECG_LOSS:%lu/%lu", lost, ecgConsumed + lost);
+  sendLine(line);
+}
 
-  // Wait for PC confirmation
-  bool uploadConfirmed = false;
-  unsigned long waitStart = millis();
-  while (millis() - waitStart < 30000) { // 30-second timeout
-    if (Serial.available()) {
-      String response = Serial.readStringUntil('\n');
-      response.trim();
-      response.trim();
-      Serial.print("Received: "); // Debug statement
-      Serial.println(response);   // Debug statement
-      if (response == "DATA_UPLOADED") {
-        uploadConfirmed = true;
-        break;
-      }
-    }
-    delay(100);
+void enterECG()
+{
+  display.clearDisplay();
+  display.setCursor(0, 0);
+  display.setTextSize(1);
+  display.println("Recording ECG");
+  ecgChart.begin();
+  requestDisplay();
+  setDisplayRefresh(kEcgDisplayRefreshMs);
+  startECG();
+}
+
+void tickECG()
+{
+  consumeECG();
+  if (ecgComplete())
+  {
+    finishECG();
+    sendDataEnd();
+    scheduler.transition(UPLOAD);
   }
+}
+
+void exitECG()
+{
+  setDisplayRefresh(kDisplayRefreshMs);
+}
 
+void showUploadStatus(bool uploadConfirmed)
+{
   display.clearDisplay();
   display.setCursor(0, 0);
   display.setTextSize(1);
@@ -504,33 +1260,139 @@ void handleECG()
     display.println("Upload failed!");
     display.println("Check connection");
   }
-  display.display();
-  currentState = IDLE;
+  requestDisplay();
+}
+
+void tickUpload()
+{
+  // Wait for PC confirmation
+  String response;
+  if (readSerialLine(response))
+  {
+    sendLine(("Received: " + response).c_str()); // Debug statement
+    if (response == "DATA_UPLOADED") {
+      showUploadStatus(true);
+      scheduler.transition(IDLE);
+    }
+  }
+  else if (scheduler.elapsed() >= kUploadTimeoutMs)
+  {
+    showUploadStatus(false);
+    scheduler.transition(IDLE);
+  }
+}
+
+bool weightDone = false;
+bool spo2Done = false;
+bool tempDone = false;
+bool ecgDone = false;
+float weightResult = 0;
+float tempResult = 0;
+
+void drawAcquireStatus()
+{
+  display.clearDisplay();
+  display.setTextSize(1);
+  display.setCursor(0, 0);
+  display.println("Measuring all...");
+  display.println();
+
+  display.print("Weight: ");
+  if (weightDone) {
+    display.print(weightResult, 2);
+    display.println(" g");
+  } else {
+    display.println("...");
+  }
+
+  display.print("SpO2: ");
+  if (spo2Done) {
+    display.print(average_spo2);
+    display.print("% ");
+    display.print(average_bpm);
+    display.println(" bpm");
+  } else {
+    display.println(finger_detected ? "..." : "NO Finger");
+  }
+
+  display.print("Temp: ");
+  if (tempDone) {
+    display.print(tempResult, 1);
+    display.println(" C");
+  } else if (!isnan(tempLast)) {
+    display.print(tempLast, 1);
+    display.println(" C ...");
+  } else {
+    display.println("...");
+  }
+
+  display.print("ECG: ");
+  display.print(min(scheduler.elapsed(), kEcgWindowMs) / 1000);
+  display.print("/");
+  display.print(kEcgWindowMs / 1000);
+  display.println(" s");
+  requestDisplay();
+}
+
+void enterAcquire()
+{
+  weightDone = false;
+  spo2Done = false;
+  tempDone = false;
+  ecgDone = false;
+
+  startWeight();
+  startSPO2();
+  startTemperature();
+  startECG();
+  statusTask.start(scheduler.now());
+}
+
+void tickAcquire()
+{
+  consumeWeight();
+  if (!spo2Done)
+  {
+    consumeSPO2();
+  }
+  consumeTemperature();
+  consumeECG();
+
+  if (!weightDone && weightComplete())
+  {
+    weightResult = finishWeight();
+    weightDone = true;
+  }
+  if (!spo2Done && spo2Complete())
+  {
+    finishSPO2();
+    spo2Done = true;
+  }
+  if (!tempDone && temperatureComplete())
+  {
+    tempResult = finishTemperature();
+    tempDone = true;
+  }
+  if (!ecgDone && ecgComplete())
+  {
+    finishECG();
+    ecgDone = true;
+  }
+
+  if (weightDone && spo2Done && tempDone && ecgDone)
+  {
+    sendDataEnd();
+    scheduler.transition(UPLOAD);
+  }
+}
+
+void exitAcquire()
+{
+  statusTask.stop();
+  drawAcquireStatus();
 }
 
 void loop()
 {
-  switch (currentState)
-  {
-  case WAIT_PATIENT:
-    handleWaitPatient();
-    break;
-  case WEIGHT:
-    handleWeight();
-    break;
-  case SPO2:
-    handleSPO2();
-    break;
-  case TEMP:
-    handleTemperature();
-    break;
-  case ECG:
-    handleECG();
-    break;
-  case IDLE:
-    while (true);
-    break;
-  default:
-    break;
-  }
-}
\ No newline at end of file
+  scheduler.tick();
+}
@@ -0,0 +1,138 @@
+#ifndef ECG_SAMPLER_H
+#define ECG_SAMPLER_H
+
+#include <stdint.h>
+#include "spsc_queue.h"
+
+/**
+ * @brief Timestamped ECG sample
+ */
+struct EcgSample {
+  uint32_t timestamp; //!< Capture time in us
+  int16_t value;      //!< ADC value
+};
+
+/**
+ * @brief Fixed-rate ECG sampler
+ * @tparam kQueueSize Number of samples buffered between sampler and consumer, must be a power of two
+ * @remark sample() is meant to be triggered by a hardware timer (or a simulated one on a host).
+ * Without a timer, start() and poll() from the main loop pace the samples on the microsecond
+ * clock instead. The ADC and the clock are injected so that the rate can be checked without
+ * hardware.
+ */
+template<size_t kQueueSize> class EcgSampler {
+public:
+  typedef int (*AdcSource)(uint8_t pin);      //!< ADC read function
+  typedef unsigned long (*MicrosSource)();    //!< Microsecond clock
+private:
+  const AdcSource adc_;
+  const MicrosSource clock_;
+  const uint8_t pin_;
+  const uint32_t rate_;
+  SpscQueue<EcgSample, kQueueSize> queue_;
+  uint32_t start_us_;
+  uint32_t taken_;
+public:
+  /**
+   * @brief Initialize the sampler
+   * @param adc ADC read function
+   * @param clock Microsecond clock
+   * @param pin ADC pin
+   * @param rate Sampling rate in Hz
+   */
+  EcgSampler(AdcSource adc, MicrosSource clock, uint8_t pin, uint32_t rate) :
+    adc_(adc),
+    clock_(clock),
+    pin_(pin),
+    rate_(rate),
+    start_us_(0),
+    taken_(0){}
+
+  /**
+   * @brief Get the sampling rate
+   * @return Sampling rate in Hz
+   */
+  uint32_t rate() const {
+    return rate_;
+  }
+
+  /**
+   * @brief Get the sampling period
+   * @return Sampling period in us
+   */
+  uint32_t periodUs() const {
+    return 1000000UL / rate_;
+  }
+
+  /**
+   * @brief Take one sample (producer side)
+   * @remark Called once per timer period
+   */
+  void sample() {
+    EcgSample sample;
+    sample.timestamp = clock_();
+    sample.value = adc_(pin_);
+    queue_.push(sample);
+  }
+
+  /**
+   * @brief Start pacing samples for poll()
+   */
+  void start() {
+    start_us_ = clock_();
+    taken_ = 0;
+  }
+
+  /**
+   * @brief Take a sample if one is due (producer side)
+   * @return true if a sample was taken, otherwise false
+   * @remark The due times are start + n / rate exactly, so the rate does not suffer from a
+   * period rounded to whole microseconds or milliseconds. A late sample keeps the grid
+   * unless it fell behind by more than a period, then the grid restarts at the late one.
+   */
+  bool poll() {
+    uint32_t now = clock_();
+    uint32_t due = start_us_ + (uint32_t)((uint64_t)taken_ * 1000000UL / rate_);
+    int32_t late = (int32_t)(now - due);
+    if(late < 0) return false;
+
+    if((uint32_t)late >= periodUs()) {
+      start_us_ = now;
+      taken_ = 0;
+    }
+    taken_++;
+    // Keep the product in range, the grid is the same after a whole second
+    if(taken_ == rate_) {
+      start_us_ += 1000000UL;
+      taken_ = 0;
+    }
+    sample();
+    return true;
+  }
+
+  /**
+   * @brief Get the oldest buffered sample (consumer side)
+   * @param sample Reference to store the sample in
+   * @return true if a sample was available, otherwise false
+   */
+  bool read(EcgSample& sample) {
+    return queue_.pop(sample);
+  }
+
+  /**
+   * @brief Discard all buffered samples (consumer side)
+   */
+  void clear() {
+    queue_.clear();
+  }
+
+  /**
+   * @brief Get number of samples dropped because the consumer fell behind
+   * @return Number of dropped samples
+   */
+  unsigned long dropped() const {
+    return queue_.dropped();
+  }
+};
+
+#endif // ECG_SAMPLER_H
@@ -1,6 +1,9 @@
 #ifndef FILTERS_H
 #define FILTERS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /**
  * @brief Statistic block for min/nax/avg
  */
@@ -64,6 +67,573 @@ public:
  }
 };
 
+/**
+ * @brief Sliding window statistic block for min/max/avg
+ * @tparam kCapacity Window length in samples
+ * @remark Unlike MinMaxAvgStatistic the oldest sample leaves the window when a
+ * new one arrives, so no reset is needed between beats. Minimum and maximum are
+ * tracked with monotonic queues, every update is amortized O(1).
+ */
+template<int kCapacity> class SlidingMinMaxAvgStatistic {
+ static_assert(kCapacity > 0 && kCapacity <= 65535, "kCapacity must fit into 16 bit positions");
+
+ float values_[kCapacity];
+ uint16_t min_queue_[kCapacity]; // Positions of increasing values, front is the minimum
+ uint16_t max_queue_[kCapacity]; // Positions of decreasing values, front is the maximum
+ int min_head_;
+ int min_size_;
+ int max_head_;
+ int max_size_;
+ int index_;
+ int count_;
+ int updates_;
+ float sum_;
+
+ void push(uint16_t* queue, int head, int& size, int position, bool minimum) {
+  // Drop values that can never become the minimum/maximum again
+  while(size > 0) {
+   float back = values_[queue[(head + size - 1) % kCapacity]];
+   if(minimum ? back < values_[position] : back > values_[position]) break;
+   size--;
+  }
+  queue[(head + size) % kCapacity] = position;
+  size++;
+ }
+
+ void expire(uint16_t* queue, int& head, int& size, int position) {
+  if(size > 0 && queue[head] == position) {
+   head = (head + 1) % kCapacity;
+   size--;
+  }
+ }
+public:
+ /**
+  * @brief Initialize the Statistic block
+  */
+ SlidingMinMaxAvgStatistic() {
+  reset();
+ }
+
+ /**
+  * @brief Add value to the statistic, replacing the oldest one if the window is full
+  */
+ void process(float value) {
+  if(count_ == kCapacity) {
+   expire(min_queue_, min_head_, min_size_, index_);
+   expire(max_queue_, max_head_, max_size_, index_);
+   sum_ -= values_[index_];
+  }
+  else {
+   count_++;
+  }
+
+  values_[index_] = value;
+  sum_ += value;
+  push(min_queue_, min_head_, min_size_, index_, true);
+  push(max_queue_, max_head_, max_size_, index_, false);
+  index_ = (index_ + 1) % kCapacity;
+
+  // Remove the float rounding drift of the running sum once per window
+  if(++updates_ >= kCapacity) {
+   sum_ = 0;
+   for(int i = 0; i < count_; i++) {
+    sum_ += values_[i];
+   }
+   updates_ = 0;
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  min_head_ = 0;
+  min_size_ = 0;
+  max_head_ = 0;
+  max_size_ = 0;
+  index_ = 0;
+  count_ = 0;
+  updates_ = 0;
+  sum_ = 0;
+ }
+
+ /**
+  * @brief Get Minimum
+  * @return Minimum Value of the window
+  */
+ float minimum() const {
+  return min_size_ > 0 ? values_[min_queue_[min_head_]] : NAN;
+ }
+
+ /**
+  * @brief Get Maximum
+  * @return Maximum Value of the window
+  */
+ float maximum() const {
+  return max_size_ > 0 ? values_[max_queue_[max_head_]] : NAN;
+ }
+
+ /**
+  * @brief Get Average
+  * @return Average Value of the window
+  */
+ float average() const {
+  return sum_/count_;
+ }
+
+ /**
+  * @brief Get number of samples
+  * @return Number of samples in the window
+  */
+ int count() const {
+  return count_;
+ }
+};
+
+/**
+ * @brief Sliding window statistic block for mean and variance
+ * @tparam kCapacity Window length in samples
+ * @remark The running sums of the values and their squares are taken relative to a
+ * reference near the mean, a large value with little spread (a load on a scale) would
+ * otherwise cancel out in float. The reference moves to the mean and both sums are
+ * recomputed once per window, every update is amortized O(1).
+ */
+template<int kCapacity> class SlidingVarianceStatistic {
+ static_assert(kCapacity > 1, "kCapacity must be at least 2");
+
+ float values_[kCapacity];
+ float reference_;
+ float sum_;    // Sum of value - reference_
+ float square_; // Sum of (value - reference_)^2
+ int index_;
+ int count_;
+ int updates_;
+
+ void resync() {
+  reference_ += sum_/count_;
+  sum_ = 0;
+  square_ = 0;
+  for(int i = 0; i < count_; i++) {
+   float delta = values_[i] - reference_;
+   sum_ += delta;
+   square_ += delta * delta;
+  }
+  updates_ = 0;
+ }
+public:
+ /**
+  * @brief Initialize the Statistic block
+  */
+ SlidingVarianceStatistic() {
+  reset();
+ }
+
+ /**
+  * @brief Add value to the statistic, replacing the oldest one if the window is full
+  */
+ void process(float value) {
+  if(count_ == 0) {
+   reference_ = value;
+  }
+  if(count_ == kCapacity) {
+   float delta = values_[index_] - reference_;
+   sum_ -= delta;
+   square_ -= delta * delta;
+  }
+  else {
+   count_++;
+  }
+
+  values_[index_] = value;
+  float delta = value - reference_;
+  sum_ += delta;
+  square_ += delta * delta;
+  index_ = (index_ + 1) % kCapacity;
+
+  if(++updates_ >= kCapacity) {
+   resync();
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  reference_ = 0;
+  sum_ = 0;
+  square_ = 0;
+  index_ = 0;
+  count_ = 0;
+  updates_ = 0;
+ }
+
+ /**
+  * @brief Get Average
+  * @return Average Value of the window
+  */
+ float average() const {
+  return reference_ + sum_/count_;
+ }
+
+ /**
+  * @brief Get Variance
+  * @return Population variance of the window, 0 for less than two samples
+  */
+ float variance() const {
+  if(count_ < 2) {
+   return 0;
+  }
+  float mean = sum_/count_;
+  float variance = square_/count_ - mean * mean;
+  return variance > 0 ? variance : 0;
+ }
+
+ /**
+  * @brief Get number of samples
+  * @return Number of samples in the window
+  */
+ int count() const {
+  return count_;
+ }
+};
+
+/**
+ * @brief Settling detector, e.g. for a scale after the load was put on
+ * @tparam kWindow Number of consecutive samples that have to agree
+ * @remark The reading counts as settled once the window is full, its standard deviation
+ * is within the tolerance, the least-squares line through it rises or falls by no more
+ * than the drift across the window and the magnitude of its average reaches the minimum,
+ * so an empty scale never settles. The drift limit keeps a creeping reading from settling
+ * early without waiting for a second window. The settled value is the average of the
+ * window and is kept until reset().
+ */
+template<int kWindow> class SettlingDetector {
+ static_assert(kWindow >= 2, "kWindow must be at least 2");
+
+ SlidingVarianceStatistic<kWindow> window_;
+ float values_[kWindow]; // The window in arrival order, for the slope
+ int index_;
+ const float tolerance_;
+ const float drift_;
+ const float minimum_;
+ bool settled_;
+ float value_;
+
+ // Change of the least-squares line from the oldest to the newest sample
+ float drift(float average) const {
+  const float center = (kWindow - 1) / 2.0f;
+  float moment = 0;
+  float spread = 0;
+  for(int i = 0; i < kWindow; i++) {
+   float offset = i - center;
+   moment += offset * (values_[(index_ + i) % kWindow] - average);
+   spread += offset * offset;
+  }
+  return moment / spread * (kWindow - 1);
+ }
+public:
+ /**
+  * @brief Initialize the detector
+  * @param tolerance Largest standard deviation of a settled window
+  * @param drift Largest change of the least-squares line across a settled window
+  * @param minimum Smallest magnitude of a settled average
+  */
+ SettlingDetector(float tolerance, float drift, float minimum) :
+  index_(0),
+  tolerance_(tolerance),
+  drift_(drift),
+  minimum_(minimum),
+  settled_(false),
+  value_(0){}
+
+ /**
+  * @brief Add a sample
+  * @return true once the reading has settled
+  */
+ bool process(float value) {
+  if(settled_) {
+   return true;
+  }
+  window_.process(value);
+  values_[index_] = value;
+  index_ = (index_ + 1) % kWindow;
+  if(window_.count() < kWindow || window_.variance() > tolerance_ * tolerance_) {
+   return false;
+  }
+  float average = window_.average();
+  float change = drift(average);
+  if(change > drift_ || change < -drift_) {
+   return false;
+  }
+  if(average < minimum_ && average > -minimum_) {
+   return false;
+  }
+  settled_ = true;
+  value_ = average;
+  return true;
+ }
+
+ /**
+  * @brief Resets the detector for a new measurement
+  */
+ void reset() {
+  window_.reset();
+  index_ = 0;
+  settled_ = false;
+  value_ = 0;
+ }
+
+ /**
+  * @brief Check whether the reading has settled
+  */
+ bool settled() const {
+  return settled_;
+ }
+
+ /**
+  * @brief Get the settled value, or the average of the last window before that
+  * @return Settled value, 0 without samples
+  */
+ float value() const {
+  if(settled_) {
+   return value_;
+  }
+  return window_.count() > 0 ? window_.average() : 0;
+ }
+};
+
+/**
+ * @brief Predicts the final value of a reading that approaches it exponentially, e.g. a
+ * thermometer warming up to the body temperature
+ * @tparam kCapacity Largest number of samples in the fit, the oldest one is dropped when full
+ * @remark The samples are fit to asymptote + amplitude * exp(-t / tau) by least squares.
+ * For a given tau the model is linear in asymptote and amplitude, so only tau is searched
+ * (golden section on log tau). The confidence interval of the asymptote uses the residuals
+ * and the Jacobian of all three parameters, an uncertain tau widens it. Without a
+ * significant amplitude the reading is flat and its average is taken instead. The estimate
+ * is final once the half-width of the interval stayed within the tolerance for a few fits
+ * in a row. A sample below the minimum (sensor not on the target yet) restarts the fit.
+ * Every sample refits the window, a few thousand expf() at full capacity.
+ */
+template<int kCapacity> class ExponentialApproachEstimator {
+ static_assert(kCapacity >= 10, "kCapacity must be at least 10");
+
+ static const int kMinimumSamples = 10;
+ static const int kAgreeingFits = 3;
+ static const int kSearchSteps = 24;
+
+ float times_[kCapacity];
+ float values_[kCapacity]; // Relative to reference_
+ const float tolerance_;
+ const float minimum_;
+ float reference_;
+ int index_;
+ int count_;
+ int agreeing_;
+ bool settled_;
+ float value_;
+ float estimate_;
+ float half_width_;
+ float tau_;
+
+ float timeAt(int i) const {
+  return times_[(index_ + kCapacity - count_ + i) % kCapacity] - times_[(index_ + kCapacity - count_) % kCapacity];
+ }
+
+ float valueAt(int i) const {
+  return values_[(index_ + kCapacity - count_ + i) % kCapacity];
+ }
+
+ // Asymptote and amplitude for a fixed tau, returns the residual sum of squares
+ float solve(float tau, float& asymptote, float& amplitude) const {
+  float se = 0, see = 0, sy = 0, sye = 0, syy = 0;
+  for(int i = 0; i < count_; i++) {
+   float e = expf(-timeAt(i) / tau);
+   float y = valueAt(i);
+   se += e;
+   see += e * e;
+   sy += y;
+   sye += y * e;
+   syy += y * y;
+  }
+  float det = count_ * see - se * se;
+  if(det <= 1e-6f * count_ * count_) {
+   amplitude = 0;
+   asymptote = sy / count_;
+   return syy - sy * asymptote;
+  }
+  asymptote = (see * sy - se * sye) / det;
+  amplitude = (count_ * sye - se * sy) / det;
+  return syy - asymptote * sy - amplitude * sye;
+ }
+
+ void fit() {
+  // Golden section search for the tau with the smallest residual, 0.1 to 20 s
+  const float kRatio = 0.618034f;
+  float low = logf(0.1f), high = logf(20.0f);
+  float a, c;
+  float x1 = high - kRatio * (high - low), x2 = low + kRatio * (high - low);
+  float f1 = solve(expf(x1), a, c), f2 = solve(expf(x2), a, c);
+  for(int step = 0; step < kSearchSteps; step++) {
+   if(f1 < f2) {
+    high = x2;
+    x2 = x1;
+    f2 = f1;
+    x1 = high - kRatio * (high - low);
+    f1 = solve(expf(x1), a, c);
+   }
+   else {
+    low = x1;
+    x1 = x2;
+    f1 = f2;
+    x2 = low + kRatio * (high - low);
+    f2 = solve(expf(x2), a, c);
+   }
+  }
+  float tau = expf((low + high) / 2);
+  float asymptote, amplitude;
+  solve(tau, asymptote, amplitude);
+
+  // Normal matrix of asymptote, amplitude and tau, residuals computed directly
+  float m00 = count_, m01 = 0, m02 = 0, m11 = 0, m12 = 0, m22 = 0;
+  float residual = 0, mean = 0, spread = 0;
+  for(int i = 0; i < count_; i++) {
+   float t = timeAt(i);
+   float e = expf(-t / tau);
+   float d = amplitude * e * t / (tau * tau);
+   float r = valueAt(i) - asymptote - amplitude * e;
+   m01 += e;
+   m02 += d;
+   m11 += e * e;
+   m12 += e * d;
+   m22 += d * d;
+   residual += r * r;
+   mean += valueAt(i);
+  }
+  mean /= count_;
+  for(int i = 0; i < count_; i++) {
+   spread += (valueAt(i) - mean) * (valueAt(i) - mean);
+  }
+  float variance = residual / (count_ - 3);
+
+  // A flat reading, the amplitude is not significant
+  float det2 = m00 * m11 - m01 * m01;
+  if(det2 <= 0 || amplitude * amplitude * det2 < 4 * variance * m00) {
+   estimate_ = reference_ + mean;
+   half_width_ = 2 * sqrtf(spread / (count_ - 1) / count_);
+   tau_ = 0;
+   return;
+  }
+
+  float cofactor = m11 * m22 - m12 * m12;
+  float det3 = m00 * cofactor - m01 * (m01 * m22 - m12 * m02) + m02 * (m01 * m12 - m11 * m02);
+  estimate_ = reference_ + asymptote;
+  half_width_ = det3 > 0 ? 2 * sqrtf(variance * cofactor / det3) : INFINITY;
+  tau_ = tau;
+ }
+
+ void restart() {
+  index_ = 0;
+  count_ = 0;
+  agreeing_ = 0;
+  estimate_ = 0;
+  half_width_ = INFINITY;
+  tau_ = 0;
+ }
+public:
+ /**
+  * @brief Initialize the estimator
+  * @param tolerance Largest half-width of the 95% confidence interval of a final estimate
+  * @param minimum Smallest reading that is part of the approach
+  */
+ ExponentialApproachEstimator(float tolerance, float minimum) :
+  tolerance_(tolerance),
+  minimum_(minimum),
+  reference_(0),
+  settled_(false),
+  value_(0){
+  restart();
+ }
+
+ /**
+  * @brief Add a sample
+  * @param seconds Time of the sample, any origin
+  * @param value Sample value
+  * @return true once the estimate is final
+  */
+ bool process(float seconds, float value) {
+  if(settled_) {
+   return true;
+  }
+  if(value < minimum_) {
+   restart();
+   return false;
+  }
+  if(count_ == 0) {
+   reference_ = value;
+  }
+  times_[index_] = seconds;
+  values_[index_] = value - reference_;
+  index_ = (index_ + 1) % kCapacity;
+  if(count_ < kCapacity) {
+   count_++;
+  }
+
+  if(count_ < kMinimumSamples) {
+   estimate_ = value;
+   return false;
+  }
+  fit();
+  agreeing_ = half_width_ <= tolerance_ ? agreeing_ + 1 : 0;
+  if(agreeing_ < kAgreeingFits) {
+   return false;
+  }
+  settled_ = true;
+  value_ = estimate_;
+  return true;
+ }
+
+ /**
+  * @brief Resets the estimator for a new measurement
+  */
+ void reset() {
+  restart();
+  settled_ = false;
+  value_ = 0;
+ }
+
+ /**
+  * @brief Check whether the estimate is final
+  */
+ bool settled() const {
+  return settled_;
+ }
+
+ /**
+  * @brief Get the final estimate, or the latest one before that
+  * @return Predicted final value, the last sample while there are too few for a fit, 0 without samples
+  */
+ float value() const {
+  return settled_ ? value_ : estimate_;
+ }
+
+ /**
+  * @brief Get the half-width of the 95% confidence interval of the latest estimate
+  * @return Half-width, infinite without a fit
+  */
+ float halfWidth() const {
+  return half_width_;
+ }
+
+ /**
+  * @brief Get the time constant of the latest fit
+  * @return Time constant in s, 0 for a flat reading or without a fit
+  */
+ float timeConstant() const {
+  return tau_;
+ }
+};
+
 /**
  * @brief High Pass Filter 
  */
@@ -114,6 +684,35 @@ public:
   return last_filter_value_;
  }
 
+ /**
+  * @brief Applies the high pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const float* in, float* out, size_t n) {
+  if(n == 0) return;
+
+  size_t i = 0;
+  if(isnan(last_filter_value_) || isnan(last_raw_value_)) {
+   last_filter_value_ = 0.0;
+   last_raw_value_ = in[0];
+   out[0] = 0.0;
+   i = 1;
+  }
+
+  float last_raw = last_raw_value_;
+  float last_filter = last_filter_value_;
+  for(; i < n; i++) {
+   float value = in[i];
+   last_filter = kA0 * value + kA1 * last_raw + kB1 * last_filter;
+   last_raw = value;
+   out[i] = last_filter;
+  }
+  last_raw_value_ = last_raw;
+  last_filter_value_ = last_filter;
+ }
+
  /**
   * @brief Resets the stored values
   */
@@ -164,6 +763,30 @@ public:
   return last_value_;
  }
 
+ /**
+  * @brief Applies the low pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const float* in, float* out, size_t n) {
+  if(n == 0) return;
+
+  size_t i = 0;
+  if(isnan(last_value_)) {
+   last_value_ = in[0];
+   out[0] = last_value_;
+   i = 1;
+  }
+
+  float last_value = last_value_;
+  for(; i < n; i++) {
+   last_value = kA0 * in[i] + kB1 * last_value;
+   out[i] = last_value;
+  }
+  last_value_ = last_value;
+ }
+
  /**
   * @brief Resets the stored values
   */
@@ -195,6 +818,22 @@ public:
    return diff;
  }
 
+ /**
+  * @brief Applies the differentiator to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const float* in, float* out, size_t n) {
+  float last_value = last_value_;
+  for(size_t i = 0; i < n; i++) {
+   float value = in[i];
+   out[i] = (value-last_value)*kSamplingFrequency;
+   last_value = value;
+  }
+  last_value_ = last_value;
+ }
+
  /**
   * @brief Resets the stored values
   */
@@ -204,42 +843,678 @@ public:
 };
 
 /**
- * @brief MovingAverageFilter
- * @tparam buffer_size Number of samples to average over
+ * @brief Q15 fixed point format (16 bit samples, 32 bit accumulator)
  */
-template<int kBufferSize> class MovingAverageFilter {
- int index_;
- int count_;
- float values_[kBufferSize];
-public:
- /**
-  * @brief Initalize moving average filter
+struct Q15 {
+ typedef int16_t Sample;
+ typedef int32_t Accumulator;
+ static const int kFractionBits = 15;
+};
+
+/**
+ * @brief Q31 fixed point format (32 bit samples, 64 bit accumulator)
+ */
+struct Q31 {
+ typedef int32_t Sample;
+ typedef int64_t Accumulator;
+ static const int kFractionBits = 31;
+};
+
+/**
+ * @brief Fixed point arithmetic helpers
+ * @tparam Q Fixed point format (Q15 or Q31)
+ */
+template<typename Q> struct FixedPoint {
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ static const Sample kMax = (Sample)(((uint64_t)1 << (sizeof(Sample) * 8 - 1)) - 1);
+ static const Sample kMin = -kMax - 1;
+
+ /**
+  * @brief Converts a coefficient in [-1, 1) to fixed point
   */
- MovingAverageFilter() :
+ static Sample coefficient(float value) {
+  float scaled = value * (float)((uint64_t)1 << Q::kFractionBits);
+  if(scaled >= (float)kMax) return kMax;
+  if(scaled <= (float)kMin) return kMin;
+  return (Sample)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+ }
+
+ /**
+  * @brief Rounds a product sum back to the sample scale and saturates it
+  */
+ static Sample narrow(Accumulator value) {
+  value = (value + ((Accumulator)1 << (Q::kFractionBits - 1))) >> Q::kFractionBits;
+  return saturate(value);
+ }
+
+ /**
+  * @brief Saturates a value to the sample range
+  */
+ static Sample saturate(Accumulator value) {
+  if(value > kMax) return kMax;
+  if(value < kMin) return kMin;
+  return (Sample)value;
+ }
+};
+
+/**
+ * @brief Fixed point High Pass Filter
+ * @tparam Q Fixed point format (Q15 or Q31)
+ * @remark Same response as HighPassFilter, samples are integers and the
+ * coefficients are stored as Q15/Q31 fractions. Keep one bit of headroom in the input.
+ */
+template<typename Q> class HighPassFilterFixed {
+ typedef FixedPoint<Q> FP;
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ const Sample kA0;
+ const Sample kB1;
+ Sample last_filter_value_;
+ Sample last_raw_value_;
+ bool valid_;
+public:
+ /**
+  * @brief Initialize the High Pass Filter
+  * @param samples Number of samples until decay to 36.8 %
+  * @remark Sample number is an RC time-constant equivalent
+  */
+ HighPassFilterFixed(float samples) :
+  kA0(FP::coefficient((1+exp(-1/samples))/2)),
+  kB1(FP::coefficient(exp(-1/samples))),
+  last_filter_value_(0),
+  last_raw_value_(0),
+  valid_(false){}
+
+ /**
+  * @brief Initialize the High Pass Filter
+  * @param cutoff Cutoff frequency
+  * @pram sampling_frequency Sampling frequency
+  */
+ HighPassFilterFixed(float cutoff, float sampling_frequency) :
+  HighPassFilterFixed(sampling_frequency/(cutoff*2*PI)){}
+
+ /**
+  * @brief Applies the high pass filter
+  */
+ Sample process(Sample value) {
+  if(!valid_) {
+   last_filter_value_ = 0;
+   valid_ = true;
+  }
+  else {
+   // kA1 is -kA0
+   last_filter_value_ = FP::narrow(
+    (Accumulator)kA0 * ((Accumulator)value - last_raw_value_)
+    + (Accumulator)kB1 * last_filter_value_);
+  }
+  last_raw_value_ = value;
+  return last_filter_value_;
+ }
+
+ /**
+  * @brief Applies the high pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const Sample* in, Sample* out, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+   out[i] = process(in[i]);
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  valid_ = false;
+ }
+};
+
+/**
+ * @brief Fixed point Low Pass Filter
+ * @tparam Q Fixed point format (Q15 or Q31)
+ * @remark Same response as LowPassFilter, samples are integers and the
+ * coefficients are stored as Q15/Q31 fractions
+ */
+template<typename Q> class LowPassFilterFixed {
+ typedef FixedPoint<Q> FP;
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ const Sample kA0;
+ const Sample kB1;
+ Sample last_value_;
+ bool valid_;
+public:
+ /**
+  * @brief Initialize the Low Pass Filter
+  * @param samples Number of samples until decay to 36.8 %
+  * @remark Sample number is an RC time-constant equivalent
+  */
+ LowPassFilterFixed(float samples) :
+  kA0(FP::coefficient(1-exp(-1/samples))),
+  kB1(FP::coefficient(exp(-1/samples))),
+  last_value_(0),
+  valid_(false){}
+
+ /**
+  * @brief Initialize the Low Pass Filter
+  * @param cutoff Cutoff frequency
+  * @pram sampling_frequency Sampling frequency
+  */
+ LowPassFilterFixed(float cutoff, float sampling_frequency) :
+  LowPassFilterFixed(sampling_frequency/(cutoff*2*PI)){}
+
+ /**
+  * @brief Applies the low pass filter
+  */
+ Sample process(Sample value) {
+  if(!valid_) {
+   last_value_ = value;
+   valid_ = true;
+  }
+  else {
+   last_value_ = FP::narrow((Accumulator)kA0 * value + (Accumulator)kB1 * last_value_);
+  }
+  return last_value_;
+ }
+
+ /**
+  * @brief Applies the low pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const Sample* in, Sample* out, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+   out[i] = process(in[i]);
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  valid_ = false;
+ }
+};
+
+/**
+ * @brief Fixed point Differentiator
+ * @tparam Q Fixed point format (Q15 or Q31)
+ * @remark The first sample after a reset yields 0 instead of NaN. The output is the
+ * difference times the sampling frequency in the accumulator type, exact for any step at
+ * sampling frequencies up to 32 kHz. A sample would saturate on steps above full scale /
+ * sampling frequency.
+ */
+template<typename Q> class DifferentiatorFixed {
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ const Accumulator kSamplingFrequency;
+ Sample last_value_;
+ bool valid_;
+public:
+ /**
+  * @brief Initializes the differentiator
+  */
+ DifferentiatorFixed(float sampling_frequency) :
+  kSamplingFrequency((Accumulator)(sampling_frequency + 0.5f)),
+  last_value_(0),
+  valid_(false){}
+
+ /**
+  * @brief Applies the differentiator
+  */
+ Accumulator process(Sample value) {
+  Accumulator diff = valid_ ? ((Accumulator)value - last_value_) * kSamplingFrequency : 0;
+  last_value_ = value;
+  valid_ = true;
+  return diff;
+ }
+
+ /**
+  * @brief Applies the differentiator to a block of samples
+  * @param in Input samples
+  * @param out Output values
+  * @param n Number of samples
+  */
+ void process(const Sample* in, Accumulator* out, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+   out[i] = process(in[i]);
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  valid_ = false;
+ }
+};
+
+typedef HighPassFilterFixed<Q15> HighPassFilterQ15;
+typedef HighPassFilterFixed<Q31> HighPassFilterQ31;
+typedef LowPassFilterFixed<Q15> LowPassFilterQ15;
+typedef LowPassFilterFixed<Q31> LowPassFilterQ31;
+typedef DifferentiatorFixed<Q15> DifferentiatorQ15;
+typedef DifferentiatorFixed<Q31> DifferentiatorQ31;
+
+/**
+ * @brief Binary heap of sample slots with their heap positions, so any slot can be removed
+ * @tparam kCapacity Largest number of slots
+ * @tparam kMaximum true for a max-heap, false for a min-heap
+ * @remark The values live in the array of the owning filter, the heap only orders slot numbers.
+ */
+template<int kCapacity, bool kMaximum> class IndexedHeap {
+ const float* values_;
+ uint16_t slots_[kCapacity];
+ uint16_t positions_[kCapacity];
+ int size_;
+
+ bool before(uint16_t a, uint16_t b) const {
+  return kMaximum ? values_[a] > values_[b] : values_[a] < values_[b];
+ }
+
+ void place(int position, uint16_t slot) {
+  slots_[position] = slot;
+  positions_[slot] = position;
+ }
+
+ void up(int position) {
+  uint16_t slot = slots_[position];
+  while(position > 0) {
+   int parent = (position - 1) / 2;
+   if(!before(slot, slots_[parent])) break;
+   place(position, slots_[parent]);
+   position = parent;
+  }
+  place(position, slot);
+ }
+
+ void down(int position) {
+  uint16_t slot = slots_[position];
+  for(;;) {
+   int child = 2 * position + 1;
+   if(child >= size_) break;
+   if(child + 1 < size_ && before(slots_[child + 1], slots_[child])) child++;
+   if(!before(slots_[child], slot)) break;
+   place(position, slots_[child]);
+   position = child;
+  }
+  place(position, slot);
+ }
+public:
+ static const uint16_t kNone = 0xFFFF;
+
+ explicit IndexedHeap(const float* values) :
+  values_(values),
+  size_(0) {
+  for(int i = 0; i < kCapacity; i++) {
+   positions_[i] = kNone;
+  }
+ }
+
+ void push(uint16_t slot) {
+  place(size_, slot);
+  size_++;
+  up(size_ - 1);
+ }
+
+ void remove(uint16_t slot) {
+  int position = positions_[slot];
+  positions_[slot] = kNone;
+  size_--;
+  if(position == size_) return;
+  uint16_t moved = slots_[size_];
+  place(position, moved);
+  up(position);
+  down(positions_[moved]);
+ }
+
+ uint16_t top() const {
+  return slots_[0];
+ }
+
+ bool contains(uint16_t slot) const {
+  return positions_[slot] != kNone;
+ }
+
+ int size() const {
+  return size_;
+ }
+
+ void clear() {
+  for(int i = 0; i < size_; i++) {
+   positions_[slots_[i]] = kNone;
+  }
+  size_ = 0;
+ }
+};
+
+/**
+ * @brief Sliding trimmed mean, drops the lowest and highest values of the window and
+ * averages the rest
+ * @tparam kWindow Window length in samples
+ * @remark The window is split into the trimmed low values (max-heap), the trimmed high
+ * values (min-heap) and the middle values, which sit in a min-heap and a max-heap at once
+ * so either end can move out. A new sample replaces the oldest one and at most a few
+ * values move between the parts, O(log N) per sample instead of sorting the window.
+ * Until the window is full fewer values are trimmed, at most (count - 1) / 2 per side.
+ */
+template<int kWindow> class SlidingTrimmedMeanFilter {
+ static_assert(kWindow > 0 && kWindow < 0xFFFF, "kWindow must fit into 16 bit slots");
+
+ float values_[kWindow];
+ IndexedHeap<kWindow, true> low_;
+ IndexedHeap<kWindow, false> high_;
+ IndexedHeap<kWindow, false> middle_min_;
+ IndexedHeap<kWindow, true> middle_max_;
+ const int trim_;
+ float sum_; // Sum of the middle values
+ int index_;
+ int count_;
+ int updates_;
+
+ void addMiddle(uint16_t slot) {
+  middle_min_.push(slot);
+  middle_max_.push(slot);
+  sum_ += values_[slot];
+ }
+
+ void removeMiddle(uint16_t slot) {
+  middle_min_.remove(slot);
+  middle_max_.remove(slot);
+  sum_ -= values_[slot];
+ }
+
+ void remove(uint16_t slot) {
+  if(low_.contains(slot)) low_.remove(slot);
+  else if(high_.contains(slot)) high_.remove(slot);
+  else removeMiddle(slot);
+ }
+
+ void balance() {
+  int trim = (count_ - 1) / 2 < trim_ ? (count_ - 1) / 2 : trim_;
+  while(low_.size() > trim) {
+   uint16_t slot = low_.top();
+   low_.remove(slot);
+   addMiddle(slot);
+  }
+  while(high_.size() > trim) {
+   uint16_t slot = high_.top();
+   high_.remove(slot);
+   addMiddle(slot);
+  }
+  while(low_.size() < trim) {
+   uint16_t slot = middle_min_.top();
+   removeMiddle(slot);
+   low_.push(slot);
+  }
+  while(high_.size() < trim) {
+   uint16_t slot = middle_max_.top();
+   removeMiddle(slot);
+   high_.push(slot);
+  }
+
+  // A new value may belong to one of the trimmed ends
+  if(low_.size() > 0 && values_[low_.top()] > values_[middle_min_.top()]) {
+   uint16_t trimmed = low_.top();
+   uint16_t middle = middle_min_.top();
+   low_.remove(trimmed);
+   removeMiddle(middle);
+   low_.push(middle);
+   addMiddle(trimmed);
+  }
+  if(high_.size() > 0 && values_[high_.top()] < values_[middle_max_.top()]) {
+   uint16_t trimmed = high_.top();
+   uint16_t middle = middle_max_.top();
+   high_.remove(trimmed);
+   removeMiddle(middle);
+   high_.push(middle);
+   addMiddle(trimmed);
+  }
+ }
+
+ void resync() {
+  sum_ = 0;
+  for(int i = 0; i < count_; i++) {
+   if(!low_.contains(i) && !high_.contains(i)) {
+    sum_ += values_[i];
+   }
+  }
+  updates_ = 0;
+ }
+public:
+ /**
+  * @brief Initialize the filter
+  * @param trim Values dropped at each end of a full window, at most (kWindow - 1) / 2
+  */
+ explicit SlidingTrimmedMeanFilter(int trim) :
+  low_(&values_[0]),
+  high_(&values_[0]),
+  middle_min_(&values_[0]),
+  middle_max_(&values_[0]),
+  trim_(trim < (kWindow - 1) / 2 ? trim : (kWindow - 1) / 2),
+  sum_(0),
+  index_(0),
+  count_(0),
+  updates_(0){}
+
+ /**
+  * @brief Applies the filter
+  * @return Average of the middle values of the window
+  */
+ float process(float value) {
+  if(count_ == kWindow) {
+   remove(index_);
+  }
+  else {
+   count_++;
+  }
+  values_[index_] = value;
+  addMiddle(index_);
+  index_ = (index_ + 1) % kWindow;
+  balance();
+
+  // Remove the float rounding drift of the running sum once per window
+  if(++updates_ >= kWindow) {
+   resync();
+  }
+
+  // One or two middle values (a median) are exact, the running sum is not
+  int middle = middle_min_.size();
+  if(middle == 1) {
+   return values_[middle_min_.top()];
+  }
+  if(middle == 2) {
+   return (values_[middle_min_.top()] + values_[middle_max_.top()]) / 2;
+  }
+  return sum_/middle;
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  low_.clear();
+  high_.clear();
+  middle_min_.clear();
+  middle_max_.clear();
+  sum_ = 0;
+  index_ = 0;
+  count_ = 0;
+  updates_ = 0;
+ }
+
+ /**
+  * @brief Get number of samples
+  * @return Number of samples in the window
+  */
+ int count() const {
+  return count_;
+ }
+};
+
+/**
+ * @brief Sliding median, removes spikes shorter than half the window
+ * @tparam kWindow Window length in samples, an even window averages the two middle values
+ * @tparam kSorted Keep a sorted copy of the window instead of the heaps, the default for
+ * short windows
+ * @remark The sorted copy replaces the oldest sample by moving the values between it and
+ * the new one, O(N) but cheaper than the heaps up to about 100 samples. Both return the
+ * middle values as they are. NaN samples have to be skipped by the caller.
+ */
+template<int kWindow, bool kSorted = (kWindow <= 63)> class SlidingMedianFilter :
+ public SlidingTrimmedMeanFilter<kWindow> {
+public:
+ SlidingMedianFilter() :
+  SlidingTrimmedMeanFilter<kWindow>((kWindow - 1) / 2){}
+};
+
+template<int kWindow> class SlidingMedianFilter<kWindow, true> {
+ static_assert(kWindow > 0, "kWindow must be positive");
+
+ float values_[kWindow]; // In arrival order
+ float sorted_[kWindow];
+ int index_;
+ int count_;
+public:
+ SlidingMedianFilter() :
   index_(0),
   count_(0){}
 
  /**
-  * @brief Applies the moving average filter
+  * @brief Applies the filter
+  * @return Median of the window
   */
- float process(float value) {  
-   // Add value
-   values_[index_] = value;
+ float process(float value) {
+  int position;
+  if(count_ == kWindow) {
+   position = 0;
+   while(sorted_[position] != values_[index_]) {
+    position++;
+   }
+  }
+  else {
+   position = count_++;
+   sorted_[position] = value;
+  }
+  while(position > 0 && sorted_[position - 1] > value) {
+   sorted_[position] = sorted_[position - 1];
+   position--;
+  }
+  while(position + 1 < count_ && sorted_[position + 1] < value) {
+   sorted_[position] = sorted_[position + 1];
+   position++;
+  }
+  sorted_[position] = value;
+  values_[index_] = value;
+  index_ = (index_ + 1) % kWindow;
 
-   // Increase index and count
-   index_ = (index_ + 1) % kBufferSize;
+  int middle = count_ / 2;
+  return count_ % 2 ? sorted_[middle] : (sorted_[middle - 1] + sorted_[middle]) / 2;
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  index_ = 0;
+  count_ = 0;
+ }
+
+ /**
+  * @brief Get number of samples
+  * @return Number of samples in the window
+  */
+ int count() const {
+  return count_;
+ }
+};
+
+/**
+ * @brief Running sum type of the MovingAverageFilter
+ * @remark Integer samples are summed exactly, float sums accumulate rounding
+ * errors and are recomputed periodically
+ */
+template<typename T> struct MovingAverageSum {
+ typedef float Type;
+ static const bool kExact = false;
+};
+
+template<> struct MovingAverageSum<int16_t> {
+ typedef int32_t Type;
+ static const bool kExact = true;
+};
+
+template<> struct MovingAverageSum<int32_t> {
+ typedef int64_t Type;
+ static const bool kExact = true;
+};
+
+/**
+ * @brief MovingAverageFilter
+ * @tparam buffer_size Number of samples to average over
+ * @tparam T Sample type, e.g. int16_t for long ECG windows (float, int16_t or int32_t)
+ * @remark Keeps a running sum so that each sample costs O(1) regardless of the
+ * window size. A float sum is recomputed from the buffer once every
+ * kResyncPeriod samples to remove the accumulated rounding error.
+ */
+template<int kBufferSize, typename T = float> class MovingAverageFilter {
+ typedef typename MovingAverageSum<T>::Type Sum;
+ static const int kResyncPeriod = kBufferSize < 256 ? 256 : kBufferSize;
+
+ int index_;
+ int count_;
+ int updates_;
+ Sum sum_;
+ T values_[kBufferSize];
+
+ void resync() {
+  Sum sum = 0;
+  for(int i = 0; i < count_; i++) {
+   sum += values_[i];
+  }
+  sum_ = sum;
+  updates_ = 0;
+ }
+public:
+ /**
+  * @brief Initalize moving average filter
+  */
+ MovingAverageFilter() :
+  index_(0),
+  count_(0),
+  updates_(0),
+  sum_(0){}
+
+ /**
+  * @brief Applies the moving average filter
+  */
+ float process(T value) {  
+   // Replace the oldest value once the buffer is full
    if(count_ < kBufferSize) {
     count_++;  
    }
+   else {
+    sum_ -= values_[index_];
+   }
+   values_[index_] = value;
+   sum_ += value;
+   index_ = (index_ + 1) % kBufferSize;
 
-   // Calculate sum
-   float sum = 0.0;
-   for(int i = 0; i < count_; i++) {
-     sum += values_[i];
+   // Remove the float rounding drift, amortized O(1)
+   if(!MovingAverageSum<T>::kExact && ++updates_ >= kResyncPeriod) {
+    resync();
    }
 
    // Calculate average
-   return sum/count_;
+   return (float)sum_/count_;
  }
 
  /**
@@ -248,6 +1523,8 @@ public:
  void reset() {
   index_ = 0;
   count_ = 0;
+  updates_ = 0;
+  sum_ = 0;
  }
 
  /**
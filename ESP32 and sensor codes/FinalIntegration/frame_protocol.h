@@ -0,0 +1,171 @@
+#ifndef FRAME_PROTOCOL_H
+#define FRAME_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "crc16.h"
+
+/**
+ * Binary frames sent from the device to the PC
+ *
+ *   0xA5 0x5A | type | seq | length | payload[length] | crc (little endian)
+ *
+ * seq counts up by one per frame so that the receiver can detect lost frames.
+ * The CRC16 (crc16_data() with start value 0) covers type, seq, length and payload.
+ * All multi-byte values are little endian. Plain text lines may be sent between
+ * frames, the sync bytes never occur in ASCII text.
+ *
+ * This header does not depend on Arduino, the host decoder includes it as well.
+ */
+
+const uint8_t kFrameSync0 = 0xA5;
+const uint8_t kFrameSync1 = 0x5A;
+const size_t kFrameHeaderSize = 5;
+const size_t kFrameCrcSize = 2;
+const size_t kFrameMaxPayload = 96;
+const size_t kFrameMaxSize = kFrameHeaderSize + kFrameMaxPayload + kFrameCrcSize;
+
+/**
+ * @brief Frame types and their payload
+ */
+enum FrameType : uint8_t {
+  FRAME_WEIGHT = 0x01,      //!< float weight
+  FRAME_SPO2 = 0x02,        //!< float SpO2 in %
+  FRAME_PULSE = 0x03,       //!< float pulse in bpm
+  FRAME_TEMP = 0x04,        //!< float temperature in degree Celsius
+  FRAME_ECG_START = 0x10,   //!< uint16 ECG sampling rate in Hz
+  FRAME_ECG_SAMPLES = 0x11, //!< uint32 index of the first sample, int16 first sample, zigzag varint deltas
+  FRAME_DATA_END = 0x1F     //!< no payload
+};
+
+/**
+ * @brief Frame builder with a running sequence number
+ */
+class FrameEncoder {
+  uint8_t seq_;
+public:
+  /**
+   * @brief Initialize the encoder
+   */
+  FrameEncoder() :
+    seq_(0){}
+
+  /**
+   * @brief Build a frame
+   * @param type Frame type
+   * @param payload Payload
+   * @param length Payload length, at most kFrameMaxPayload
+   * @param frame Output buffer of at least kFrameMaxSize bytes
+   * @return Frame size in bytes
+   */
+  size_t encode(uint8_t type, const uint8_t* payload, size_t length, uint8_t* frame) {
+    if(length > kFrameMaxPayload) length = kFrameMaxPayload;
+
+    frame[0] = kFrameSync0;
+    frame[1] = kFrameSync1;
+    frame[2] = type;
+    frame[3] = seq_++;
+    frame[4] = (uint8_t)length;
+    if(length > 0) memcpy(frame + kFrameHeaderSize, payload, length);
+
+    unsigned short crc = crc16_data(frame + 2, (int)(kFrameHeaderSize - 2 + length), 0);
+    frame[kFrameHeaderSize + length] = crc & 0xFF;
+    frame[kFrameHeaderSize + length + 1] = crc >> 8;
+    return kFrameHeaderSize + length + kFrameCrcSize;
+  }
+};
+
+/**
+ * @brief Packs consecutive ECG samples into FRAME_ECG_SAMPLES payloads
+ * @remark Each payload starts with the index and value of its first sample,
+ * so a lost frame does not corrupt the following ones.
+ */
+class EcgFramePacker {
+  // A zigzag encoded 16 bit delta needs at most 3 bytes
+  static const size_t kMaxDeltaSize = 3;
+
+  uint8_t payload_[kFrameMaxPayload];
+  size_t length_;
+  int16_t last_;
+  uint32_t next_index_;
+public:
+  /**
+   * @brief Initialize the packer
+   */
+  EcgFramePacker() :
+    length_(0),
+    last_(0),
+    next_index_(0){}
+
+  /**
+   * @brief Start a new recording at sample index 0
+   */
+  void reset() {
+    length_ = 0;
+    next_index_ = 0;
+  }
+
+  /**
+   * @brief Add the next sample
+   * @param value Sample value
+   * @return true if the payload is full and has to be sent before adding more samples
+   */
+  bool add(int16_t value) {
+    if(length_ == 0) {
+      payload_[0] = next_index_ & 0xFF;
+      payload_[1] = (next_index_ >> 8) & 0xFF;
+      payload_[2] = (next_index_ >> 16) & 0xFF;
+      payload_[3] = next_index_ >> 24;
+      payload_[4] = (uint16_t)value & 0xFF;
+      payload_[5] = (uint16_t)value >> 8;
+      length_ = 6;
+    }
+    else {
+      int16_t delta = (int16_t)(value - last_);
+      uint16_t zigzag = (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+      while(zigzag >= 0x80) {
+        payload_[length_++] = (uint8_t)(zigzag | 0x80);
+        zigzag >>= 7;
+      }
+      payload_[length_++] = (uint8_t)zigzag;
+    }
+
+    last_ = value;
+    next_index_++;
+    return length_ + kMaxDeltaSize > kFrameMaxPayload;
+  }
+
+  /**
+   * @brief Drop the packed samples after they were sent
+   */
+  void clear() {
+    length_ = 0;
+  }
+
+  /**
+   * @brief Check whether samples are waiting to be sent
+   * @return true if empty, otherwise false
+   */
+  bool empty() const {
+    return length_ == 0;
+  }
+
+  /**
+   * @brief Get the payload
+   * @return Pointer to the payload
+   */
+  const uint8_t* payload() const {
+    return payload_;
+  }
+
+  /**
+   * @brief Get the payload length
+   * @return Payload length in bytes
+   */
+  size_t length() const {
+    return length_;
+  }
+};
+
+#endif // FRAME_PROTOCOL_H
@@ -0,0 +1,135 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#endif
+
+/**
+ * @brief Priority of a bus user
+ */
+enum I2CPriority {
+  I2C_PRIORITY_DISPLAY, //!< Frame pushes, split into chunks that fit the budget
+  I2C_PRIORITY_SENSOR   //!< FIFO drains and sensor reads, never wait for more than one display chunk
+};
+
+/**
+ * @brief Arbiter for the I2C bus shared by the display and the sensors
+ * @remark Sensor users announce themselves before they wait for the bus. A display user
+ * only takes the bus when no sensor is waiting and holds it for one chunk, so a FIFO
+ * drain is delayed by at most the display budget. Without FreeRTOS there is only one
+ * task and acquire() and release() do nothing.
+ */
+class I2CBus {
+#if defined(ARDUINO_ARCH_ESP32)
+  SemaphoreHandle_t mutex_;
+#endif
+  std::atomic<int> sensors_waiting_;
+  const uint32_t display_clock_;
+  const unsigned long display_budget_us_;
+public:
+  /**
+   * @brief Initialize the arbiter
+   * @param displayClock SCL frequency in Hz while the display is written
+   * @param displayBudgetUs Longest time in us a display user may hold the bus
+   */
+  I2CBus(uint32_t displayClock, unsigned long displayBudgetUs) :
+#if defined(ARDUINO_ARCH_ESP32)
+    mutex_(nullptr),
+#endif
+    sensors_waiting_(0),
+    display_clock_(displayClock),
+    display_budget_us_(displayBudgetUs){}
+
+  /**
+   * @brief Create the lock, call once before any task uses the bus
+   */
+  void begin() {
+#if defined(ARDUINO_ARCH_ESP32)
+    mutex_ = xSemaphoreCreateMutex();
+#endif
+  }
+
+  /**
+   * @brief Wait for the bus
+   * @param priority Priority of the caller
+   */
+  void acquire(I2CPriority priority) {
+#if defined(ARDUINO_ARCH_ESP32)
+    if(priority == I2C_PRIORITY_SENSOR) {
+      sensors_waiting_++;
+      xSemaphoreTake(mutex_, portMAX_DELAY);
+      sensors_waiting_--;
+      return;
+    }
+
+    // A released mutex could go straight back to the display task on the other core
+    for(;;) {
+      while(sensors_waiting_.load() > 0) vTaskDelay(1);
+      xSemaphoreTake(mutex_, portMAX_DELAY);
+      if(sensors_waiting_.load() == 0) return;
+      xSemaphoreGive(mutex_);
+    }
+#else
+    (void)priority;
+#endif
+  }
+
+  /**
+   * @brief Release the bus
+   */
+  void release() {
+#if defined(ARDUINO_ARCH_ESP32)
+    xSemaphoreGive(mutex_);
+#endif
+  }
+
+  /**
+   * @brief Check whether a sensor user waits for the bus
+   * @return true if a display user should release the bus after its current chunk
+   */
+  bool sensorWaiting() const {
+    return sensors_waiting_.load() > 0;
+  }
+
+  /**
+   * @brief Largest display write that fits the budget
+   * @param overheadBytes Bytes sent along with each chunk (addresses and commands)
+   * @return Number of data bytes, at least 1
+   * @remark 9 clocks per byte
+   */
+  size_t displayChunkBytes(size_t overheadBytes) const {
+    size_t bytes = (size_t)((uint64_t)display_budget_us_ * display_clock_ / 9000000u);
+    return bytes > overheadBytes ? bytes - overheadBytes : 1;
+  }
+};
+
+/**
+ * @brief Scoped hold of the shared I2C bus
+ */
+class I2CBusLock {
+  I2CBus& bus_;
+public:
+  /**
+   * @brief Wait for the bus
+   * @param bus Arbiter of the bus
+   * @param priority Priority of the caller
+   */
+  I2CBusLock(I2CBus& bus, I2CPriority priority = I2C_PRIORITY_SENSOR) :
+    bus_(bus) {
+    bus_.acquire(priority);
+  }
+
+  ~I2CBusLock() {
+    bus_.release();
+  }
+
+  I2CBusLock(const I2CBusLock&) = delete;
+  I2CBusLock& operator=(const I2CBusLock&) = delete;
+};
+
+#endif // I2C_BUS_H
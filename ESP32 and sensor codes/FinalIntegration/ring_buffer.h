@@ -0,0 +1,85 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+/**
+ * @brief Fixed-capacity FIFO ring buffer
+ * @tparam T Element type
+ * @tparam kCapacity Maximum number of stored elements
+ * @remark When the buffer is full the oldest element is dropped and counted as overrun
+ */
+template<typename T, int kCapacity> class RingBuffer {
+  T values_[kCapacity];
+  int head_;
+  int count_;
+  unsigned long overruns_;
+public:
+  /**
+   * @brief Initialize the ring buffer
+   */
+  RingBuffer() :
+    head_(0),
+    count_(0),
+    overruns_(0){}
+
+  /**
+   * @brief Append a value, dropping the oldest one if the buffer is full
+   * @param value Value to append
+   */
+  void push(const T& value) {
+    values_[head_] = value;
+    head_ = (head_ + 1) % kCapacity;
+    if(count_ < kCapacity) {
+      count_++;
+    }
+    else {
+      overruns_++;
+    }
+  }
+
+  /**
+   * @brief Remove the oldest value
+   * @param value Reference to store the value in
+   * @return true if a value was available, otherwise false
+   */
+  bool pop(T& value) {
+    if(count_ == 0) return false;
+    value = values_[(head_ + kCapacity - count_) % kCapacity];
+    count_--;
+    return true;
+  }
+
+  /**
+   * @brief Resets the stored values and the overrun counter
+   */
+  void reset() {
+    head_ = 0;
+    count_ = 0;
+    overruns_ = 0;
+  }
+
+  /**
+   * @brief Get number of stored values
+   * @return Number of stored values
+   */
+  int size() const {
+    return count_;
+  }
+
+  /**
+   * @brief Check whether the buffer is empty
+   * @return true if empty, otherwise false
+   */
+  bool empty() const {
+    return count_ == 0;
+  }
+
+  /**
+   * @brief Get number of values dropped because the buffer was full
+   * @return Number of dropped values
+   */
+  unsigned long overruns() const {
+    return overruns_;
+  }
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,200 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/**
+ * @brief Millisecond clock used by the scheduler
+ * @remark millis() on the device, a fake clock when the sketch logic is run on a host
+ */
+typedef unsigned long (*ClockSource)();
+
+/**
+ * @brief Periodic task driven by the scheduler tick
+ */
+class PeriodicTask {
+  void (*callback_)();
+  unsigned long period_;
+  unsigned long last_run_;
+  bool running_;
+public:
+  /**
+   * @brief Initialize the periodic task
+   * @param callback Function to run
+   * @param period Period in ms (0 runs the task on every tick)
+   */
+  PeriodicTask(void (*callback)(), unsigned long period) :
+    callback_(callback),
+    period_(period),
+    last_run_(0),
+    running_(false){}
+
+  /**
+   * @brief Start the task, the first run happens on the next tick
+   * @param now Current time in ms
+   */
+  void start(unsigned long now) {
+    last_run_ = now - period_;
+    running_ = true;
+  }
+
+  /**
+   * @brief Stop the task
+   */
+  void stop() {
+    running_ = false;
+  }
+
+  /**
+   * @brief Change the period of the task
+   * @param period Period in ms
+   */
+  void setPeriod(unsigned long period) {
+    period_ = period;
+  }
+
+  /**
+   * @brief Run the task if it is due
+   * @param now Current time in ms
+   * @return true if the task was run, otherwise false
+   */
+  bool poll(unsigned long now) {
+    if(!running_ || now - last_run_ < period_) return false;
+
+    // Keep the phase of the task unless it fell behind by more than a period
+    last_run_ = (now - last_run_ < 2 * period_) ? last_run_ + period_ : now;
+    callback_();
+    return true;
+  }
+
+  /**
+   * @brief Check whether the task is running
+   * @return true if the task is running, otherwise false
+   */
+  bool running() const {
+    return running_;
+  }
+};
+
+/**
+ * @brief Hooks of a scheduler state
+ * @remark Each hook may be nullptr
+ */
+struct StateHooks {
+  void (*enter)(); //!< Called once when the state is entered
+  void (*tick)();  //!< Called on every scheduler tick while the state is active
+  void (*exit)();  //!< Called once when the state is left
+};
+
+/**
+ * @brief Cooperative tick scheduler with a state machine and periodic tasks
+ * @tparam kMaxTasks Maximum number of periodic tasks
+ * @remark Nothing in here blocks. Hooks and tasks must return quickly so that
+ * sampling, display refresh and serial I/O can interleave.
+ */
+template<int kMaxTasks> class Scheduler {
+  const ClockSource clock_;
+  const StateHooks* const states_;
+  const int state_count_;
+  PeriodicTask* tasks_[kMaxTasks];
+  int task_count_;
+  int current_;
+  int next_;
+  unsigned long now_;
+  unsigned long state_start_;
+
+  void enterState(int state) {
+    current_ = state;
+    next_ = state;
+    state_start_ = now_;
+    if(states_[current_].enter) states_[current_].enter();
+  }
+public:
+  /**
+   * @brief Initialize the scheduler
+   * @param clock Clock source
+   * @param states State table, indexed by state number
+   * @param state_count Number of states in the table
+   */
+  Scheduler(ClockSource clock, const StateHooks* states, int state_count) :
+    clock_(clock),
+    states_(states),
+    state_count_(state_count),
+    task_count_(0),
+    current_(-1),
+    next_(-1),
+    now_(0),
+    state_start_(0){}
+
+  /**
+   * @brief Register a periodic task
+   * @param task Task to run from the tick
+   * @return true if successful, otherwise false
+   */
+  bool addTask(PeriodicTask& task) {
+    if(task_count_ >= kMaxTasks) return false;
+    tasks_[task_count_++] = &task;
+    return true;
+  }
+
+  /**
+   * @brief Enter the initial state
+   * @param state Initial state
+   */
+  void begin(int state) {
+    now_ = clock_();
+    enterState(state);
+  }
+
+  /**
+   * @brief Request a state change
+   * @param state Next state
+   * @remark The change is applied at the end of the current tick
+   */
+  void transition(int state) {
+    if(state >= 0 && state < state_count_) next_ = state;
+  }
+
+  /**
+   * @brief Run one scheduler tick
+   */
+  void tick() {
+    now_ = clock_();
+
+    for(int i = 0; i < task_count_; i++) {
+      tasks_[i]->poll(now_);
+    }
+
+    if(current_ < 0) return;
+    if(states_[current_].tick) states_[current_].tick();
+
+    if(next_ != current_) {
+      if(states_[current_].exit) states_[current_].exit();
+      enterState(next_);
+    }
+  }
+
+  /**
+   * @brief Get the current state
+   * @return Current state
+   */
+  int state() const {
+    return current_;
+  }
+
+  /**
+   * @brief Get the time of the current tick
+   * @return Time in ms
+   */
+  unsigned long now() const {
+    return now_;
+  }
+
+  /**
+   * @brief Get the time spent in the current state
+   * @return Time in ms
+   */
+  unsigned long elapsed() const {
+    return now_ - state_start_;
+  }
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,94 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * @brief Lock-free single-producer single-consumer queue
+ * @tparam T Element type
+ * @tparam kCapacity Maximum number of stored elements, must be a power of two
+ * @remark push() may only be called from one task and pop() from one other task.
+ * Nothing in here depends on Arduino or FreeRTOS so the queue also builds on a host.
+ */
+template<typename T, size_t kCapacity> class SpscQueue {
+  static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+
+  T values_[kCapacity];
+  std::atomic<size_t> head_;
+  std::atomic<size_t> tail_;
+  std::atomic<unsigned long> dropped_;
+public:
+  /**
+   * @brief Initialize the queue
+   */
+  SpscQueue() :
+    head_(0),
+    tail_(0),
+    dropped_(0){}
+
+  /**
+   * @brief Append a value (producer side)
+   * @param value Value to append
+   * @return true if successful, false if the queue was full and the value was dropped
+   */
+  bool push(const T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if(head - tail_.load(std::memory_order_acquire) >= kCapacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    values_[head & (kCapacity - 1)] = value;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest value (consumer side)
+   * @param value Reference to store the value in
+   * @return true if a value was available, otherwise false
+   */
+  bool pop(T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail == head_.load(std::memory_order_acquire)) return false;
+
+    value = values_[tail & (kCapacity - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Discard all stored values (consumer side)
+   */
+  void clear() {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  /**
+   * @brief Get number of stored values
+   * @return Number of stored values
+   * @remark Only a snapshot while the other side is active
+   */
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Check whether the queue is empty
+   * @return true if empty, otherwise false
+   */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * @brief Get number of values dropped because the queue was full
+   * @return Number of dropped values
+   */
+  unsigned long dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+};
+
+#endif // SPSC_QUEUE_H
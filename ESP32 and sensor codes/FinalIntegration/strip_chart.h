@@ -0,0 +1,152 @@
+#ifndef STRIP_CHART_H
+#define STRIP_CHART_H
+
+#include <stdint.h>
+#include <Adafruit_GFX.h>
+
+/**
+ * @brief Sweeping strip chart of one signal on a monochrome Adafruit_GFX display
+ * @remark Like the sweep of an ECG monitor, the trace is written one column at a time
+ * from left to right and wraps around, a few cleared columns ahead of it separate the
+ * new trace from the old one. Every column only touches itself and the cleared column,
+ * so together with the dirty windows of Adafruit_SSD1306 a frame only sends the columns
+ * drawn since the previous one. Each column spans the minimum and maximum of its samples
+ * and connects to the previous column, steep QRS complexes stay visible.
+ * The vertical scale follows the range of the previous sweep.
+ */
+class StripChart {
+  Adafruit_GFX& gfx_;
+  const int16_t x_;
+  const int16_t y_;
+  const int16_t width_;
+  const int16_t height_;
+  const uint16_t samples_per_column_;
+  const int16_t min_span_;
+  const int16_t gap_;
+  const uint16_t foreground_;
+  const uint16_t background_;
+
+  int16_t column_;
+  uint16_t count_;
+  int16_t column_min_;
+  int16_t column_max_;
+  int16_t last_row_;
+
+  // Scale of the current sweep and range seen in it
+  bool scaled_;
+  int16_t low_;
+  int16_t high_;
+  int16_t sweep_min_;
+  int16_t sweep_max_;
+
+  void reset() {
+    column_ = 0;
+    count_ = 0;
+    column_min_ = 0;
+    column_max_ = 0;
+    last_row_ = -1;
+    scaled_ = false;
+    low_ = 0;
+    high_ = 0;
+    sweep_min_ = INT16_MAX;
+    sweep_max_ = INT16_MIN;
+  }
+
+  int16_t row(int16_t value) const {
+    int16_t low = low_, high = high_;
+    if(!scaled_) {
+      // First sweep, scale to what has been seen so far
+      low = sweep_min_ < column_min_ ? sweep_min_ : column_min_;
+      high = sweep_max_ > column_max_ ? sweep_max_ : column_max_;
+    }
+    if(high - low < min_span_) {
+      int16_t middle = low + (high - low) / 2;
+      low = middle - min_span_ / 2;
+      high = low + min_span_;
+    }
+    if(value <= low) return y_ + height_ - 1;
+    if(value >= high) return y_;
+    return y_ + height_ - 1 - (int16_t)((int32_t)(value - low) * (height_ - 1) / (high - low));
+  }
+
+  void drawColumn() {
+    int16_t top = row(column_max_);
+    int16_t bottom = row(column_min_);
+    if(last_row_ >= 0) {
+      if(last_row_ < top) top = last_row_;
+      if(last_row_ > bottom) bottom = last_row_;
+    }
+    gfx_.drawFastVLine(x_ + column_, y_, height_, background_);
+    gfx_.drawFastVLine(x_ + column_, top, bottom - top + 1, foreground_);
+    gfx_.drawFastVLine(x_ + (column_ + gap_) % width_, y_, height_, background_);
+    last_row_ = row((int16_t)(column_min_ + (column_max_ - column_min_) / 2));
+
+    if(column_min_ < sweep_min_) sweep_min_ = column_min_;
+    if(column_max_ > sweep_max_) sweep_max_ = column_max_;
+    if(++column_ < width_) return;
+
+    // Next sweep uses the range of this one
+    column_ = 0;
+    scaled_ = true;
+    low_ = sweep_min_;
+    high_ = sweep_max_;
+    sweep_min_ = INT16_MAX;
+    sweep_max_ = INT16_MIN;
+    last_row_ = -1;
+  }
+public:
+  /**
+   * @brief Initialize the chart
+   * @param gfx Display to draw on
+   * @param x Left edge of the chart area
+   * @param y Top edge of the chart area
+   * @param width Width of the chart area in columns
+   * @param height Height of the chart area in rows
+   * @param samplesPerColumn Samples drawn as one column, sets the sweep speed
+   * @param minSpan Smallest range of values shown over the full height, keeps a flat
+   * line (leads off, saturated amplifier) from blowing up the noise
+   * @param gap Cleared columns ahead of the trace
+   * @param foreground Color of the trace
+   * @param background Color of the chart area
+   */
+  StripChart(Adafruit_GFX& gfx, int16_t x, int16_t y, int16_t width, int16_t height,
+             uint16_t samplesPerColumn, int16_t minSpan, int16_t gap = 4,
+             uint16_t foreground = 1, uint16_t background = 0) :
+    gfx_(gfx),
+    x_(x),
+    y_(y),
+    width_(width),
+    height_(height),
+    samples_per_column_(samplesPerColumn),
+    min_span_(minSpan),
+    gap_(gap),
+    foreground_(foreground),
+    background_(background){
+    reset();
+  }
+
+  /**
+   * @brief Clear the chart area and start a new trace at the left edge
+   * @remark Call before the first add(), the display has to be initialized
+   */
+  void begin() {
+    gfx_.fillRect(x_, y_, width_, height_, background_);
+    reset();
+  }
+
+  /**
+   * @brief Add a sample
+   * @param value Sample value
+   * @return true if a column was drawn and the display should be refreshed
+   */
+  bool add(int16_t value) {
+    if(count_ == 0 || value < column_min_) column_min_ = value;
+    if(count_ == 0 || value > column_max_) column_max_ = value;
+    if(++count_ < samples_per_column_) return false;
+    drawColumn();
+    count_ = 0;
+    return true;
+  }
+};
+
+#endif // STRIP_CHART_H
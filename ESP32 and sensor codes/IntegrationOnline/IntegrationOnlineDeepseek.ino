@@ -5,6 +5,7 @@
 #include <Adafruit_MLX90614.h>
 #include "MAX30105.h"
 #include "filters.h"
+#include "sample_arena.h"
 
 // ----- OLED Settings -----
 #define SCREEN_WIDTH 128
@@ -44,7 +45,9 @@ const float kSpO2_C = 112.6898759;
 enum SensorState { WAIT_PATIENT, WEIGHT, SPO2, TEMP, ECG, IDLE };
 SensorState currentState = WAIT_PATIENT;
 unsigned long stateStartTime = 0;
-String ecgData = "";
+const uint32_t kEcgSampleRateHz = 50;
+const unsigned long kEcgWindowMs = 30000;
+SampleArena<samplesFor(kEcgSampleRateHz, kEcgWindowMs)> ecgSamples;
 String patientID = "";
 String patientName = "";
 
@@ -259,16 +262,13 @@ void loop() {
     // Notify Python script to start capturing ECG data
     Serial.println("ECG_START");
     
-    ecgData = "";
+    ecgSamples.reset();
     unsigned long startTime = millis();
-    while (millis() - startTime < 30000) {  // 30-second measurement window
+    while (millis() - startTime < kEcgWindowMs) {  // 30-second measurement window
       int ecgValue = analogRead(ECG_PIN);
       Serial.println(ecgValue);
-      ecgData += String(ecgValue) + ",";
-      delay(20);  // ~50Hz sampling rate
-    }
-    if (ecgData.endsWith(",")) {
-      ecgData.remove(ecgData.length() - 1);
+      ecgSamples.append(ecgValue);
+      delay(1000 / kEcgSampleRateHz);  // ~50Hz sampling rate
     }
     
     // After ECG, send end marker along with final vitals (in case any update is needed)
@@ -5,6 +5,7 @@
 #include "spo2_algorithm.h"
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include "sample_arena.h"
 
 // OLED Configuration
 #define SCREEN_WIDTH 128
@@ -30,6 +31,8 @@ PubSubClient client(espClient);
 // ECG Configuration
 const int ECG_PIN = 35;
 const int ECG_DURATION = 15000; // 15 seconds
+const int ECG_SAMPLE_RATE = 50; // Hz
+SampleArena<samplesFor(ECG_SAMPLE_RATE, ECG_DURATION)> ecgSamples;
 
 // State Machine Variables
 enum State { TEMP, SPO2, ECG, IDLE };
@@ -39,12 +42,13 @@ unsigned long stateStartTime;
 // MQTT Payload Buffers
 char payload[700];
 char topic[150];
+char ecgCsv[500];
 
 // Function Prototypes
 void initializeOLED();
 void connectToWiFi();
 void initializeMQTT();
-void publishData(float temp, int bpm, int spo2, String ecgData);
+void publishData(float temp, int bpm, int spo2, const char* ecgData);
 void handleTemperature();
 void handleSpO2();
 void handleECG();
@@ -139,12 +143,12 @@ void initializeMQTT() {
 }
 
 // Publish Data to Ubidots
-void publishData(float temp, int bpm, int spo2, String ecgData) {
+void publishData(float temp, int bpm, int spo2, const char* ecgData) {
     if (!client.connected()) client.connect("ESP32Client", token, "");
 
     sprintf(topic, "/v1.6/devices/%s", device_label);
 
-    sprintf(payload,
+    snprintf(payload, sizeof(payload),
             "{\"temperature\":{\"value\":%.2f},"
             "\"bpm\":{\"value\":%d},"
             "\"spo2\":{\"value\":%d},"
@@ -152,7 +156,7 @@ void publishData(float temp, int bpm, int spo2, String ecgData) {
             temp,
             bpm,
             spo2,
-            ecgData.c_str());
+            ecgData);
 
     client.publish(topic, payload);
 }
@@ -238,13 +242,12 @@ void handleSpO2() {
 
 // Handle ECG Measurement
 void handleECG() {
-    static String ecgData;
     static unsigned long startTime;
     static bool initialized = false;
 
     // Initialize on first entry to function
     if (!initialized) {
-        ecgData = "";
+        ecgSamples.reset();
         startTime = millis();
         initialized = true;
         
@@ -255,20 +258,16 @@ void handleECG() {
     }
 
     if (millis() - stateStartTime < ECG_DURATION) {
-        if (millis() - startTime > 20) { // Sample at ~50Hz
-            ecgData += String(analogRead(ECG_PIN)) + ",";
+        if (millis() - startTime > 1000 / ECG_SAMPLE_RATE) { // Sample at ~50Hz
+            ecgSamples.append(analogRead(ECG_PIN));
             startTime = millis();
         }
         return;
     }
 
-    // Remove last comma if string is not empty
-    if (ecgData.length() > 0) {
-        ecgData.remove(ecgData.length() - 1);
-    }
-
-    // Publish ECG data
-    publishData(0.0f /* Temp */, 0 /* BPM */, 0 /* SpO2 */, ecgData);
+    // Publish as much of the ECG as fits into the payload
+    ecgSamples.formatCSV(ecgCsv, sizeof(ecgCsv));
+    publishData(0.0f /* Temp */, 0 /* BPM */, 0 /* SpO2 */, ecgCsv);
     
     // Show completion message
     showCompletionMessage();
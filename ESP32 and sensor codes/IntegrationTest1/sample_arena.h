@@ -0,0 +1,184 @@
+#ifndef SAMPLE_ARENA_H
+#define SAMPLE_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <Print.h>
+
+/**
+ * @brief Number of samples recorded at a given rate for a given duration
+ * @param rate Sampling rate in Hz
+ * @param duration Recording duration in ms
+ * @return Number of samples
+ */
+constexpr size_t samplesFor(uint32_t rate, uint32_t duration) {
+  return (size_t)((uint64_t)rate * duration / 1000);
+}
+
+/**
+ * @brief Preallocated arena of 16 bit samples
+ * @tparam kCapacity Maximum number of samples, see samplesFor()
+ * @remark Appending never allocates. The recording is only converted to text or
+ * bytes when it is serialized.
+ */
+template<size_t kCapacity> class SampleArena {
+  int16_t samples_[kCapacity];
+  size_t count_;
+  unsigned long overflows_;
+
+  static size_t writeVarint(Print& out, uint16_t value) {
+    size_t written = 0;
+    while(value >= 0x80) {
+      written += out.write((uint8_t)(value | 0x80));
+      value >>= 7;
+    }
+    return written + out.write((uint8_t)value);
+  }
+public:
+  /**
+   * @brief Initialize the arena
+   */
+  SampleArena() :
+    count_(0),
+    overflows_(0){}
+
+  /**
+   * @brief Append a sample
+   * @param value Sample to append
+   * @return true if successful, false if the arena was full and the sample was dropped
+   */
+  bool append(int16_t value) {
+    if(count_ >= kCapacity) {
+      overflows_++;
+      return false;
+    }
+    samples_[count_++] = value;
+    return true;
+  }
+
+  /**
+   * @brief Resets the stored samples and the overflow counter
+   */
+  void reset() {
+    count_ = 0;
+    overflows_ = 0;
+  }
+
+  /**
+   * @brief Get number of stored samples
+   * @return Number of stored samples
+   */
+  size_t size() const {
+    return count_;
+  }
+
+  /**
+   * @brief Get maximum number of samples
+   * @return Capacity in samples
+   */
+  static constexpr size_t capacity() {
+    return kCapacity;
+  }
+
+  /**
+   * @brief Get number of samples dropped because the arena was full
+   * @return Number of dropped samples
+   */
+  unsigned long overflows() const {
+    return overflows_;
+  }
+
+  /**
+   * @brief Get a stored sample
+   * @param index Sample index, must be less than size()
+   * @return Sample
+   */
+  int16_t operator[](size_t index) const {
+    return samples_[index];
+  }
+
+  /**
+   * @brief Get the stored samples
+   * @return Pointer to the first sample
+   */
+  const int16_t* data() const {
+    return samples_;
+  }
+
+  /**
+   * @brief Write the samples as comma separated text
+   * @param out Output stream
+   * @return Number of bytes written
+   */
+  size_t writeCSV(Print& out) const {
+    size_t written = 0;
+    for(size_t i = 0; i < count_; i++) {
+      if(i > 0) written += out.write(',');
+      written += out.print(samples_[i]);
+    }
+    return written;
+  }
+
+  /**
+   * @brief Format the samples as comma separated text into a buffer
+   * @param buffer Output buffer, always null terminated
+   * @param size Size of the output buffer
+   * @return Number of samples that fit into the buffer
+   */
+  size_t formatCSV(char* buffer, size_t size) const {
+    if(size == 0) return 0;
+
+    size_t length = 0;
+    size_t i = 0;
+    buffer[0] = '\0';
+    for(; i < count_; i++) {
+      char value[8];
+      int value_length = snprintf(value, sizeof(value), i > 0 ? ",%d" : "%d", samples_[i]);
+      if(length + value_length >= size) break;
+      memcpy(buffer + length, value, value_length + 1);
+      length += value_length;
+    }
+    return i;
+  }
+
+  /**
+   * @brief Write the samples as raw little endian 16 bit values
+   * @param out Output stream
+   * @return Number of bytes written
+   */
+  size_t writeBinary(Print& out) const {
+    size_t written = 0;
+    for(size_t i = 0; i < count_; i++) {
+      uint16_t value = (uint16_t)samples_[i];
+      written += out.write((uint8_t)(value & 0xFF));
+      written += out.write((uint8_t)(value >> 8));
+    }
+    return written;
+  }
+
+  /**
+   * @brief Write the samples delta encoded
+   * @param out Output stream
+   * @return Number of bytes written
+   * @remark The first sample is written as little endian 16 bit value, each following
+   * sample as the zigzag encoded difference to its predecessor in 7 bit groups
+   * (LSB first, MSB of each byte set if another byte follows). Slowly changing
+   * signals such as the ECG mostly need one byte per sample.
+   */
+  size_t writeDelta(Print& out) const {
+    if(count_ == 0) return 0;
+
+    uint16_t first = (uint16_t)samples_[0];
+    size_t written = out.write((uint8_t)(first & 0xFF));
+    written += out.write((uint8_t)(first >> 8));
+    for(size_t i = 1; i < count_; i++) {
+      int16_t delta = (int16_t)(samples_[i] - samples_[i - 1]);
+      written += writeVarint(out, (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15)));
+    }
+    return written;
+  }
+};
+
+#endif // SAMPLE_ARENA_H
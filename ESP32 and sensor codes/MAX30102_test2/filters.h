@@ -1,6 +1,9 @@
 #ifndef FILTERS_H
 #define FILTERS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /**
  * @brief Statistic block for min/nax/avg
  */
@@ -64,6 +67,129 @@ public:
  }
 };
 
+/**
+ * @brief Sliding window statistic block for min/max/avg
+ * @tparam kCapacity Window length in samples
+ * @remark Unlike MinMaxAvgStatistic the oldest sample leaves the window when a
+ * new one arrives, so no reset is needed between beats. Minimum and maximum are
+ * tracked with monotonic queues, every update is amortized O(1).
+ */
+template<int kCapacity> class SlidingMinMaxAvgStatistic {
+ static_assert(kCapacity > 0 && kCapacity <= 65535, "kCapacity must fit into 16 bit positions");
+
+ float values_[kCapacity];
+ uint16_t min_queue_[kCapacity]; // Positions of increasing values, front is the minimum
+ uint16_t max_queue_[kCapacity]; // Positions of decreasing values, front is the maximum
+ int min_head_;
+ int min_size_;
+ int max_head_;
+ int max_size_;
+ int index_;
+ int count_;
+ int updates_;
+ float sum_;
+
+ void push(uint16_t* queue, int head, int& size, int position, bool minimum) {
+  // Drop values that can never become the minimum/maximum again
+  while(size > 0) {
+   float back = values_[queue[(head + size - 1) % kCapacity]];
+   if(minimum ? back < values_[position] : back > values_[position]) break;
+   size--;
+  }
+  queue[(head + size) % kCapacity] = position;
+  size++;
+ }
+
+ void expire(uint16_t* queue, int& head, int& size, int position) {
+  if(size > 0 && queue[head] == position) {
+   head = (head + 1) % kCapacity;
+   size--;
+  }
+ }
+public:
+ /**
+  * @brief Initialize the Statistic block
+  */
+ SlidingMinMaxAvgStatistic() {
+  reset();
+ }
+
+ /**
+  * @brief Add value to the statistic, replacing the oldest one if the window is full
+  */
+ void process(float value) {
+  if(count_ == kCapacity) {
+   expire(min_queue_, min_head_, min_size_, index_);
+   expire(max_queue_, max_head_, max_size_, index_);
+   sum_ -= values_[index_];
+  }
+  else {
+   count_++;
+  }
+
+  values_[index_] = value;
+  sum_ += value;
+  push(min_queue_, min_head_, min_size_, index_, true);
+  push(max_queue_, max_head_, max_size_, index_, false);
+  index_ = (index_ + 1) % kCapacity;
+
+  // Remove the float rounding drift of the running sum once per window
+  if(++updates_ >= kCapacity) {
+   sum_ = 0;
+   for(int i = 0; i < count_; i++) {
+    sum_ += values_[i];
+   }
+   updates_ = 0;
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  min_head_ = 0;
+  min_size_ = 0;
+  max_head_ = 0;
+  max_size_ = 0;
+  index_ = 0;
+  count_ = 0;
+  updates_ = 0;
+  sum_ = 0;
+ }
+
+ /**
+  * @brief Get Minimum
+  * @return Minimum Value of the window
+  */
+ float minimum() const {
+  return min_size_ > 0 ? values_[min_queue_[min_head_]] : NAN;
+ }
+
+ /**
+  * @brief Get Maximum
+  * @return Maximum Value of the window
+  */
+ float maximum() const {
+  return max_size_ > 0 ? values_[max_queue_[max_head_]] : NAN;
+ }
+
+ /**
+  * @brief Get Average
+  * @return Average Value of the window
+  */
+ float average() const {
+  return sum_/count_;
+ }
+
+ /**
+  * @brief Get number of samples
+  * @return Number of samples in the window
+  */
+ int count() const {
+  return count_;
+ }
+};
+
 /**
  * @brief High Pass Filter 
  */
@@ -114,6 +240,35 @@ public:
   return last_filter_value_;
  }
 
+ /**
+  * @brief Applies the high pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const float* in, float* out, size_t n) {
+  if(n == 0) return;
+
+  size_t i = 0;
+  if(isnan(last_filter_value_) || isnan(last_raw_value_)) {
+   last_filter_value_ = 0.0;
+   last_raw_value_ = in[0];
+   out[0] = 0.0;
+   i = 1;
+  }
+
+  float last_raw = last_raw_value_;
+  float last_filter = last_filter_value_;
+  for(; i < n; i++) {
+   float value = in[i];
+   last_filter = kA0 * value + kA1 * last_raw + kB1 * last_filter;
+   last_raw = value;
+   out[i] = last_filter;
+  }
+  last_raw_value_ = last_raw;
+  last_filter_value_ = last_filter;
+ }
+
  /**
   * @brief Resets the stored values
   */
@@ -164,6 +319,30 @@ public:
   return last_value_;
  }
 
+ /**
+  * @brief Applies the low pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const float* in, float* out, size_t n) {
+  if(n == 0) return;
+
+  size_t i = 0;
+  if(isnan(last_value_)) {
+   last_value_ = in[0];
+   out[0] = last_value_;
+   i = 1;
+  }
+
+  float last_value = last_value_;
+  for(; i < n; i++) {
+   last_value = kA0 * in[i] + kB1 * last_value;
+   out[i] = last_value;
+  }
+  last_value_ = last_value;
+ }
+
  /**
   * @brief Resets the stored values
   */
@@ -195,6 +374,22 @@ public:
    return diff;
  }
 
+ /**
+  * @brief Applies the differentiator to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const float* in, float* out, size_t n) {
+  float last_value = last_value_;
+  for(size_t i = 0; i < n; i++) {
+   float value = in[i];
+   out[i] = (value-last_value)*kSamplingFrequency;
+   last_value = value;
+  }
+  last_value_ = last_value;
+ }
+
  /**
   * @brief Resets the stored values
   */
@@ -203,43 +398,346 @@ public:
  }
 };
 
+/**
+ * @brief Q15 fixed point format (16 bit samples, 32 bit accumulator)
+ */
+struct Q15 {
+ typedef int16_t Sample;
+ typedef int32_t Accumulator;
+ static const int kFractionBits = 15;
+};
+
+/**
+ * @brief Q31 fixed point format (32 bit samples, 64 bit accumulator)
+ */
+struct Q31 {
+ typedef int32_t Sample;
+ typedef int64_t Accumulator;
+ static const int kFractionBits = 31;
+};
+
+/**
+ * @brief Fixed point arithmetic helpers
+ * @tparam Q Fixed point format (Q15 or Q31)
+ */
+template<typename Q> struct FixedPoint {
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ static const Sample kMax = (Sample)(((uint64_t)1 << (sizeof(Sample) * 8 - 1)) - 1);
+ static const Sample kMin = -kMax - 1;
+
+ /**
+  * @brief Converts a coefficient in [-1, 1) to fixed point
+  */
+ static Sample coefficient(float value) {
+  float scaled = value * (float)((uint64_t)1 << Q::kFractionBits);
+  if(scaled >= (float)kMax) return kMax;
+  if(scaled <= (float)kMin) return kMin;
+  return (Sample)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+ }
+
+ /**
+  * @brief Rounds a product sum back to the sample scale and saturates it
+  */
+ static Sample narrow(Accumulator value) {
+  value = (value + ((Accumulator)1 << (Q::kFractionBits - 1))) >> Q::kFractionBits;
+  return saturate(value);
+ }
+
+ /**
+  * @brief Saturates a value to the sample range
+  */
+ static Sample saturate(Accumulator value) {
+  if(value > kMax) return kMax;
+  if(value < kMin) return kMin;
+  return (Sample)value;
+ }
+};
+
+/**
+ * @brief Fixed point High Pass Filter
+ * @tparam Q Fixed point format (Q15 or Q31)
+ * @remark Same response as HighPassFilter, samples are integers and the
+ * coefficients are stored as Q15/Q31 fractions. Keep one bit of headroom in the input.
+ */
+template<typename Q> class HighPassFilterFixed {
+ typedef FixedPoint<Q> FP;
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ const Sample kA0;
+ const Sample kB1;
+ Sample last_filter_value_;
+ Sample last_raw_value_;
+ bool valid_;
+public:
+ /**
+  * @brief Initialize the High Pass Filter
+  * @param samples Number of samples until decay to 36.8 %
+  * @remark Sample number is an RC time-constant equivalent
+  */
+ HighPassFilterFixed(float samples) :
+  kA0(FP::coefficient((1+exp(-1/samples))/2)),
+  kB1(FP::coefficient(exp(-1/samples))),
+  last_filter_value_(0),
+  last_raw_value_(0),
+  valid_(false){}
+
+ /**
+  * @brief Initialize the High Pass Filter
+  * @param cutoff Cutoff frequency
+  * @pram sampling_frequency Sampling frequency
+  */
+ HighPassFilterFixed(float cutoff, float sampling_frequency) :
+  HighPassFilterFixed(sampling_frequency/(cutoff*2*PI)){}
+
+ /**
+  * @brief Applies the high pass filter
+  */
+ Sample process(Sample value) {
+  if(!valid_) {
+   last_filter_value_ = 0;
+   valid_ = true;
+  }
+  else {
+   // kA1 is -kA0
+   last_filter_value_ = FP::narrow(
+    (Accumulator)kA0 * ((Accumulator)value - last_raw_value_)
+    + (Accumulator)kB1 * last_filter_value_);
+  }
+  last_raw_value_ = value;
+  return last_filter_value_;
+ }
+
+ /**
+  * @brief Applies the high pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const Sample* in, Sample* out, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+   out[i] = process(in[i]);
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  valid_ = false;
+ }
+};
+
+/**
+ * @brief Fixed point Low Pass Filter
+ * @tparam Q Fixed point format (Q15 or Q31)
+ * @remark Same response as LowPassFilter, samples are integers and the
+ * coefficients are stored as Q15/Q31 fractions
+ */
+template<typename Q> class LowPassFilterFixed {
+ typedef FixedPoint<Q> FP;
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ const Sample kA0;
+ const Sample kB1;
+ Sample last_value_;
+ bool valid_;
+public:
+ /**
+  * @brief Initialize the Low Pass Filter
+  * @param samples Number of samples until decay to 36.8 %
+  * @remark Sample number is an RC time-constant equivalent
+  */
+ LowPassFilterFixed(float samples) :
+  kA0(FP::coefficient(1-exp(-1/samples))),
+  kB1(FP::coefficient(exp(-1/samples))),
+  last_value_(0),
+  valid_(false){}
+
+ /**
+  * @brief Initialize the Low Pass Filter
+  * @param cutoff Cutoff frequency
+  * @pram sampling_frequency Sampling frequency
+  */
+ LowPassFilterFixed(float cutoff, float sampling_frequency) :
+  LowPassFilterFixed(sampling_frequency/(cutoff*2*PI)){}
+
+ /**
+  * @brief Applies the low pass filter
+  */
+ Sample process(Sample value) {
+  if(!valid_) {
+   last_value_ = value;
+   valid_ = true;
+  }
+  else {
+   last_value_ = FP::narrow((Accumulator)kA0 * value + (Accumulator)kB1 * last_value_);
+  }
+  return last_value_;
+ }
+
+ /**
+  * @brief Applies the low pass filter to a block of samples
+  * @param in Input samples
+  * @param out Output samples, may be the same buffer as in
+  * @param n Number of samples
+  */
+ void process(const Sample* in, Sample* out, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+   out[i] = process(in[i]);
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  valid_ = false;
+ }
+};
+
+/**
+ * @brief Fixed point Differentiator
+ * @tparam Q Fixed point format (Q15 or Q31)
+ * @remark The first sample after a reset yields 0 instead of NaN. The output is the
+ * difference times the sampling frequency in the accumulator type, exact for any step at
+ * sampling frequencies up to 32 kHz. A sample would saturate on steps above full scale /
+ * sampling frequency.
+ */
+template<typename Q> class DifferentiatorFixed {
+ typedef typename Q::Sample Sample;
+ typedef typename Q::Accumulator Accumulator;
+
+ const Accumulator kSamplingFrequency;
+ Sample last_value_;
+ bool valid_;
+public:
+ /**
+  * @brief Initializes the differentiator
+  */
+ DifferentiatorFixed(float sampling_frequency) :
+  kSamplingFrequency((Accumulator)(sampling_frequency + 0.5f)),
+  last_value_(0),
+  valid_(false){}
+
+ /**
+  * @brief Applies the differentiator
+  */
+ Accumulator process(Sample value) {
+  Accumulator diff = valid_ ? ((Accumulator)value - last_value_) * kSamplingFrequency : 0;
+  last_value_ = value;
+  valid_ = true;
+  return diff;
+ }
+
+ /**
+  * @brief Applies the differentiator to a block of samples
+  * @param in Input samples
+  * @param out Output values
+  * @param n Number of samples
+  */
+ void process(const Sample* in, Accumulator* out, size_t n) {
+  for(size_t i = 0; i < n; i++) {
+   out[i] = process(in[i]);
+  }
+ }
+
+ /**
+  * @brief Resets the stored values
+  */
+ void reset() {
+  valid_ = false;
+ }
+};
+
+typedef HighPassFilterFixed<Q15> HighPassFilterQ15;
+typedef HighPassFilterFixed<Q31> HighPassFilterQ31;
+typedef LowPassFilterFixed<Q15> LowPassFilterQ15;
+typedef LowPassFilterFixed<Q31> LowPassFilterQ31;
+typedef DifferentiatorFixed<Q15> DifferentiatorQ15;
+typedef DifferentiatorFixed<Q31> DifferentiatorQ31;
+
+/**
+ * @brief Running sum type of the MovingAverageFilter
+ * @remark Integer samples are summed exactly, float sums accumulate rounding
+ * errors and are recomputed periodically
+ */
+template<typename T> struct MovingAverageSum {
+ typedef float Type;
+ static const bool kExact = false;
+};
+
+template<> struct MovingAverageSum<int16_t> {
+ typedef int32_t Type;
+ static const bool kExact = true;
+};
+
+template<> struct MovingAverageSum<int32_t> {
+ typedef int64_t Type;
+ static const bool kExact = true;
+};
+
 /**
  * @brief MovingAverageFilter
  * @tparam buffer_size Number of samples to average over
+ * @tparam T Sample type, e.g. int16_t for long ECG windows (float, int16_t or int32_t)
+ * @remark Keeps a running sum so that each sample costs O(1) regardless of the
+ * window size. A float sum is recomputed from the buffer once every
+ * kResyncPeriod samples to remove the accumulated rounding error.
  */
-template<int kBufferSize> class MovingAverageFilter {
+template<int kBufferSize, typename T = float> class MovingAverageFilter {
+ typedef typename MovingAverageSum<T>::Type Sum;
+ static const int kResyncPeriod = kBufferSize < 256 ? 256 : kBufferSize;
+
  int index_;
  int count_;
- float values_[kBufferSize];
+ int updates_;
+ Sum sum_;
+ T values_[kBufferSize];
+
+ void resync() {
+  Sum sum = 0;
+  for(int i = 0; i < count_; i++) {
+   sum += values_[i];
+  }
+  sum_ = sum;
+  updates_ = 0;
+ }
 public:
  /**
   * @brief Initalize moving average filter
   */
  MovingAverageFilter() :
   index_(0),
-  count_(0){}
+  count_(0),
+  updates_(0),
+  sum_(0){}
 
  /**
   * @brief Applies the moving average filter
   */
- float process(float value) {  
-   // Add value
-   values_[index_] = value;
-
-   // Increase index and count
-   index_ = (index_ + 1) % kBufferSize;
+ float process(T value) {  
+   // Replace the oldest value once the buffer is full
    if(count_ < kBufferSize) {
     count_++;  
    }
+   else {
+    sum_ -= values_[index_];
+   }
+   values_[index_] = value;
+   sum_ += value;
+   index_ = (index_ + 1) % kBufferSize;
 
-   // Calculate sum
-   float sum = 0.0;
-   for(int i = 0; i < count_; i++) {
-     sum += values_[i];
+   // Remove the float rounding drift, amortized O(1)
+   if(!MovingAverageSum<T>::kExact && ++updates_ >= kResyncPeriod) {
+    resync();
    }
 
    // Calculate average
-   return sum/count_;
+   return (float)sum_/count_;
  }
 
  /**
@@ -248,6 +746,8 @@ public:
  void reset() {
   index_ = 0;
   count_ = 0;
+  updates_ = 0;
+  sum_ = 0;
  }
 
  /**
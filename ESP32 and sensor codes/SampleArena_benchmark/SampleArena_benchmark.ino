@@ -0,0 +1,71 @@
+// Compares the String based ECG recording with the preallocated sample arena.
+// Reports time per sample and the heap high-water mark of both on the ESP32.
+#include "sample_arena.h"
+
+const uint32_t kRateHz = 250;
+const unsigned long kWindowMs = 30000;
+const size_t kSamples = samplesFor(kRateHz, kWindowMs);
+
+SampleArena<kSamples> arena;
+
+// Discards everything, used to time the serializers without the UART
+class NullPrint : public Print {
+public:
+  size_t write(uint8_t) override { return 1; }
+};
+
+// Synthetic ECG-like input so that every run sees the same values
+int16_t syntheticSample(size_t i) {
+  return 512 + (int16_t)((i * 37) % 200) - 100;
+}
+
+void report(const char* name, unsigned long elapsed, size_t samples, uint32_t heapBefore) {
+  Serial.printf("%-8s %7.3f us/sample, free heap %u -> min %u, largest block %u\n",
+                name, (float)elapsed / samples, heapBefore, ESP.getMinFreeHeap(),
+                ESP.getMaxAllocHeap());
+}
+
+void benchmarkArena() {
+  uint32_t heapBefore = ESP.getFreeHeap();
+  unsigned long start = micros();
+  arena.reset();
+  for (size_t i = 0; i < kSamples; i++) {
+    arena.append(syntheticSample(i));
+  }
+  report("arena", micros() - start, kSamples, heapBefore);
+
+  NullPrint sink;
+  start = micros();
+  size_t bytes = arena.writeCSV(sink);
+  Serial.printf("  csv    %6u bytes in %lu us\n", bytes, micros() - start);
+  start = micros();
+  bytes = arena.writeBinary(sink);
+  Serial.printf("  binary %6u bytes in %lu us\n", bytes, micros() - start);
+  start = micros();
+  bytes = arena.writeDelta(sink);
+  Serial.printf("  delta  %6u bytes in %lu us\n", bytes, micros() - start);
+}
+
+void benchmarkString() {
+  uint32_t heapBefore = ESP.getFreeHeap();
+  unsigned long start = micros();
+  String data = "";
+  for (size_t i = 0; i < kSamples; i++) {
+    data += String(syntheticSample(i)) + ",";
+  }
+  report("String", micros() - start, kSamples, heapBefore);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.printf("%u samples (%u Hz x %lu ms), arena %u bytes static\n",
+                kSamples, kRateHz, kWindowMs, sizeof(arena));
+
+  // Arena first, the min free heap is a high-water mark since boot
+  benchmarkArena();
+  benchmarkString();
+}
+
+void loop() {
+}
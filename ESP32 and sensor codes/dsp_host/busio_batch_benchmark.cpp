@@ -0,0 +1,207 @@
+// I2C transactions per second with and without Adafruit_I2CBatch and register shadows
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -I dsp_host/mock -I libraries/Adafruit_BusIO -o busio_batch_benchmark dsp_host/busio_batch_benchmark.cpp libraries/Adafruit_BusIO/Adafruit_I2CDevice.cpp libraries/Adafruit_BusIO/Adafruit_I2CBatch.cpp libraries/Adafruit_BusIO/Adafruit_BusIO_Register.cpp libraries/Adafruit_BusIO/Adafruit_SPIDevice.cpp libraries/Adafruit_BusIO/Adafruit_GenericDevice.cpp
+//   ./busio_batch_benchmark
+//
+// Drives the simulated MAX3010x through BusIO the way FinalIntegration uses the
+// sensor: the LED currents and ADC range are adjusted 10 times per second and
+// the interrupt status and FIFO pointers are polled 40 times per second.
+#include <cstdio>
+
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_I2CBatch.h>
+
+#include "MAX3010x_device.h"
+
+TwoWire Wire;
+Stream Serial;
+SPIClass SPI;
+
+static const uint8_t kAddress = 0x57;
+static const unsigned long kRunMs = 10000;
+static const unsigned long kPollMs = 25;
+static const unsigned long kGainMs = 100;
+static const uint32_t kClock = 400000;
+
+// Values read by one poll
+struct Poll {
+  uint8_t status[2];
+  uint8_t pointers[3]; // Write pointer, overflow counter, read pointer
+};
+
+// One register object per access, as most BusIO drivers do
+class PerAccess {
+  Adafruit_BusIO_Register spo2_config_;
+  Adafruit_BusIO_RegisterBits adc_range_;
+  Adafruit_BusIO_Register led_red_;
+  Adafruit_BusIO_Register led_ir_;
+  Adafruit_BusIO_Register status1_;
+  Adafruit_BusIO_Register status2_;
+  Adafruit_BusIO_Register write_pointer_;
+  Adafruit_BusIO_Register overflow_;
+  Adafruit_BusIO_Register read_pointer_;
+public:
+  PerAccess(Adafruit_I2CDevice* device, bool shadow) :
+    spo2_config_(device, 0x0A),
+    adc_range_(&spo2_config_, 2, 5),
+    led_red_(device, 0x0C),
+    led_ir_(device, 0x0D),
+    status1_(device, 0x00),
+    status2_(device, 0x01),
+    write_pointer_(device, 0x04),
+    overflow_(device, 0x05),
+    read_pointer_(device, 0x06) {
+    spo2_config_.enableShadow(shadow);
+  }
+
+  void gain(uint8_t range, uint8_t red, uint8_t ir) {
+    adc_range_.write(range);
+    led_red_.write(red);
+    led_ir_.write(ir);
+  }
+
+  void poll(Poll& poll) {
+    status1_.read(&poll.status[0]);
+    status2_.read(&poll.status[1]);
+    write_pointer_.read(&poll.pointers[0]);
+    overflow_.read(&poll.pointers[1]);
+    read_pointer_.read(&poll.pointers[2]);
+  }
+};
+
+// Shadowed configuration register and batched accesses
+class Batched {
+  Adafruit_BusIO_Register spo2_config_;
+  Adafruit_BusIO_RegisterBits adc_range_;
+  Adafruit_I2CBatch batch_;
+public:
+  Batched(Adafruit_I2CDevice* device) :
+    spo2_config_(device, 0x0A),
+    adc_range_(&spo2_config_, 2, 5),
+    batch_(device) {
+    spo2_config_.enableShadow();
+  }
+
+  void gain(uint8_t range, uint8_t red, uint8_t ir) {
+    adc_range_.write(range);
+    batch_.write(0x0C, red);
+    batch_.write(0x0D, ir);
+    batch_.flush();
+  }
+
+  void poll(Poll& poll) {
+    batch_.read(0x00, &poll.status[0], 1);
+    batch_.read(0x01, &poll.status[1], 1);
+    batch_.read(0x04, &poll.pointers[0], 1);
+    batch_.read(0x05, &poll.pointers[1], 1);
+    batch_.read(0x06, &poll.pointers[2], 1);
+    batch_.flush();
+  }
+};
+
+struct Result {
+  MockI2CStats stats;
+  Poll last;
+  uint8_t registers[3]; // SpO2 configuration, red and IR current at the end
+};
+
+template<typename Access, typename Make> static Result run(Make make) {
+  TwoWire wire;
+  MockMAX3010x sensor;
+  wire.attach(kAddress, &sensor);
+  Adafruit_I2CDevice device(kAddress, &wire);
+  device.begin(false);
+
+  // Same configuration for both, 400 SPS with red and IR
+  uint8_t setup[] = { 0x0A, 0x47 };
+  device.write(setup, sizeof(setup));
+  uint8_t mode[] = { 0x09, 0x03 };
+  device.write(mode, sizeof(mode));
+
+  Access* access = make(&device);
+  wire.resetStats();
+
+  Result result;
+  unsigned long start = millis();
+  unsigned long step = 0;
+  while(millis() - start < kRunMs) {
+    delay(kPollMs);
+    access->poll(result.last);
+    if(millis() - start >= (step + 1) * kGainMs) {
+      // Walk through the ranges and currents like the gain control would
+      step++;
+      access->gain(step / 10 % 4, (uint8_t)(40 + step % 50), (uint8_t)(30 + step % 40));
+    }
+  }
+  result.stats = wire.stats();
+  delete access;
+
+  uint8_t reg = 0x0A;
+  device.write_then_read(&reg, 1, &result.registers[0], 1);
+  reg = 0x0C;
+  device.write_then_read(&reg, 1, &result.registers[1], 2);
+  return result;
+}
+
+static void report(const char* name, const Result& result, const Result& reference) {
+  double seconds = kRunMs / 1000.0;
+  const MockI2CStats& stats = result.stats;
+  bool same = memcmp(result.registers, reference.registers, sizeof(result.registers)) == 0 &&
+              memcmp(&result.last, &reference.last, sizeof(result.last)) == 0;
+  printf("%-22s %8.0f  %8.0f  %8.0f  %8.0f  %7.2f %%  %s\n", name, stats.transactions / seconds,
+         stats.writes / seconds, stats.reads / seconds, stats.bytes / seconds,
+         stats.busMicros(kClock) / (kRunMs * 1000.0) * 100, same ? "same" : "DIFFERENT");
+}
+
+// Reset, configuration and mode through one batch: the reset has to reach the
+// device before the mode write that follows it
+static bool resetSurvivesBatch() {
+  TwoWire wire;
+  MockMAX3010x sensor;
+  wire.attach(kAddress, &sensor);
+  Adafruit_I2CDevice device(kAddress, &wire);
+  device.begin(false);
+
+  uint8_t led[] = { 0x0C, 0x50 };
+  device.write(led, sizeof(led));
+
+  Adafruit_I2CBatch batch(&device);
+  batch.write(0x09, 0x40);
+  batch.write(0x0A, 0x47);
+  batch.write(0x09, 0x03);
+  batch.flush();
+
+  uint8_t reg = 0x09;
+  uint8_t values[4];
+  device.write_then_read(&reg, 1, values, sizeof(values));
+  // Mode and SpO2 configuration as written, LED current back to 0 from the reset
+  return values[0] == 0x03 && values[1] == 0x47 && values[3] == 0;
+}
+
+struct MakePerAccess {
+  bool shadow;
+  PerAccess* operator()(Adafruit_I2CDevice* device) const { return new PerAccess(device, shadow); }
+};
+
+struct MakeBatched {
+  Batched* operator()(Adafruit_I2CDevice* device) const { return new Batched(device); }
+};
+
+int main() {
+  MakePerAccess plain = { false };
+  MakePerAccess shadowed = { true };
+  Result before = run<PerAccess>(plain);
+  Result shadow = run<PerAccess>(shadowed);
+  Result after = run<Batched>(MakeBatched());
+
+  printf("%lu s, poll every %lu ms, gain step every %lu ms, bus load at %lu kHz\n\n", kRunMs / 1000,
+         kPollMs, kGainMs, (unsigned long)(kClock / 1000));
+  printf("access                 trans/s  writes/s   reads/s   bytes/s  bus load   result\n");
+  report("per access", before, before);
+  report("shadowed SpO2 config", shadow, before);
+  report("shadow + batch", after, before);
+  printf("\n%.2fx fewer transactions\n", (double)before.stats.transactions / after.stats.transactions);
+  printf("reset, SpO2 config and mode in one batch: %s\n", resetSurvivesBatch() ? "reset sent" : "RESET LOST");
+  return 0;
+}
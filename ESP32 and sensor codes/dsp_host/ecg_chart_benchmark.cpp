@@ -0,0 +1,112 @@
+// Bus traffic of the ECG strip chart at 25 fps, sweep columns vs whole frames
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -DARDUINO=10819 -I dsp_host/mock -I libraries/Adafruit_BusIO -I libraries/Adafruit_GFX_Library -I libraries/Adafruit_SSD1306 -o ecg_chart_benchmark dsp_host/ecg_chart_benchmark.cpp libraries/Adafruit_SSD1306/Adafruit_SSD1306.cpp libraries/Adafruit_GFX_Library/Adafruit_GFX.cpp libraries/Adafruit_BusIO/Adafruit_I2CDevice.cpp libraries/Adafruit_BusIO/Adafruit_SPIDevice.cpp libraries/Adafruit_BusIO/Adafruit_GenericDevice.cpp
+//   ./ecg_chart_benchmark
+//
+// Feeds a synthetic 72 bpm ECG at 250 SPS into the StripChart of FinalIntegration
+// and pushes the display every 40 ms with the displayChunk() loop of
+// refreshDisplay(). Every frame is checked against the RAM of the simulated panel.
+#include <cstdio>
+
+#include <Adafruit_SSD1306.h>
+
+#include "SSD1306_device.h"
+#include "../FinalIntegration/strip_chart.h"
+
+TwoWire Wire;
+Stream Serial;
+SPIClass SPI;
+
+static const uint8_t kWidth = 128;
+static const uint8_t kHeight = 64;
+static const uint8_t kAddress = 0x3C;
+static const uint32_t kClock = 400000;
+static const uint16_t kChunk = 212; // I2CBus::displayChunkBytes(10) at 400 kHz and 2 ms
+static const unsigned long kRunMs = 30000;
+static const unsigned long kFrameMs = 40;
+static const uint32_t kRate = 250;
+
+// Same layout as FinalIntegration
+static const int16_t kChartTop = 8;
+static const uint16_t kSamplesPerColumn = 4;
+static const int16_t kChartMinSpan = 40;
+
+// ADC counts of a 72 bpm lead II like trace with P, QRS and T waves and some noise
+static int16_t ecg(unsigned long n) {
+  double t = fmod(n / (double)kRate, 60.0 / 72);
+  double v = 512 + 4 * sin(n * 0.013);
+  v += 6 * exp(-pow((t - 0.10) / 0.025, 2));  // P
+  v -= 5 * exp(-pow((t - 0.19) / 0.008, 2));  // Q
+  v += 60 * exp(-pow((t - 0.21) / 0.010, 2)); // R
+  v -= 12 * exp(-pow((t - 0.23) / 0.010, 2)); // S
+  v += 12 * exp(-pow((t - 0.45) / 0.050, 2)); // T
+  v += (int)(n * 7919 % 5) - 2;
+  return (int16_t)v;
+}
+
+struct Result {
+  unsigned long frames;
+  unsigned long worst_bytes;
+  MockI2CStats stats;
+  int mismatches;
+};
+
+static Result run(bool whole) {
+  TwoWire wire;
+  MockSSD1306 panel(kWidth, kHeight);
+  wire.attach(kAddress, &panel);
+  Adafruit_SSD1306 display(kWidth, kHeight, &wire);
+  Result result = {};
+  if(!display.begin(SSD1306_SWITCHCAPVCC, kAddress)) {
+    printf("display setup failed\n");
+    return result;
+  }
+  StripChart chart(display, 0, kChartTop, kWidth, kHeight - kChartTop, kSamplesPerColumn, kChartMinSpan);
+  display.clearDisplay();
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  display.setCursor(0, 0);
+  display.println("Recording ECG");
+  chart.begin();
+  display.display();
+  wire.resetStats();
+
+  unsigned long samples = kRunMs * kRate / 1000;
+  unsigned long next_frame = kFrameMs;
+  for(unsigned long n = 0; n < samples; n++) {
+    chart.add(ecg(n));
+    if(n * 1000 / kRate < next_frame) continue;
+    next_frame += kFrameMs;
+
+    unsigned long before = wire.stats().bytes;
+    if(whole) display.markDirty(); // As if the frame was redrawn and pushed in full
+    for(uint16_t offset = 0; offset < kWidth * kHeight / 8;) offset = display.displayChunk(offset, kChunk);
+    unsigned long bytes = wire.stats().bytes - before;
+    if(bytes > result.worst_bytes) result.worst_bytes = bytes;
+    if(memcmp(panel.ram(), display.getBuffer(), kWidth * kHeight / 8) != 0) result.mismatches++;
+    result.frames++;
+  }
+  result.stats = wire.stats();
+  return result;
+}
+
+static void report(const char* name, const Result& result) {
+  double seconds = kRunMs / 1000.0;
+  printf("%-14s %5.1f  %9.1f  %10lu  %11.0f  %7.1f %%  %s\n", name, result.frames / seconds,
+         (double)result.stats.bytes / result.frames, result.worst_bytes,
+         result.stats.busMicros(kClock) / result.frames,
+         result.stats.busMicros(kClock) / (kRunMs * 1000.0) * 100, result.mismatches ? "DIFFERENT" : "same");
+}
+
+int main() {
+  printf("%lu s ECG at %lu SPS, %lu samples per column, display at %lu kHz\n\n", kRunMs / 1000,
+         (unsigned long)kRate, (unsigned long)kSamplesPerColumn, (unsigned long)(kClock / 1000));
+  printf("refresh        fps    B/frame  worst B  us/frame  bus load   panel\n");
+  Result whole = run(true);
+  Result sweep = run(false);
+  report("whole frame", whole);
+  report("sweep columns", sweep);
+  printf("\n%.1fx fewer bytes\n", (double)whole.stats.bytes / sweep.stats.bytes);
+  return 0;
+}
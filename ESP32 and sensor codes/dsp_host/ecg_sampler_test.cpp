@@ -0,0 +1,168 @@
+// Rate accuracy of EcgSampler with a simulated ADC and clock
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -o ecg_sampler_test dsp_host/ecg_sampler_test.cpp
+//   ./ecg_sampler_test
+//
+// The ADC returns a running count, so every sample shows whether one was
+// lost, repeated or reordered. Each rate is run for 10 s of simulated time,
+// paced by a hardware timer that calls sample() every periodUs() and by the
+// main loop of the other targets calling poll() at random intervals of 0.1
+// to 1 ms, with a 50 ms stall now and then. The old fallback, a PeriodicTask
+// with a period of 1000 / rate ms, is shown for comparison. Exits with 1 on
+// the first failed check.
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../FinalIntegration/ecg_sampler.h"
+#include "../FinalIntegration/scheduler.h"
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if(!(condition)) {                                                    \
+      printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition);        \
+      exit(1);                                                            \
+    }                                                                     \
+  } while(0)
+
+static const uint32_t kRunUs = 10000000;
+static const uint8_t kPin = 34;
+
+// 32 bit like micros() on the ESP32, starts close to the wrap
+static uint32_t fakeMicros = 0xFFFFFFFFUL - 3000000UL;
+static int adcCount = 0;
+
+static unsigned long fakeClock() { return fakeMicros; }
+static unsigned long fakeMillis() { return fakeMicros / 1000; }
+static int fakeAdc(uint8_t pin) {
+  CHECK(pin == kPin);
+  return adcCount++ & 0x7FFF;
+}
+
+static EcgSampler<128>* sampler = nullptr;
+static void sampleTask() { sampler->sample(); }
+
+struct Result {
+  unsigned long samples;
+  double worst_late_us; // Time a sample was taken after its due time
+};
+
+// Drain the queue and check the samples are consecutive and in time order
+static unsigned long drain(EcgSampler<128>& ecg, int& expected, uint32_t& last) {
+  unsigned long count = 0;
+  EcgSample sample;
+  while(ecg.read(sample)) {
+    CHECK(sample.value == (expected & 0x7FFF));
+    CHECK(count + expected == 0 || (int32_t)(sample.timestamp - last) >= 0);
+    expected++;
+    last = sample.timestamp;
+    count++;
+  }
+  return count;
+}
+
+static Result runTimer(uint32_t rate) {
+  EcgSampler<128> ecg(fakeAdc, fakeClock, kPin, rate);
+  adcCount = 0;
+  int expected = 0;
+  uint32_t last = 0;
+  Result result = { 0, 0 };
+  uint32_t start = fakeMicros;
+  while((uint32_t)(fakeMicros - start) < kRunUs) {
+    fakeMicros += ecg.periodUs();
+    ecg.sample();
+    result.samples += drain(ecg, expected, last);
+  }
+  CHECK(ecg.dropped() == 0);
+  return result;
+}
+
+static Result runPoll(uint32_t rate, bool stalls) {
+  EcgSampler<128> ecg(fakeAdc, fakeClock, kPin, rate);
+  adcCount = 0;
+  int expected = 0;
+  uint32_t last = 0;
+  Result result = { 0, 0 };
+  uint32_t seed = rate;
+  uint32_t start = fakeMicros;
+  ecg.start();
+  uint32_t grid = fakeMicros;
+  unsigned long on_grid = 0;
+  while((uint32_t)(fakeMicros - start) < kRunUs) {
+    seed = seed * 1664525u + 1013904223u;
+    fakeMicros += 100 + (seed >> 8) % 900;
+    if(stalls && (seed >> 4) % 2000 == 0) fakeMicros += 50000;
+
+    if(ecg.poll()) {
+      // Late by more than a period restarts the grid at this sample
+      long late = (long)(uint32_t)(fakeMicros - grid) - (long)((uint64_t)on_grid * 1000000UL / rate);
+      if(late >= (long)ecg.periodUs()) {
+        grid = fakeMicros;
+        on_grid = 0;
+        late = 0;
+      }
+      CHECK(late >= 0);
+      if(late > result.worst_late_us) result.worst_late_us = (double)late;
+      on_grid++;
+    }
+    result.samples += drain(ecg, expected, last);
+  }
+  CHECK(ecg.dropped() == 0);
+  return result;
+}
+
+static Result runPeriodicTask(uint32_t rate) {
+  EcgSampler<128> ecg(fakeAdc, fakeClock, kPin, rate);
+  sampler = &ecg;
+  adcCount = 0;
+  int expected = 0;
+  uint32_t last = 0;
+  Result result = { 0, 0 };
+  PeriodicTask task(sampleTask, 1000 / rate);
+  uint32_t seed = rate;
+  uint32_t start = fakeMicros;
+  task.start(fakeMillis());
+  while((uint32_t)(fakeMicros - start) < kRunUs) {
+    seed = seed * 1664525u + 1013904223u;
+    fakeMicros += 100 + (seed >> 8) % 900;
+    task.poll(fakeMillis());
+    result.samples += drain(ecg, expected, last);
+  }
+  sampler = nullptr;
+  return result;
+}
+
+static void testDropped() {
+  EcgSampler<128> ecg(fakeAdc, fakeClock, kPin, 250);
+  for(int i = 0; i < 200; i++) ecg.sample();
+  CHECK(ecg.dropped() == 72);
+  ecg.clear();
+  EcgSample sample;
+  CHECK(!ecg.read(sample));
+}
+
+int main() {
+  const uint32_t kRates[] = { 250, 300, 360, 500, 700 };
+  printf("rate    timer Hz      poll Hz  worst late   poll, 50 ms stalls   PeriodicTask(1000 / rate)\n");
+  for(uint32_t rate : kRates) {
+    Result timer = runTimer(rate);
+    Result poll = runPoll(rate, false);
+    Result stalled = runPoll(rate, true);
+    Result task = runPeriodicTask(rate);
+    double seconds = kRunUs / 1e6;
+    printf("%4u  %10.2f   %10.2f  %7.0f us   %10.2f Hz         %10.2f Hz\n", rate, timer.samples / seconds,
+           poll.samples / seconds, poll.worst_late_us, stalled.samples / seconds, task.samples / seconds);
+
+    // The timer period is rounded to whole us, the poll grid is exact
+    CHECK(fabs(timer.samples / seconds - rate) <= rate * 1e-3);
+    CHECK(labs((long)poll.samples - (long)(rate * seconds)) <= 1);
+    // A sample is never taken more than one loop interval after it was due
+    CHECK(poll.worst_late_us <= 1000);
+    // A stall loses the samples it covers but keeps the rate otherwise
+    CHECK(stalled.samples < poll.samples && stalled.samples > poll.samples * 0.9);
+  }
+  testDropped();
+  printf("ecg_sampler: all checks passed\n");
+  return 0;
+}
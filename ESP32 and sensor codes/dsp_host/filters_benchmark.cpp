@@ -0,0 +1,152 @@
+// Throughput of the filters in FinalIntegration/filters.h and dsp_host/filters_simd.h
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -march=native -o filters_benchmark dsp_host/filters_benchmark.cpp
+//   ./filters_benchmark
+//
+// Reports samples/second of the scalar per-sample classes, the block API, the
+// Q15/Q31 fixed point variants and the SIMD variants, plus the largest deviation
+// from the scalar output.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Arduino definitions used by filters.h
+using std::isnan;
+using std::max;
+using std::min;
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#include "../FinalIntegration/filters.h"
+#include "filters_simd.h"
+
+static const size_t kSamples = 1 << 20;
+static const size_t kBlock = 256;
+static const int kRuns = 20;
+static const float kSamplingFrequency = 400.0;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename Function> static double samplesPerSecond(Function function) {
+  double best = 0;
+  for(int run = 0; run < kRuns; run++) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    best = std::max(best, kSamples / secondsSince(start));
+  }
+  return best;
+}
+
+static float maxError(const std::vector<float>& reference, const std::vector<float>& values, float scale = 1) {
+  float error = 0;
+  for(size_t i = 1; i < reference.size(); i++) {
+    error = std::max(error, std::fabs(reference[i] - values[i] * scale));
+  }
+  return error;
+}
+
+template<typename T> static std::vector<float> toFloat(const std::vector<T>& values) {
+  return std::vector<float>(values.begin(), values.end());
+}
+
+static void report(const char* name, double rate, double scalar_rate, float error) {
+  printf("  %-10s %8.1f Msamples/s  %5.2fx  max error %g\n", name, rate / 1e6, rate / scalar_rate, error);
+}
+
+// Runs every variant of one filter type
+template<typename Scalar, typename Simd, typename Q15Filter, typename Q31Filter, typename Make>
+static void benchmark(const char* name, const std::vector<float>& input, Make make, float q15_scale) {
+  // Integer inputs for the fixed point filters, Q15 scaled down to leave headroom
+  const float kQ15Scale = q15_scale;
+  std::vector<int32_t> input_q31(input.begin(), input.end());
+  std::vector<int16_t> input_q15(input.size());
+  for(size_t i = 0; i < input.size(); i++) input_q15[i] = (int16_t)std::round(input[i] / kQ15Scale);
+
+  // The differentiators return the accumulator type
+  std::vector<float> reference(kSamples), output(kSamples);
+  std::vector<decltype(std::declval<Q31Filter&>().process(int32_t()))> output_q31(kSamples);
+  std::vector<decltype(std::declval<Q15Filter&>().process(int16_t()))> output_q15(kSamples);
+
+  printf("%s\n", name);
+  double scalar = samplesPerSecond([&]() {
+    Scalar filter = make.template operator()<Scalar>();
+    for(size_t i = 0; i < kSamples; i++) reference[i] = filter.process(input[i]);
+  });
+  report("scalar", scalar, scalar, 0);
+
+  double block = samplesPerSecond([&]() {
+    Scalar filter = make.template operator()<Scalar>();
+    for(size_t i = 0; i < kSamples; i += kBlock) filter.process(&input[i], &output[i], kBlock);
+  });
+  report("block", block, scalar, maxError(reference, output));
+
+  double q15 = samplesPerSecond([&]() {
+    Q15Filter filter = make.template operator()<Q15Filter>();
+    for(size_t i = 0; i < kSamples; i += kBlock) filter.process(&input_q15[i], &output_q15[i], kBlock);
+  });
+  report("Q15", q15, scalar, maxError(reference, toFloat(output_q15), kQ15Scale));
+
+  double q31 = samplesPerSecond([&]() {
+    Q31Filter filter = make.template operator()<Q31Filter>();
+    for(size_t i = 0; i < kSamples; i += kBlock) filter.process(&input_q31[i], &output_q31[i], kBlock);
+  });
+  report("Q31", q31, scalar, maxError(reference, toFloat(output_q31)));
+
+  double simd = samplesPerSecond([&]() {
+    Simd filter = make.template operator()<Simd>();
+    for(size_t i = 0; i < kSamples; i += kBlock) filter.process(&input[i], &output[i], kBlock);
+  });
+  report("SIMD", simd, scalar, maxError(reference, output));
+}
+
+struct MakeLowPass {
+  template<typename Filter> Filter operator()() const { return Filter(5.0f, kSamplingFrequency); }
+};
+
+struct MakeHighPass {
+  template<typename Filter> Filter operator()() const { return Filter(0.5f, kSamplingFrequency); }
+};
+
+struct MakeDifferentiator {
+  template<typename Filter> Filter operator()() const { return Filter(kSamplingFrequency); }
+};
+
+int main() {
+  // Synthetic PPG: DC level, pulse at 1.2 Hz and some noise
+  std::vector<float> input(kSamples);
+  unsigned int seed = 1;
+  for(size_t i = 0; i < kSamples; i++) {
+    seed = seed * 1103515245 + 12345;
+    float t = i / kSamplingFrequency;
+    input[i] = (float)(int)(100000 + 3000 * sinf(2 * (float)PI * 1.2f * t) + (seed >> 16) % 200);
+  }
+
+#if FILTERS_SIMD
+  printf("%u samples, blocks of %u, SIMD width %u\n", (unsigned)kSamples, (unsigned)kBlock, (unsigned)SimdFloat::kWidth);
+#else
+  printf("%u samples, blocks of %u, no SIMD\n", (unsigned)kSamples, (unsigned)kBlock);
+#endif
+  benchmark<LowPassFilter, LowPassFilterSimd, LowPassFilterQ15, LowPassFilterQ31>("LowPassFilter", input, MakeLowPass(), 8);
+  benchmark<HighPassFilter, HighPassFilterSimd, HighPassFilterQ15, HighPassFilterQ31>("HighPassFilter", input, MakeHighPass(), 8);
+
+  // Differentiate the high pass output, it fits the Q15 input unscaled
+  std::vector<float> filtered(kSamples);
+  HighPassFilter high_pass(0.5f, kSamplingFrequency);
+  high_pass.process(&input[0], &filtered[0], kSamples);
+  for(size_t i = 0; i < kSamples; i++) filtered[i] = std::round(filtered[i] / 8);
+  benchmark<Differentiator, DifferentiatorSimd, DifferentiatorQ15, DifferentiatorQ31>("Differentiator", filtered, MakeDifferentiator(), 1);
+
+  // A Q15 output would saturate on any step above 32767 / 400 = 81 counts
+  DifferentiatorQ15 step(kSamplingFrequency);
+  step.process(-32768);
+  printf("  Q15 full scale step: %ld (exact %ld)\n", (long)step.process(32767), 65535L * (long)kSamplingFrequency);
+  return 0;
+}
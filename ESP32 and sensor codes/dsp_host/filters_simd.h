@@ -0,0 +1,326 @@
+#ifndef FILTERS_SIMD_H
+#define FILTERS_SIMD_H
+
+#include <math.h>
+#include <stddef.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Host side SIMD versions of the filters in FinalIntegration/filters.h for batch
+ * reprocessing of recorded sessions. Same coefficients and first-sample behaviour
+ * as the scalar classes, results match up to float rounding.
+ *
+ * The low and high pass filters are first order recursions y[i] = u[i] + b * y[i-1].
+ * A vector of u is turned into y with a log2(width) step prefix scan
+ * (y += b * shift1(y), y += b^2 * shift2(y), ...) plus b^(k+1) * y[-1], so the
+ * dependency chain only runs once per vector instead of once per sample.
+ * AVX2 works on 8 floats, SSE2 and NEON on 4, everything else falls back to scalar code.
+ */
+
+#if defined(__AVX2__)
+struct SimdFloat {
+  typedef __m256 Vector;
+  static const size_t kWidth = 8;
+  static Vector load(const float* p) { return _mm256_loadu_ps(p); }
+  static void store(float* p, Vector v) { _mm256_storeu_ps(p, v); }
+  static Vector set1(float v) { return _mm256_set1_ps(v); }
+  static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+  static Vector sub(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+  static Vector mul(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+  static Vector broadcastLast(Vector v) { return _mm256_permutevar8x32_ps(v, _mm256_set1_epi32(7)); }
+  // Moves every lane up by k, lane i < k becomes fill
+  template<int k> static Vector shiftIn(Vector v, Vector fill) {
+    const __m256i index = _mm256_setr_epi32(0 - k, 1 - k, 2 - k, 3 - k, 4 - k, 5 - k, 6 - k, 7 - k);
+    Vector shifted = _mm256_permutevar8x32_ps(v, _mm256_max_epi32(index, _mm256_setzero_si256()));
+    return _mm256_blend_ps(shifted, fill, (1 << k) - 1);
+  }
+};
+#elif defined(__SSE2__)
+struct SimdFloat {
+  typedef __m128 Vector;
+  static const size_t kWidth = 4;
+  static Vector load(const float* p) { return _mm_loadu_ps(p); }
+  static void store(float* p, Vector v) { _mm_storeu_ps(p, v); }
+  static Vector set1(float v) { return _mm_set1_ps(v); }
+  static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+  static Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+  static Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+  static Vector broadcastLast(Vector v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+  template<int k> static Vector shiftIn(Vector v, Vector fill) {
+    Vector shifted = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4 * k));
+    Vector mask = _mm_castsi128_ps(_mm_srli_si128(_mm_set1_epi32(-1), 16 - 4 * k));
+    return _mm_or_ps(shifted, _mm_and_ps(mask, fill));
+  }
+};
+#elif defined(__ARM_NEON)
+struct SimdFloat {
+  typedef float32x4_t Vector;
+  static const size_t kWidth = 4;
+  static Vector load(const float* p) { return vld1q_f32(p); }
+  static void store(float* p, Vector v) { vst1q_f32(p, v); }
+  static Vector set1(float v) { return vdupq_n_f32(v); }
+  static Vector add(Vector a, Vector b) { return vaddq_f32(a, b); }
+  static Vector sub(Vector a, Vector b) { return vsubq_f32(a, b); }
+  static Vector mul(Vector a, Vector b) { return vmulq_f32(a, b); }
+  static Vector broadcastLast(Vector v) { return vdupq_n_f32(vgetq_lane_f32(v, 3)); }
+  template<int k> static Vector shiftIn(Vector v, Vector fill) { return vextq_f32(fill, v, 4 - k); }
+};
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+#define FILTERS_SIMD 1
+
+/**
+ * @brief Prefix scan of y[i] = u[i] + b * y[i-1] over one vector
+ */
+class SimdRecursion {
+  typedef SimdFloat::Vector Vector;
+  Vector b1_, b2_, b4_, carry_;
+public:
+  explicit SimdRecursion(float b) {
+    float power = 1;
+    float carry[SimdFloat::kWidth];
+    for(size_t i = 0; i < SimdFloat::kWidth; i++) {
+      power *= b;
+      carry[i] = power;
+    }
+    b1_ = SimdFloat::set1(b);
+    b2_ = SimdFloat::set1(b * b);
+    b4_ = SimdFloat::set1(b * b * b * b);
+    carry_ = SimdFloat::load(carry);
+  }
+
+  /**
+   * @param u Input of the recursion
+   * @param last Previous output broadcast to all lanes
+   * @return Output, its last lane broadcast is the next value of last
+   */
+  Vector apply(Vector u, Vector last) const {
+    const Vector zero = SimdFloat::set1(0);
+    Vector y = SimdFloat::add(u, SimdFloat::mul(b1_, SimdFloat::shiftIn<1>(u, zero)));
+    y = SimdFloat::add(y, SimdFloat::mul(b2_, SimdFloat::shiftIn<2>(y, zero)));
+#if defined(__AVX2__)
+    y = SimdFloat::add(y, SimdFloat::mul(b4_, SimdFloat::shiftIn<4>(y, zero)));
+#endif
+    return SimdFloat::add(y, SimdFloat::mul(carry_, last));
+  }
+};
+#endif
+
+/**
+ * @brief SIMD Low Pass Filter, see LowPassFilter
+ */
+class LowPassFilterSimd {
+  const float kA0;
+  const float kB1;
+  float last_value_;
+public:
+  /**
+   * @brief Initialize the Low Pass Filter
+   * @param samples Number of samples until decay to 36.8 %
+   */
+  LowPassFilterSimd(float samples) :
+    kA0(1 - expf(-1 / samples)),
+    kB1(expf(-1 / samples)),
+    last_value_(NAN){}
+
+  /**
+   * @brief Initialize the Low Pass Filter
+   * @param cutoff Cutoff frequency
+   * @param sampling_frequency Sampling frequency
+   */
+  LowPassFilterSimd(float cutoff, float sampling_frequency) :
+    LowPassFilterSimd(sampling_frequency / (cutoff * 2 * (float)M_PI)){}
+
+  /**
+   * @brief Applies the low pass filter to a block of samples
+   * @param in Input samples
+   * @param out Output samples, may be the same buffer as in
+   * @param n Number of samples
+   */
+  void process(const float* in, float* out, size_t n) {
+    if(n == 0) return;
+
+    size_t i = 0;
+    if(isnan(last_value_)) {
+      last_value_ = in[0];
+      out[0] = last_value_;
+      i = 1;
+    }
+
+    float last_value = last_value_;
+#if FILTERS_SIMD
+    SimdRecursion recursion(kB1);
+    SimdFloat::Vector a0 = SimdFloat::set1(kA0);
+    SimdFloat::Vector last = SimdFloat::set1(last_value);
+    for(; i + SimdFloat::kWidth <= n; i += SimdFloat::kWidth) {
+      SimdFloat::Vector y = recursion.apply(SimdFloat::mul(a0, SimdFloat::load(in + i)), last);
+      SimdFloat::store(out + i, y);
+      last = SimdFloat::broadcastLast(y);
+    }
+    if(i > 0) last_value = out[i - 1];
+#endif
+    for(; i < n; i++) {
+      last_value = kA0 * in[i] + kB1 * last_value;
+      out[i] = last_value;
+    }
+    last_value_ = last_value;
+  }
+
+  /**
+   * @brief Resets the stored values
+   */
+  void reset() {
+    last_value_ = NAN;
+  }
+};
+
+/**
+ * @brief SIMD High Pass Filter, see HighPassFilter
+ */
+class HighPassFilterSimd {
+  const float kA0;
+  const float kB1;
+  float last_filter_value_;
+  float last_raw_value_;
+public:
+  /**
+   * @brief Initialize the High Pass Filter
+   * @param samples Number of samples until decay to 36.8 %
+   */
+  HighPassFilterSimd(float samples) :
+    kA0((1 + expf(-1 / samples)) / 2),
+    kB1(expf(-1 / samples)),
+    last_filter_value_(NAN),
+    last_raw_value_(NAN){}
+
+  /**
+   * @brief Initialize the High Pass Filter
+   * @param cutoff Cutoff frequency
+   * @param sampling_frequency Sampling frequency
+   */
+  HighPassFilterSimd(float cutoff, float sampling_frequency) :
+    HighPassFilterSimd(sampling_frequency / (cutoff * 2 * (float)M_PI)){}
+
+  /**
+   * @brief Applies the high pass filter to a block of samples
+   * @param in Input samples
+   * @param out Output samples, may be the same buffer as in
+   * @param n Number of samples
+   */
+  void process(const float* in, float* out, size_t n) {
+    if(n == 0) return;
+
+    size_t i = 0;
+    if(isnan(last_filter_value_) || isnan(last_raw_value_)) {
+      last_filter_value_ = 0;
+      last_raw_value_ = in[0];
+      out[0] = 0;
+      i = 1;
+    }
+
+    float last_raw = last_raw_value_;
+    float last_filter = last_filter_value_;
+#if FILTERS_SIMD
+    SimdRecursion recursion(kB1);
+    SimdFloat::Vector a0 = SimdFloat::set1(kA0);
+    SimdFloat::Vector raw_last = SimdFloat::set1(last_raw);
+    SimdFloat::Vector filter_last = SimdFloat::set1(last_filter);
+    size_t start = i;
+    for(; i + SimdFloat::kWidth <= n; i += SimdFloat::kWidth) {
+      // The previous raw values come from registers so that in and out may alias
+      SimdFloat::Vector x = SimdFloat::load(in + i);
+      SimdFloat::Vector x_prev = SimdFloat::shiftIn<1>(x, raw_last);
+      SimdFloat::Vector u = SimdFloat::mul(a0, SimdFloat::sub(x, x_prev));
+      SimdFloat::Vector y = recursion.apply(u, filter_last);
+      SimdFloat::store(out + i, y);
+      raw_last = SimdFloat::broadcastLast(x);
+      filter_last = SimdFloat::broadcastLast(y);
+    }
+    if(i > start) {
+      float raw[SimdFloat::kWidth];
+      SimdFloat::store(raw, raw_last);
+      last_raw = raw[0];
+      last_filter = out[i - 1];
+    }
+#endif
+    for(; i < n; i++) {
+      float value = in[i];
+      last_filter = kA0 * (value - last_raw) + kB1 * last_filter;
+      last_raw = value;
+      out[i] = last_filter;
+    }
+    last_raw_value_ = last_raw;
+    last_filter_value_ = last_filter;
+  }
+
+  /**
+   * @brief Resets the stored values
+   */
+  void reset() {
+    last_raw_value_ = NAN;
+    last_filter_value_ = NAN;
+  }
+};
+
+/**
+ * @brief SIMD Differentiator, see Differentiator
+ */
+class DifferentiatorSimd {
+  const float kSamplingFrequency;
+  float last_value_;
+public:
+  /**
+   * @brief Initializes the differentiator
+   */
+  DifferentiatorSimd(float sampling_frequency) :
+    kSamplingFrequency(sampling_frequency),
+    last_value_(NAN){}
+
+  /**
+   * @brief Applies the differentiator to a block of samples
+   * @param in Input samples
+   * @param out Output samples, may be the same buffer as in
+   * @param n Number of samples
+   */
+  void process(const float* in, float* out, size_t n) {
+    size_t i = 0;
+    float last_value = last_value_;
+#if FILTERS_SIMD
+    SimdFloat::Vector fs = SimdFloat::set1(kSamplingFrequency);
+    SimdFloat::Vector last = SimdFloat::set1(last_value);
+    for(; i + SimdFloat::kWidth <= n; i += SimdFloat::kWidth) {
+      SimdFloat::Vector x = SimdFloat::load(in + i);
+      SimdFloat::store(out + i, SimdFloat::mul(SimdFloat::sub(x, SimdFloat::shiftIn<1>(x, last)), fs));
+      last = SimdFloat::broadcastLast(x);
+    }
+    if(i > 0) {
+      float values[SimdFloat::kWidth];
+      SimdFloat::store(values, last);
+      last_value = values[0];
+    }
+#endif
+    for(; i < n; i++) {
+      float value = in[i];
+      out[i] = (value - last_value) * kSamplingFrequency;
+      last_value = value;
+    }
+    last_value_ = last_value;
+  }
+
+  /**
+   * @brief Resets the stored values
+   */
+  void reset() {
+    last_value_ = NAN;
+  }
+};
+
+#endif // FILTERS_SIMD_H
@@ -0,0 +1,207 @@
+// Round trip of FrameEncoder/EcgFramePacker through the host FrameDecoder
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -O2 -o frame_decoder_test dsp_host/frame_decoder_test.cpp frame_decoder/frame_decoder.cpp -x c FinalIntegration/crc16.c
+//   ./frame_decoder_test
+//
+// Builds the byte stream of a session the way FinalIntegration sends it: text
+// lines and frames as whole chunks, the ECG packed into full frames. The
+// stream is decoded clean, with one frame's CRC or payload corrupted, with a
+// corrupted length byte and with a text line cut short by a frame, and then
+// with random byte errors. After an error the following text lines have to
+// arrive intact and every frame the decoder accepts has to be one that was
+// sent. Exits with 1 on the first failed check.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../frame_decoder/frame_decoder.h"
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if(!(condition)) {                                                    \
+      printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition);        \
+      exit(1);                                                            \
+    }                                                                     \
+  } while(0)
+
+typedef std::vector<uint8_t> Bytes;
+
+struct Session {
+  Bytes stream;
+  std::vector<size_t> frame_starts; // Offset of every frame in the stream
+  std::vector<Bytes> frames;        // Every frame as sent, indexed by seq
+};
+
+static void addText(Session& session, const char* line) {
+  session.stream.insert(session.stream.end(), line, line + strlen(line));
+  session.stream.push_back('\n');
+}
+
+static void addFrame(Session& session, FrameEncoder& encoder, uint8_t type, const uint8_t* payload,
+                     size_t length) {
+  uint8_t frame[kFrameMaxSize];
+  size_t size = encoder.encode(type, payload, length, frame);
+  session.frame_starts.push_back(session.stream.size());
+  session.frames.push_back(Bytes(frame, frame + size));
+  session.stream.insert(session.stream.end(), frame, frame + size);
+}
+
+static Session makeSession() {
+  Session session;
+  FrameEncoder encoder;
+  addText(session, "READY");
+  float weight = 72.5f;
+  addFrame(session, encoder, FRAME_WEIGHT, (const uint8_t*)&weight, sizeof(weight));
+
+  uint8_t rate[2] = { 250 & 0xFF, 250 >> 8 };
+  addFrame(session, encoder, FRAME_ECG_START, rate, sizeof(rate));
+  EcgFramePacker packer;
+  uint32_t seed = 1;
+  int16_t value = 2048;
+  for(int i = 0; i < 1000; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    value = (int16_t)(value + (int)((seed >> 24) % 41) - 20);
+    if(packer.add(value)) {
+      addFrame(session, encoder, FRAME_ECG_SAMPLES, packer.payload(), packer.length());
+      packer.clear();
+      // A debug line between two ECG frames
+      if(session.frames.size() == 5) addText(session, "SPO2_LOSS:3/6000");
+    }
+  }
+  addFrame(session, encoder, FRAME_ECG_SAMPLES, packer.payload(), packer.length());
+  addText(session, "WEIGHT_STABLE_MS:2300");
+  addFrame(session, encoder, FRAME_DATA_END, nullptr, 0);
+  addText(session, "READY");
+  return session;
+}
+
+struct Decoded {
+  std::vector<std::string> lines;
+  std::vector<FrameEvent> frames;
+  unsigned long crc_errors;
+  unsigned long lost_frames;
+};
+
+static Decoded decode(const Bytes& stream, size_t chunk) {
+  FrameDecoder decoder;
+  Decoded decoded;
+  for(size_t i = 0; i < stream.size(); i += chunk) {
+    decoder.feed(stream.data() + i, std::min(chunk, stream.size() - i));
+    FrameEvent event;
+    while(decoder.next(event)) {
+      if(event.kind == FRAME_EVENT_TEXT) {
+        decoded.lines.push_back(std::string((const char*)event.data, event.length));
+      }
+      else {
+        decoded.frames.push_back(event);
+      }
+    }
+  }
+  decoded.crc_errors = decoder.crcErrors();
+  decoded.lost_frames = decoder.lostFrames();
+  return decoded;
+}
+
+// Every accepted frame has to be the one sent with its sequence number
+static void checkFrames(const Session& session, const Decoded& decoded) {
+  for(const FrameEvent& event : decoded.frames) {
+    CHECK(event.seq < session.frames.size());
+    const Bytes& sent = session.frames[event.seq];
+    CHECK(event.type == sent[2]);
+    CHECK(event.length == sent[4]);
+    CHECK(memcmp(event.data, sent.data() + kFrameHeaderSize, event.length) == 0);
+  }
+}
+
+static const std::vector<std::string> kLines = { "READY", "SPO2_LOSS:3/6000", "WEIGHT_STABLE_MS:2300", "READY" };
+
+static void testClean() {
+  Session session = makeSession();
+  const size_t kChunks[] = { 1, 7, 64, 100000 };
+  for(size_t chunk : kChunks) {
+    Decoded decoded = decode(session.stream, chunk);
+    CHECK(decoded.lines == kLines);
+    CHECK(decoded.frames.size() == session.frames.size());
+    CHECK(decoded.crc_errors == 0);
+    CHECK(decoded.lost_frames == 0);
+    checkFrames(session, decoded);
+  }
+}
+
+// Corrupt one byte of the ECG frame right before "SPO2_LOSS", the line has to survive
+static void testCorruptFrame(size_t offset, uint8_t mask) {
+  Session session = makeSession();
+  size_t frame = 4;
+  session.stream[session.frame_starts[frame] + offset] ^= mask;
+  Decoded decoded = decode(session.stream, 64);
+  CHECK(decoded.lines == kLines);
+  CHECK(decoded.frames.size() == session.frames.size() - 1);
+  CHECK(decoded.crc_errors == 1);
+  CHECK(decoded.lost_frames == 1);
+  checkFrames(session, decoded);
+}
+
+// A length byte that is too large swallows what follows, the decoder has to find the next frames
+static void testCorruptLength() {
+  Session session = makeSession();
+  size_t frame = 4;
+  session.stream[session.frame_starts[frame] + 4] = 40;
+  Decoded decoded = decode(session.stream, 64);
+  CHECK(decoded.crc_errors >= 1);
+  CHECK(decoded.frames.size() == session.frames.size() - 1);
+  CHECK(decoded.lines.back() == "READY");
+  checkFrames(session, decoded);
+}
+
+// A line cut short (a byte lost on the wire, no newline) must not leak into the next one
+static void testCutLine() {
+  FrameEncoder encoder;
+  Session session;
+  const char* cut = "SPO2_LO";
+  session.stream.insert(session.stream.end(), cut, cut + strlen(cut));
+  addFrame(session, encoder, FRAME_DATA_END, nullptr, 0);
+  addText(session, "READY");
+  Decoded decoded = decode(session.stream, 3);
+  CHECK(decoded.lines == std::vector<std::string>(1, "READY"));
+  CHECK(decoded.frames.size() == 1);
+}
+
+static void testRandomErrors() {
+  Session session = makeSession();
+  uint32_t seed = 7;
+  unsigned long frames = 0, sent = 0, errors = 0, intact = 0;
+  for(int run = 0; run < 2000; run++) {
+    Bytes stream = session.stream;
+    for(int i = 0; i < 3; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      stream[(seed >> 8) % stream.size()] ^= (uint8_t)(1 << ((seed >> 4) & 7));
+    }
+    Decoded decoded = decode(stream, 1 + run % 97);
+    checkFrames(session, decoded);
+    frames += decoded.frames.size();
+    sent += session.frames.size();
+    errors += decoded.crc_errors;
+    if(decoded.lines.size() >= 1 && decoded.lines.back() == "READY") intact++;
+  }
+  printf("random errors: 2000 runs with 3 bit flips, %lu of %lu frames accepted, %lu CRC errors, "
+         "last READY intact in %lu runs, no wrong frame accepted\n", frames, sent, errors, intact);
+}
+
+int main() {
+  testClean();
+  testCorruptFrame(kFrameHeaderSize + 10, 0x01); // Payload
+  testCorruptFrame(kFrameHeaderSize + 40, 0x80);
+  Session session = makeSession();
+  size_t crc = session.frames[4].size() - 1;
+  testCorruptFrame(crc, 0xFF);                   // CRC
+  testCorruptFrame(2, 0x04);                     // Type
+  testCorruptLength();
+  testCutLine();
+  testRandomErrors();
+  printf("frame_decoder: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,119 @@
+// Main loop time spent on the HX711, blocking reads vs the continuous mode
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -DARDUINO=10819 -I dsp_host/mock -I libraries/HX711_Arduino_Library/src -o hx711_continuous_benchmark dsp_host/hx711_continuous_benchmark.cpp libraries/HX711_Arduino_Library/src/HX711.cpp
+//   ./hx711_continuous_benchmark
+//
+// The loop does 1 ms of other work per pass and every 100 ms stalls for
+// 30 ms, about a whole frame pushed to the display. The weight is read
+// three ways: get_units(5) every 100 ms, read() whenever is_ready(), and
+// popping the readings the DOUT interrupt took in continuous mode. Every
+// reading is checked against the conversion sequence of the simulated chip.
+#include <cstdio>
+
+#include "HX711.h"
+#include "HX711_device.h"
+
+static const uint8_t kDout = 4;
+static const uint8_t kSck = 5;
+static const unsigned long kRunMs = 10000;
+static const unsigned long kWorkUs = 1000;
+static const unsigned long kStallPeriodMs = 100;
+static const unsigned long kStallMs = 30;
+static const unsigned long kAverageMs = 100;
+
+enum Mode {
+  MODE_AVERAGE, // get_units(5) every 100 ms
+  MODE_POLL,    // read() when is_ready(), the cost of get_units(1)
+  MODE_CONTINUOUS
+};
+
+static const char* kModeNames[] = { "get_units(5)", "is_ready + read", "continuous" };
+
+struct Result {
+  unsigned long readings; // Readings the sketch got
+  unsigned long lost;     // Conversions never clocked out
+  unsigned long blocked_us;
+  unsigned long worst_call_us;
+  unsigned long worst_latency_us;
+  bool ok;
+};
+
+static Result run(Mode mode, unsigned long rate) {
+  MockHX711 chip(kDout, kSck, rate);
+  mockAttachPin(kDout, &chip);
+  mockAttachPin(kSck, &chip);
+
+  HX711 scale;
+  scale.begin(kDout, kSck);
+  if(mode == MODE_CONTINUOUS) scale.start_continuous();
+
+  Result result = {};
+  result.ok = true;
+  uint32_t last = 0;
+  unsigned long start = millis();
+  unsigned long next_average = start;
+  unsigned long next_stall = start + kStallPeriodMs;
+  while(millis() - start < kRunMs) {
+    unsigned long call = micros();
+    if(mode == MODE_AVERAGE) {
+      if((long)(millis() - next_average) >= 0) {
+        next_average += kAverageMs;
+        scale.get_units(5);
+        result.readings += 5;
+      }
+    } else if(mode == MODE_POLL) {
+      if(scale.is_ready()) {
+        uint32_t conversion = MockHX711::conversionOf(scale.read());
+        if(conversion <= last || conversion > chip.conversions()) result.ok = false;
+        last = conversion;
+        result.readings++;
+      }
+    } else {
+      long value;
+      while(scale.pop(value)) {
+        uint32_t conversion = MockHX711::conversionOf(value);
+        if(conversion <= last || conversion > chip.conversions()) result.ok = false;
+        last = conversion;
+        result.readings++;
+      }
+    }
+    unsigned long elapsed = micros() - call;
+    result.blocked_us += elapsed;
+    if(elapsed > result.worst_call_us) result.worst_call_us = elapsed;
+
+    advanceMicros(kWorkUs);
+    if((long)(millis() - next_stall) >= 0) {
+      next_stall += kStallPeriodMs;
+      advanceMicros(kStallMs * 1000);
+    }
+  }
+
+  if(mode == MODE_CONTINUOUS) {
+    if(scale.get_overruns() > 0) result.ok = false;
+    scale.stop_continuous();
+  }
+  result.lost = chip.lost();
+  result.worst_latency_us = chip.worstLatencyUs();
+  mockDetachPins();
+  return result;
+}
+
+int main() {
+  printf("%lu s, %lu ms of work per pass, %lu ms stall every %lu ms\n\n", kRunMs / 1000, kWorkUs / 1000,
+         kStallMs, kStallPeriodMs);
+  printf("SPS  read                     readings/s  lost/s  blocked   worst call  worst latency  check\n");
+
+  const unsigned long kRates[] = { 10, 80 };
+  for(unsigned long rate : kRates) {
+    for(int mode = MODE_AVERAGE; mode <= MODE_CONTINUOUS; mode++) {
+      Result result = run((Mode)mode, rate);
+      double seconds = kRunMs / 1000.0;
+      printf("%3lu  %-23s  %10.1f  %6.1f  %5.1f %%  %7.2f ms  %10.2f ms  %s\n", rate, kModeNames[mode],
+             result.readings / seconds, result.lost / seconds, result.blocked_us / (kRunMs * 10.0),
+             result.worst_call_us / 1000.0, result.worst_latency_us / 1000.0,
+             mode == MODE_AVERAGE ? "-" : (result.ok ? "ok" : "FAILED"));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+// MAX30102 FIFO overflows while the SSD1306 shares the I2C bus, whole frames vs I2CBus chunks
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -I dsp_host/mock -I libraries/MAX3010x_Sensor_Library/src -o i2c_arbiter_benchmark dsp_host/i2c_arbiter_benchmark.cpp libraries/MAX3010x_Sensor_Library/src/MAX30105.cpp
+//   ./i2c_arbiter_benchmark
+//
+// Simulates the bus of FinalIntegration: a 128x64 frame is pushed every 100 ms
+// and the MAX30102 is drained on its almost full interrupt at 100 kHz. Whole
+// frames hold the bus like display() under one lock, chunks are sized by
+// I2CBus::displayChunkBytes() and the drain gets the bus before the next chunk.
+// Time advances by the bus time of every transfer.
+#include <cstdio>
+
+#include "MAX30105.h"
+#include "MAX3010x_device.h"
+
+#include "../FinalIntegration/i2c_bus.h"
+
+TwoWire Wire;
+
+static const unsigned long kRunMs = 10000;
+static const unsigned long kFramePeriodMs = 100;
+static const uint32_t kSensorClock = 100000;
+static const uint8_t kAlmostFull = 15;
+static const unsigned long kStepUs = 50;
+
+// Same layout as FinalIntegration
+static const uint16_t kWidth = 128;
+static const uint16_t kFrameBytes = 128 * 64 / 8;
+static const unsigned long kBudgetUs = 2000;
+static const size_t kChunkOverhead = 10;
+
+struct Result {
+  unsigned long samples;
+  unsigned long lost;
+  unsigned long frames;
+  unsigned long worst_wait_us; // Interrupt to start of the drain
+};
+
+// Bus time of one display write, 9 clocks per byte plus START and STOP per transaction
+static unsigned long displayMicros(uint16_t count, uint32_t clock, bool whole) {
+  // display() sends its window in two transactions, displayChunk() in one
+  unsigned long transactions = whole ? 2 : 1;
+  unsigned long bytes = whole ? 7 + 3 : 8;
+  unsigned long data_transactions = (count + I2C_BUFFER_LENGTH - 2) / (I2C_BUFFER_LENGTH - 1);
+  transactions += data_transactions;
+  bytes += count + 2 * data_transactions;
+  return (unsigned long)((bytes * 9.0 + transactions * 2.0) * 1e6 / clock);
+}
+
+static Result run(MAX30105::SamplingRate rate, uint32_t display_clock, bool chunked) {
+  TwoWire wire;
+  MockMAX3010x device;
+  wire.attach(0x57, &device);
+  wire.setClock(kSensorClock);
+
+  MAX30105 sensor(0x57, wire);
+  Result result = {};
+  if(!sensor.begin() || !sensor.setSamplingRate(rate) || !sensor.setFIFOAlmostFull(kAlmostFull) ||
+     !sensor.enableInterrupt(sensor.INT_A_FULL) || !sensor.clearInterrupts()) {
+    printf("sensor setup failed\n");
+    return result;
+  }
+
+  I2CBus bus(display_clock, kBudgetUs);
+  uint16_t chunk = (uint16_t)bus.displayChunkBytes(kChunkOverhead);
+
+  uint16_t offset = kFrameBytes; // No frame pending
+  unsigned long next_frame = millis();
+  bool waiting = false;
+  unsigned long waiting_since = 0;
+  unsigned long start = millis();
+  while(millis() - start < kRunMs) {
+    if(!waiting && !device.interruptPin()) {
+      waiting = true;
+      waiting_since = micros();
+    }
+
+    // A waiting drain always gets the bus once it is free
+    if(waiting) {
+      unsigned long wait = micros() - waiting_since;
+      if(wait > result.worst_wait_us) result.worst_wait_us = wait;
+      double before = wire.stats().busMicros(kSensorClock);
+      MAX30105Sample samples[32];
+      sensor.clearInterrupts();
+      result.samples += sensor.readSamples(samples, 32);
+      advanceMicros((unsigned long)(wire.stats().busMicros(kSensorClock) - before));
+      waiting = false;
+      continue;
+    }
+
+    if(offset < kFrameBytes) {
+      uint16_t count = kFrameBytes - offset;
+      if(chunked) {
+        count = chunk < kWidth - offset % kWidth ? chunk : kWidth - offset % kWidth;
+      }
+
+      // The bus is held, the interrupt can only be noticed
+      unsigned long busy = displayMicros(count, display_clock, !chunked);
+      for(unsigned long t = 0; t < busy; t += kStepUs) {
+        advanceMicros(busy - t < kStepUs ? busy - t : kStepUs);
+        if(!waiting && !device.interruptPin()) {
+          waiting = true;
+          waiting_since = micros();
+        }
+      }
+      offset += count;
+      if(offset >= kFrameBytes) result.frames++;
+      continue;
+    }
+
+    if((long)(millis() - next_frame) >= 0) {
+      next_frame += kFramePeriodMs;
+      offset = 0;
+      continue;
+    }
+    advanceMicros(kStepUs);
+  }
+  result.lost = sensor.lostSamples();
+  return result;
+}
+
+int main() {
+  printf("%lu s, frame every %lu ms, drain at %lu kHz on A_FULL (%d free), display budget %lu us\n\n",
+         kRunMs / 1000, kFramePeriodMs, (unsigned long)(kSensorClock / 1000), kAlmostFull, kBudgetUs);
+  printf("   SPS  display  frames   chunk  samples   lost  worst wait\n");
+
+  const MAX30105::SamplingRate kRates[] = { MAX30105::SAMPLING_RATE_400SPS, MAX30105::SAMPLING_RATE_800SPS };
+  const unsigned long kRateValues[] = { 400, 800 };
+  const uint32_t kClocks[] = { 400000, 100000 };
+  for(int r = 0; r < 2; r++) {
+    for(uint32_t clock : kClocks) {
+      for(int chunked = 0; chunked <= 1; chunked++) {
+        Result result = run(kRates[r], clock, chunked);
+        char chunk[16];
+        if(chunked) snprintf(chunk, sizeof(chunk), "%u B", (unsigned)I2CBus(clock, kBudgetUs).displayChunkBytes(kChunkOverhead));
+        else snprintf(chunk, sizeof(chunk), "frame");
+        printf("%6lu  %3lu kHz  %6lu  %6s  %7lu  %5lu  %7.1f ms\n", kRateValues[r], (unsigned long)(clock / 1000),
+               result.frames, chunk, result.samples, result.lost, result.worst_wait_us / 1000.0);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,205 @@
+// I2C traffic of draining the MAX30105 FIFO with readSample() vs readSamples()
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -I dsp_host/mock -I libraries/MAX3010x_Sensor_Library/src -o max3010x_fifo_benchmark dsp_host/max3010x_fifo_benchmark.cpp libraries/MAX3010x_Sensor_Library/src/MAX30105.cpp
+//   ./max3010x_fifo_benchmark
+//
+// Add -DI2C_BUFFER_LENGTH=32 to see the chunking of an AVR sized Wire buffer.
+// The sensor runs in SpO2 mode at 400 SPS on a simulated bus; the FIFO is
+// drained at a fixed interval for 10 s, like consumeSPO2() in FinalIntegration.
+// The second table drains on the FIFO almost full interrupt at higher rates
+// like spo2ReaderTask: on a falling edge of the interrupt pin, checked every
+// 1 ms of simulated time, or when the fallback timeout runs out. It compares
+// leaving the status registers alone with a 100 ms timeout against clearing
+// them before each drain, with the same timeout and with 30 ms. The power
+// ready flag latched at power-up holds the pin low until the status is read.
+// The last table drains too slowly on purpose and checks the sequence index of
+// every sample against the simulated sample number, with and without FIFO
+// rollover.
+#include <cstdio>
+
+#include "MAX30105.h"
+#include "MAX3010x_device.h"
+
+TwoWire Wire;
+
+static const unsigned long kRunMs = 10000;
+static const uint32_t kI2CClock = 400000;
+static const uint8_t kAlmostFull = 15;
+
+struct Result {
+  MockI2CStats stats;
+  unsigned long samples;
+  unsigned long errors;
+};
+
+// Checks the data and the sequence index, expected is the next contiguous index
+static bool checkSample(const MAX30105Sample& sample, uint32_t& expected) {
+  uint32_t index = sample.sequence;
+  bool ok = sample.valid && index == expected + sample.lost &&
+            sample.red == ((index * 4) & 0x3FFFF) && sample.ir == ((index * 4 + 1) & 0x3FFFF);
+  expected = index + 1;
+  return ok;
+}
+
+static Result run(unsigned long interval_ms, bool burst) {
+  TwoWire wire;
+  MockMAX3010x device;
+  wire.attach(0x57, &device);
+  wire.setClock(kI2CClock);
+
+  MAX30105 sensor(0x57, wire);
+  Result result = {};
+  if(!sensor.begin() || !sensor.setSamplingRate(sensor.SAMPLING_RATE_400SPS)) {
+    printf("sensor setup failed\n");
+    return result;
+  }
+
+  wire.resetStats();
+  uint32_t expected = 0;
+  unsigned long start = millis();
+  while(millis() - start < kRunMs) {
+    delay(interval_ms);
+
+    if(burst) {
+      MAX30105Sample samples[32];
+      size_t count = sensor.readSamples(samples, 32);
+      for(size_t i = 0; i < count; i++) {
+        if(!checkSample(samples[i], expected)) result.errors++;
+      }
+      result.samples += count;
+    }
+    else {
+      uint8_t pending = sensor.available();
+      while(pending--) {
+        if(!checkSample(sensor.readSample(), expected)) result.errors++;
+        result.samples++;
+      }
+    }
+  }
+  result.stats = wire.stats();
+  return result;
+}
+
+static Result runInterrupt(MAX30105::SamplingRate rate, uint8_t almost_full, bool clear, unsigned long timeout_ms,
+                           uint32_t& produced, uint32_t& lost) {
+  TwoWire wire;
+  MockMAX3010x device;
+  wire.attach(0x57, &device);
+  wire.setClock(kI2CClock);
+
+  MAX30105 sensor(0x57, wire);
+  Result result = {};
+  if(!sensor.begin() || !sensor.setSamplingRate(rate) || !sensor.setFIFOAlmostFull(almost_full) ||
+     !sensor.enableInterrupt(sensor.INT_A_FULL)) {
+    printf("sensor setup failed\n");
+    return result;
+  }
+
+  if(clear) sensor.clearInterrupts();
+
+  wire.resetStats();
+  uint32_t expected = 0;
+  unsigned long start = millis();
+  unsigned long drained = start;
+  bool level = device.interruptPin();
+  while(millis() - start < kRunMs) {
+    delay(1);
+    bool previous = level;
+    level = device.interruptPin();
+    bool edge = previous && !level;
+    if(!edge && millis() - drained < timeout_ms) continue;
+    drained = millis();
+
+    if(clear) sensor.clearInterrupts();
+    MAX30105Sample samples[32];
+    size_t count = sensor.readSamples(samples, 32);
+    for(size_t i = 0; i < count; i++) {
+      if(!checkSample(samples[i], expected)) result.errors++;
+    }
+    result.samples += count;
+  }
+  result.stats = wire.stats();
+  produced = device.produced();
+  lost = sensor.lostSamples();
+  return result;
+}
+
+static Result runOverflow(unsigned long interval_ms, bool rollover, uint32_t& lost) {
+  TwoWire wire;
+  MockMAX3010x device;
+  wire.attach(0x57, &device);
+
+  MAX30105 sensor(0x57, wire);
+  Result result = {};
+  if(!sensor.begin() || !sensor.setSamplingRate(sensor.SAMPLING_RATE_400SPS) ||
+     !(rollover ? sensor.enableFIFORollover() : sensor.disableFIFORollover())) {
+    printf("sensor setup failed\n");
+    return result;
+  }
+
+  uint32_t expected = 0;
+  unsigned long start = millis();
+  while(millis() - start < kRunMs) {
+    delay(interval_ms);
+    MAX30105Sample samples[32];
+    size_t count = sensor.readSamples(samples, 32);
+    for(size_t i = 0; i < count; i++) {
+      if(!checkSample(samples[i], expected)) result.errors++;
+    }
+    result.samples += count;
+  }
+  lost = sensor.lostSamples();
+  return result;
+}
+
+int main() {
+  printf("Wire buffer %d bytes, I2C at %lu kHz, %lu s at 400 SPS\n\n",
+         I2C_BUFFER_LENGTH, (unsigned long)kI2CClock / 1000, kRunMs / 1000);
+  printf("drain ms  method       samples  transactions  per s   bus ms/s  errors  reduction\n");
+
+  const unsigned long kIntervals[] = { 5, 10, 25, 50, 75 };
+  for(unsigned long interval : kIntervals) {
+    Result single = run(interval, false);
+    Result burst = run(interval, true);
+    double seconds = kRunMs / 1000.0;
+    printf("%8lu  readSample   %7lu  %12lu  %6.0f  %8.1f  %6lu\n", interval, single.samples,
+           single.stats.transactions, single.stats.transactions / seconds,
+           single.stats.busMicros(kI2CClock) / 1000 / seconds, single.errors);
+    printf("%8lu  readSamples  %7lu  %12lu  %6.0f  %8.1f  %6lu  %8.1fx\n", interval, burst.samples,
+           burst.stats.transactions, burst.stats.transactions / seconds,
+           burst.stats.busMicros(kI2CClock) / 1000 / seconds, burst.errors,
+           (double)single.stats.transactions / burst.stats.transactions);
+  }
+
+  printf("\nA_FULL interrupt, threshold %d free entries\n", kAlmostFull);
+  printf("    SPS  status   timeout  produced  samples  lost  transactions  per s   bus ms/s  errors\n");
+  const MAX30105::SamplingRate kRates[] = { MAX30105::SAMPLING_RATE_400SPS, MAX30105::SAMPLING_RATE_1000SPS, MAX30105::SAMPLING_RATE_1600SPS };
+  const unsigned long kRateValues[] = { 400, 1000, 1600 };
+  for(int i = 0; i < 3; i++) {
+    for(int run = 0; run < 3; run++) {
+      uint32_t produced = 0, lost = 0;
+      bool clear = run > 0;
+      unsigned long timeout = run < 2 ? 100 : 30;
+      Result result = runInterrupt(kRates[i], kAlmostFull, clear, timeout, produced, lost);
+      double seconds = kRunMs / 1000.0;
+      printf("%7lu  %-7s  %4lu ms  %8lu  %7lu  %4lu  %12lu  %6.0f  %8.1f  %6lu\n", kRateValues[i],
+             clear ? "cleared" : "latched", timeout, (unsigned long)produced, result.samples, (unsigned long)lost,
+             result.stats.transactions, result.stats.transactions / seconds,
+             result.stats.busMicros(kI2CClock) / 1000 / seconds, result.errors);
+    }
+  }
+
+  printf("\nFIFO overflow at 400 SPS, sequence errors count samples with a wrong index\n");
+  printf("drain ms  rollover  samples  lost  errors\n");
+  const unsigned long kSlowIntervals[] = { 100, 150 };
+  for(unsigned long interval : kSlowIntervals) {
+    for(int rollover = 1; rollover >= 0; rollover--) {
+      uint32_t lost = 0;
+      Result result = runOverflow(interval, rollover, lost);
+      printf("%8lu  %8s  %7lu  %4lu  %6lu\n", interval, rollover ? "on" : "off", result.samples,
+             (unsigned long)lost, result.errors);
+    }
+  }
+  return 0;
+}
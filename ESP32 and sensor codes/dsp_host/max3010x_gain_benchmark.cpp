@@ -0,0 +1,70 @@
+// Convergence of MAX3010xGainControl on a simulated finger
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -I dsp_host/mock -I libraries/MAX3010x_Sensor_Library/src -o max3010x_gain_benchmark dsp_host/max3010x_gain_benchmark.cpp libraries/MAX3010x_Sensor_Library/src/MAX30105.cpp
+//   ./max3010x_gain_benchmark
+//
+// Starts from the library default LED currents for fingers from very weak to
+// very strong perfusion and reports when both channels reach the DC target band.
+#include <cstdio>
+
+#include "MAX3010x.h"
+#include "MAX3010x_device.h"
+
+TwoWire Wire;
+
+static const unsigned long kRunMs = 4000;
+static const unsigned long kDrainMs = 10;
+
+static void run(const char* name, float red, float ir) {
+  TwoWire wire;
+  MockMAX3010x device;
+  wire.attach(0x57, &device);
+  device.setTissue(red, ir);
+
+  MAX30105 sensor(0x57, wire);
+  MAX3010xGainControl<MAX30105> gain(sensor);
+  if(!sensor.begin() || !sensor.setSamplingRate(sensor.SAMPLING_RATE_400SPS) || !gain.apply()) {
+    printf("sensor setup failed\n");
+    return;
+  }
+
+  unsigned long start = millis();
+  long settled_ms = -1;
+  int steps = 0;
+  uint32_t last_red = 0, last_ir = 0;
+  while(millis() - start < kRunMs) {
+    delay(kDrainMs);
+    MAX30105Sample samples[32];
+    size_t count = sensor.readSamples(samples, 32);
+    for(size_t i = 0; i < count; i++) {
+      if(gain.process(samples[i].red, samples[i].ir)) {
+        gain.apply();
+        steps++;
+        settled_ms = -1;
+      }
+      last_red = samples[i].red;
+      last_ir = samples[i].ir;
+    }
+    if(gain.settled() && settled_ms < 0) settled_ms = millis() - start;
+  }
+
+  static const int kRangeNa[] = { 2048, 4096, 8192, 16384 };
+  char settled[24];
+  if(settled_ms >= 0) snprintf(settled, sizeof(settled), "%ld ms", settled_ms);
+  else snprintf(settled, sizeof(settled), "no");
+  printf("%-10s %8s  %5d  %5.1f mA  %5.1f mA  %5d nA  %7lu  %7lu\n", name, settled, steps,
+         gain.redCurrent() * 0.2, gain.irCurrent() * 0.2, kRangeNa[gain.adcRange()],
+         (unsigned long)last_red, (unsigned long)last_ir);
+}
+
+int main() {
+  printf("400 SPS, target band 0x10000 to 0x24000, start 18 mA red, 16 mA IR, 16384 nA\n\n");
+  printf("finger     settled   steps  red       IR        range     red DC   IR DC\n");
+  run("very weak", 40, 60);
+  run("weak", 300, 450);
+  run("normal", 3000, 4500);
+  run("strong", 15000, 22000);
+  run("clipping", 60000, 90000);
+  return 0;
+}
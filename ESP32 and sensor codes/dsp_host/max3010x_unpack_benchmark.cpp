@@ -0,0 +1,145 @@
+// Throughput of unpacking raw MAX3010x FIFO data
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -I dsp_host/mock -I libraries/MAX3010x_Sensor_Library/src -o max3010x_unpack_benchmark dsp_host/max3010x_unpack_benchmark.cpp libraries/MAX3010x_Sensor_Library/src/MAX30105.cpp
+//   ./max3010x_unpack_benchmark
+//
+// Compares the per sample unpacking of readSample()/readSamples(), which loops
+// over the active slots at run time and fills one struct per sample, with
+// MAX3010xUnpacker, which unpacks a burst into one array per slot. Finally reads
+// red, IR and green from a simulated MAX30105 with readRawSamples() and checks
+// every value.
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "MAX3010x.h"
+#include "MAX3010x_device.h"
+
+TwoWire Wire;
+
+static const size_t kSamples = 1 << 20;
+static const size_t kBurst = 32;
+static const int kRuns = 20;
+
+// Run time slot count, like nActiveSlots in the driver
+volatile uint8_t activeSlots = 2;
+
+// Same loop as MAX3010xMultiLed::fillSampleWithData()
+static void unpackPerSample(const uint8_t* data, size_t count, MAX30105Sample* samples) {
+  const uint8_t slots = activeSlots;
+  for(size_t n = 0; n < count; n++) {
+    MAX30105Sample& sample = samples[n];
+    sample.valid = true;
+    for(int i = 0; i < slots; i++) {
+      sample.slot[i] = (static_cast<uint32_t>(data[0 + 3*i]) << 16) | (static_cast<uint32_t>(data[1 + 3*i]) << 8) | static_cast<uint32_t>(data[2 + 3*i]);
+    }
+    data += 3 * slots;
+  }
+}
+
+template<typename Function> static double samplesPerSecond(Function function) {
+  double best = 0;
+  for(int run = 0; run < kRuns; run++) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(kSamples / seconds > best) best = kSamples / seconds;
+  }
+  return best;
+}
+
+template<typename Unpacker> static void benchmark(const char* name, const std::vector<uint8_t>& raw) {
+  const uint8_t slots = Unpacker::SLOT_COUNT;
+  activeSlots = slots;
+
+  std::vector<MAX30105Sample> samples(kBurst);
+  std::vector<std::vector<uint32_t> > channels(slots, std::vector<uint32_t>(kBurst));
+  uint32_t* outputs[4] = {};
+  for(uint8_t s = 0; s < slots; s++) outputs[s] = &channels[s][0];
+  uint32_t checksum = 0;
+
+  double per_sample = samplesPerSecond([&]() {
+    for(size_t i = 0; i < kSamples; i += kBurst) {
+      unpackPerSample(&raw[i * slots * 3], kBurst, &samples[0]);
+      checksum += samples[kBurst - 1].slot[slots - 1];
+    }
+  });
+
+  size_t mismatches = 0;
+  double soa = samplesPerSecond([&]() {
+    for(size_t i = 0; i < kSamples; i += kBurst) {
+      Unpacker::unpack(&raw[i * slots * 3], kBurst, outputs);
+      checksum += channels[slots - 1][kBurst - 1];
+    }
+  });
+
+  // Both variants must agree
+  for(size_t i = 0; i < kSamples; i += kBurst) {
+    unpackPerSample(&raw[i * slots * 3], kBurst, &samples[0]);
+    Unpacker::unpack(&raw[i * slots * 3], kBurst, outputs);
+    for(size_t n = 0; n < kBurst; n++) {
+      for(uint8_t s = 0; s < slots; s++) {
+        if(samples[n].slot[s] != channels[s][n]) mismatches++;
+      }
+    }
+  }
+
+  printf("%-16s %8.1f  %8.1f  %5.2fx  %lu mismatches  (%u)\n", name, per_sample / 1e6, soa / 1e6,
+         soa / per_sample, (unsigned long)mismatches, (unsigned)checksum);
+}
+
+typedef MAX3010xUnpacker<MAX30105, MAX30105::SLOT_RED> RedUnpacker;
+typedef MAX3010xUnpacker<MAX30105, MAX30105::SLOT_RED, MAX30105::SLOT_IR> RedIrUnpacker;
+typedef MAX3010xUnpacker<MAX30105, MAX30105::SLOT_RED, MAX30105::SLOT_IR, MAX30105::SLOT_GREEN> RedIrGreenUnpacker;
+
+// Reads from the simulated sensor and checks the values, slot s of sample n is n * 4 + s
+static void checkSensor() {
+  TwoWire wire;
+  MockMAX3010x device;
+  wire.attach(0x57, &device);
+
+  MAX30105 sensor(0x57, wire);
+  if(!sensor.begin() || !sensor.setSamplingRate(sensor.SAMPLING_RATE_400SPS) ||
+     !sensor.setMultiLedConfiguration(RedIrGreenUnpacker::configuration()) || !sensor.setMode(MAX30105::MODE_MULTI_LED)) {
+    printf("sensor setup failed\n");
+    return;
+  }
+
+  uint8_t raw[kBurst * RedIrGreenUnpacker::SAMPLE_BYTES];
+  uint32_t red[kBurst], ir[kBurst], green[kBurst];
+  uint32_t* channels[] = { red, ir, green };
+  size_t total = 0;
+  size_t errors = 0;
+  for(int burst = 0; burst < 100; burst++) {
+    delay(50);
+    uint32_t sequence;
+    uint16_t lost;
+    size_t count = sensor.readRawSamples(raw, kBurst, sequence, lost);
+    RedIrGreenUnpacker::unpack(raw, count, channels);
+    for(size_t n = 0; n < count; n++) {
+      uint32_t index = sequence + n;
+      if(red[n] != index * 4 || ir[n] != index * 4 + 1 || green[n] != index * 4 + 2) errors++;
+    }
+    total += count;
+  }
+  printf("\nSimulated MAX30105, red/IR/green at 400 SPS: %lu bytes per sample, %lu samples, %lu errors\n",
+         (unsigned long)sensor.bytesPerSample(), (unsigned long)total, (unsigned long)errors);
+}
+
+int main() {
+  std::vector<uint8_t> raw(kSamples * 12);
+  unsigned int seed = 1;
+  for(size_t i = 0; i < raw.size(); i++) {
+    seed = seed * 1103515245 + 12345;
+    raw[i] = (i % 3 == 0) ? (seed >> 16) & 0x03 : (seed >> 16) & 0xFF; // 18 bit values
+  }
+
+  printf("%u samples in bursts of %u, Msamples/s\n", (unsigned)kSamples, (unsigned)kBurst);
+  printf("slots            per sample  SoA     speedup\n");
+  benchmark<RedUnpacker>("red", raw);
+  benchmark<RedIrUnpacker>("red, IR", raw);
+  benchmark<RedIrGreenUnpacker>("red, IR, green", raw);
+  checkSensor();
+  return 0;
+}
@@ -0,0 +1,143 @@
+// Cost per sample of SlidingMedianFilter and SlidingTrimmedMeanFilter across window sizes
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -o median_filter_benchmark dsp_host/median_filter_benchmark.cpp
+//   ./median_filter_benchmark
+//
+// Compares the heap based filters with the approach of HC_SignalFilter::median(),
+// which copies the window into a working array and sorts it for every sample.
+// Both an insertion sort and std::sort are timed for it. The median is also
+// timed with the sorted copy that SlidingMedianFilter uses for short windows.
+// The input is an 80 SPS load cell reading with 2% spikes. Every output is
+// compared with the sorted reference: the medians have to match it exactly,
+// the trimmed means carry the rounding of a running float sum.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Arduino definitions used by filters.h
+using std::isnan;
+using std::max;
+using std::min;
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#include "../FinalIntegration/filters.h"
+
+// Copy and sort the window for every sample
+template<int kWindow, bool kInsertion> class SortingTrimmedMeanFilter {
+  float values_[kWindow];
+  float sorted_[kWindow];
+  int trim_;
+  int index_;
+  int count_;
+public:
+  explicit SortingTrimmedMeanFilter(int trim) :
+    trim_(std::min(trim, (kWindow - 1) / 2)),
+    index_(0),
+    count_(0) {}
+
+  float process(float value) {
+    values_[index_] = value;
+    index_ = (index_ + 1) % kWindow;
+    if(count_ < kWindow) count_++;
+
+    std::copy(values_, values_ + count_, sorted_);
+    if(kInsertion) {
+      for(int i = 1; i < count_; i++) {
+        float v = sorted_[i];
+        int j = i;
+        for(; j > 0 && sorted_[j - 1] > v; j--) sorted_[j] = sorted_[j - 1];
+        sorted_[j] = v;
+      }
+    } else {
+      std::sort(sorted_, sorted_ + count_);
+    }
+
+    int trim = std::min(trim_, (count_ - 1) / 2);
+    float sum = 0;
+    for(int i = trim; i < count_ - trim; i++) sum += sorted_[i];
+    return sum / (count_ - 2 * trim);
+  }
+};
+
+// SlidingMedianFilter with the constructor of the trimmed means
+template<int kWindow, bool kSorted> struct MedianFilter : SlidingMedianFilter<kWindow, kSorted> {
+  explicit MedianFilter(int) {}
+};
+
+static const size_t kSamples = 1 << 16;
+
+template<typename Filter> static double nanosecondsPerSample(const std::vector<float>& input, int trim,
+                                                              std::vector<float>& output) {
+  Filter* filter = new Filter(trim);
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < input.size(); i++) {
+    output[i] = filter->process(input[i]);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  delete filter;
+  return seconds * 1e9 / input.size();
+}
+
+static double maxError(const std::vector<float>& a, const std::vector<float>& b) {
+  double error = 0;
+  for(size_t i = 0; i < a.size(); i++) error = std::max(error, (double)std::fabs(a[i] - b[i]));
+  return error;
+}
+
+template<int kWindow> static void benchmark(const std::vector<float>& input, const char* name, int trim,
+                                            bool median) {
+  std::vector<float> reference(input.size()), insertion(input.size()), heap(input.size()), copy(input.size());
+  double sorted = nanosecondsPerSample<SortingTrimmedMeanFilter<kWindow, false> >(input, trim, reference);
+  double inserted = nanosecondsPerSample<SortingTrimmedMeanFilter<kWindow, true> >(input, trim, insertion);
+  double heaps = median ? nanosecondsPerSample<MedianFilter<kWindow, false> >(input, trim, heap)
+                        : nanosecondsPerSample<SlidingTrimmedMeanFilter<kWindow> >(input, trim, heap);
+  double error = std::max(maxError(heap, reference), maxError(insertion, reference));
+  if(!median) {
+    printf("%-8s %6d  %11.1f  %11.1f  %9.1f  %10s  %8.1fx  %9.2e\n", name, kWindow, inserted, sorted, heaps, "-",
+           std::min(inserted, sorted) / heaps, error);
+    return;
+  }
+
+  double copied = nanosecondsPerSample<MedianFilter<kWindow, true> >(input, trim, copy);
+  error = std::max(error, maxError(copy, reference));
+  if(error != 0) {
+    printf("FAILED: median %d off by %g\n", kWindow, error);
+    exit(1);
+  }
+  printf("%-8s %6d  %11.1f  %11.1f  %9.1f  %10.1f  %8.1fx  %9.2e\n", name, kWindow, inserted, sorted, heaps, copied,
+         std::min(inserted, sorted) / std::min(heaps, copied), error);
+}
+
+template<int kWindow> static void benchmark(const std::vector<float>& input) {
+  benchmark<kWindow>(input, "median", (kWindow - 1) / 2, true);
+  benchmark<kWindow>(input, "trim 25%", kWindow / 4, false);
+}
+
+int main() {
+  // Load cell in grams at 80 SPS: a slowly changing load, noise and 2% spikes
+  std::vector<float> input(kSamples);
+  unsigned int seed = 1;
+  for(size_t i = 0; i < kSamples; i++) {
+    seed = seed * 1103515245 + 12345;
+    float value = 500 + 20 * sin(i * 0.002) + ((seed >> 16) % 100) * 0.01f;
+    if((seed >> 8) % 50 == 0) value += ((seed >> 4) & 1 ? 1 : -1) * 300.0f;
+    input[i] = value;
+  }
+
+  printf("filter   window  insertion ns  std::sort ns  heaps ns  sorted ns   speedup  max error\n");
+  benchmark<3>(input);
+  benchmark<5>(input);
+  benchmark<9>(input);
+  benchmark<15>(input);
+  benchmark<31>(input);
+  benchmark<63>(input);
+  benchmark<127>(input);
+  benchmark<255>(input);
+  return 0;
+}
@@ -0,0 +1,120 @@
+// I2C traffic and bad temperatures of the MLX90614, polled reads vs performReading() vs readObjectTempC()
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -I dsp_host/mock -I libraries/Adafruit_BusIO -I libraries/Adafruit_MLX90614_Library -o mlx90614_cache_benchmark dsp_host/mlx90614_cache_benchmark.cpp libraries/Adafruit_MLX90614_Library/Adafruit_MLX90614.cpp libraries/Adafruit_BusIO/Adafruit_I2CDevice.cpp
+//   ./mlx90614_cache_benchmark
+//
+// The temperature window of FinalIntegration is read four ways: one word of
+// TOBJ1 every 50 ms with the PEC ignored, as the sketch and library did,
+// performReading() on every 5 ms pass of the main loop, performReading() from
+// a task running at getUpdatePeriod(), and readObjectTempC() from that task as
+// the sketch does now. performReading() also fetches TA, which the sketch
+// never uses. Data bytes on the bus are corrupted at a fixed rate, every value
+// the sketch keeps is checked against the refresh of the simulated sensor.
+#include <cstdio>
+
+#include <Adafruit_MLX90614.h>
+
+#include "MLX90614_device.h"
+
+TwoWire Wire;
+
+static const unsigned long kRunMs = 60000;
+static const unsigned long kPassUs = 5000;
+static const unsigned long kPollMs = 50;
+static const uint32_t kClock = 100000;
+
+enum Mode {
+  MODE_POLL,      // One TOBJ1 word every 50 ms, PEC ignored
+  MODE_EVERY_PASS,
+  MODE_PERIOD,
+  MODE_OBJECT     // readObjectTempC() at the update period
+};
+
+static const char* kModeNames[] = { "read word every 50 ms", "performReading each pass",
+                                    "performReading at period", "readObjectTempC at period" };
+
+struct Result {
+  unsigned long transactions;
+  double bus_us;
+  unsigned long fresh;     // Values from a refresh not seen before
+  unsigned long repeated;  // Values the sketch already had
+  unsigned long corrupted; // Values that no refresh produced
+  unsigned long pec_errors;
+};
+
+static uint16_t rawOf(double celsius) {
+  return (uint16_t)lround((celsius + 273.15) / 0.02);
+}
+
+static void check(const MockMLX90614& chip, uint16_t raw, uint32_t& last, Result& result) {
+  if(raw != chip.objectWord()) {
+    result.corrupted++;
+  } else if(chip.refreshes() != last) {
+    result.fresh++;
+    last = chip.refreshes();
+  } else {
+    result.repeated++;
+  }
+}
+
+static Result run(Mode mode, double errorRate) {
+  MockMLX90614 chip;
+  Wire.attach(MLX90614_I2CADDR, &chip);
+
+  Adafruit_MLX90614 mlx;
+  mlx.begin();
+  Adafruit_I2CDevice device(MLX90614_I2CADDR, &Wire);
+  device.begin();
+  chip.setBitErrorRate(errorRate);
+  Wire.resetStats();
+
+  Result result = {};
+  uint32_t last = 0;
+  unsigned long start = millis();
+  unsigned long next = start;
+  unsigned long period = mode == MODE_POLL ? kPollMs : (mode == MODE_EVERY_PASS ? 0 : mlx.getUpdatePeriod());
+  while(millis() - start < kRunMs) {
+    if((long)(millis() - next) >= 0) {
+      next += period;
+      if(mode == MODE_POLL) {
+        // What the library did before the PEC was checked
+        uint8_t buffer[3] = { MLX90614_TOBJ1 };
+        if(device.write_then_read(buffer, 1, buffer, 3)) {
+          check(chip, (uint16_t)(buffer[0] | (buffer[1] << 8)), last, result);
+        }
+      } else if(mode == MODE_OBJECT) {
+        double celsius = mlx.readObjectTempC();
+        if(!isnan(celsius)) check(chip, rawOf(celsius), last, result);
+      } else if(mlx.performReading()) {
+        check(chip, rawOf(mlx.getObjectTempC()), last, result);
+      }
+    }
+    advanceMicros(kPassUs);
+  }
+
+  result.transactions = Wire.stats().transactions;
+  result.bus_us = Wire.stats().busMicros(kClock);
+  result.pec_errors = mlx.getPECErrors();
+  Wire.attach(MLX90614_I2CADDR, NULL);
+  return result;
+}
+
+int main() {
+  MockMLX90614 chip;
+  printf("%lu s, sensor refreshes every %lu ms, %lu ms per loop pass, %lu kHz\n\n", kRunMs / 1000,
+         chip.periodUs() / 1000, kPassUs / 1000, (unsigned long)(kClock / 1000));
+  printf("byte errors  read                       transactions/s  bus time  new/s  repeated/s  corrupted  PEC errors\n");
+
+  const double kErrorRates[] = { 0, 0.001, 0.01 };
+  for(double rate : kErrorRates) {
+    for(int mode = MODE_POLL; mode <= MODE_OBJECT; mode++) {
+      Result result = run((Mode)mode, rate);
+      double seconds = kRunMs / 1000.0;
+      printf("%11.3f  %-25s  %14.1f  %6.2f %%  %5.1f  %10.1f  %9lu  %10lu\n", rate, kModeNames[mode],
+             result.transactions / seconds, result.bus_us / (kRunMs * 10.0), result.fresh / seconds,
+             result.repeated / seconds, result.corrupted, result.pec_errors);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,271 @@
+// Minimal Arduino core for building sensor libraries on the host
+//
+// Time only advances through delay(), delayMicroseconds() or advanceMicros(),
+// so runs are deterministic. Pins do nothing unless a simulated chip is
+// attached to them with mockAttachPin(), interrupts are delivered from the
+// time steps and from interrupts().
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+enum BitOrder { LSBFIRST = 0, MSBFIRST = 1 };
+
+#define F(string_literal) (string_literal)
+#define PROGMEM
+
+// Only declared, for the signatures of the Adafruit libraries
+class __FlashStringHelper;
+
+/**
+ * @brief Read only view of a C string, enough for the Adafruit libraries
+ */
+class String {
+  const char* text_;
+public:
+  String(const char* text = "") : text_(text) {}
+  unsigned int length() const { return (unsigned int)strlen(text_); }
+  const char* c_str() const { return text_; }
+};
+
+template<typename T> inline T min(T a, T b) {
+  return b < a ? b : a;
+}
+
+template<typename T> inline T max(T a, T b) {
+  return a < b ? b : a;
+}
+
+#include "Print.h"
+
+inline unsigned long& mockMicros() {
+  static unsigned long now = 0;
+  return now;
+}
+
+/**
+ * @brief Simulated chip on one or more pins
+ */
+class MockPinDevice {
+public:
+  virtual ~MockPinDevice() {}
+
+  /**
+   * @brief Level the chip drives on a pin
+   */
+  virtual int read(uint8_t pin) = 0;
+
+  /**
+   * @brief Level the controller drives on a pin
+   */
+  virtual void write(uint8_t pin, uint8_t value) = 0;
+
+  /**
+   * @brief Called as mock time advances
+   */
+  virtual void update() {}
+};
+
+// Time every access of an attached pin takes, about a bit banged clock phase on the ESP32
+static const unsigned long kMockPinAccessUs = 1;
+// Longest time step while chips are attached, sets the interrupt latency
+static const unsigned long kMockPinStepUs = 10;
+
+struct MockPins {
+  static const uint8_t kCount = 64;
+  MockPinDevice* devices[kCount];
+  MockPinDevice* updated[4];
+  uint8_t updated_count;
+  int levels[kCount];
+  void (*handlers[kCount])();
+  int modes[kCount];
+  bool pending[kCount];
+  bool disabled;
+  bool in_handler;
+  bool updating;
+};
+
+inline MockPins& mockPins() {
+  static MockPins pins = {};
+  return pins;
+}
+
+/**
+ * @brief Run the handlers of pending interrupts unless interrupts are off
+ */
+inline void mockServiceInterrupts() {
+  MockPins& pins = mockPins();
+  if(pins.disabled || pins.in_handler) return;
+  bool again = true;
+  while(again) {
+    again = false;
+    for(uint8_t pin = 0; pin < MockPins::kCount; pin++) {
+      if(!pins.pending[pin]) continue;
+      pins.pending[pin] = false;
+      if(!pins.handlers[pin]) continue;
+      pins.in_handler = true;
+      pins.handlers[pin]();
+      pins.in_handler = false;
+      again = true;
+    }
+  }
+}
+
+/**
+ * @brief Chip changed the level of a pin, raises its interrupt on a matching edge
+ */
+inline void mockPinChanged(uint8_t pin, int level) {
+  MockPins& pins = mockPins();
+  int before = pins.levels[pin];
+  pins.levels[pin] = level;
+  if(before == level || !pins.handlers[pin]) return;
+  if(pins.modes[pin] == CHANGE || (pins.modes[pin] == FALLING && level == LOW) ||
+     (pins.modes[pin] == RISING && level == HIGH)) {
+    pins.pending[pin] = true;
+  }
+}
+
+/**
+ * @brief Attach a simulated chip to a pin
+ */
+inline void mockAttachPin(uint8_t pin, MockPinDevice* device) {
+  MockPins& pins = mockPins();
+  pins.devices[pin] = device;
+  pins.levels[pin] = device->read(pin);
+  for(uint8_t i = 0; i < pins.updated_count; i++) {
+    if(pins.updated[i] == device) return;
+  }
+  pins.updated[pins.updated_count++] = device;
+}
+
+/**
+ * @brief Detach all simulated chips and interrupt handlers
+ */
+inline void mockDetachPins() {
+  mockPins() = MockPins();
+}
+
+inline void advanceMicros(unsigned long us) {
+  MockPins& pins = mockPins();
+  if(pins.updated_count == 0 || pins.updating) {
+    mockMicros() += us;
+    return;
+  }
+
+  // Small steps, so chips change their pins about when they would
+  do {
+    unsigned long step = us < kMockPinStepUs ? us : kMockPinStepUs;
+    mockMicros() += step;
+    us -= step;
+    pins.updating = true;
+    for(uint8_t i = 0; i < pins.updated_count; i++) pins.updated[i]->update();
+    pins.updating = false;
+    mockServiceInterrupts();
+  } while(us > 0);
+}
+
+inline unsigned long micros() {
+  return mockMicros();
+}
+
+inline unsigned long millis() {
+  return mockMicros() / 1000;
+}
+
+inline void delayMicroseconds(unsigned int us) {
+  advanceMicros(us);
+}
+
+inline void delay(unsigned long ms) {
+  advanceMicros(ms * 1000);
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+  MockPinDevice* device = mockPins().devices[pin];
+  if(!device) return;
+  device->write(pin, value);
+  advanceMicros(kMockPinAccessUs);
+}
+
+inline int digitalRead(uint8_t pin) {
+  MockPinDevice* device = mockPins().devices[pin];
+  if(!device) return LOW;
+  int level = device->read(pin);
+  advanceMicros(kMockPinAccessUs);
+  return level;
+}
+
+inline uint8_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
+  uint8_t value = 0;
+  for(uint8_t i = 0; i < 8; i++) {
+    digitalWrite(clockPin, HIGH);
+    if(bitOrder == LSBFIRST) value |= digitalRead(dataPin) << i;
+    else value |= digitalRead(dataPin) << (7 - i);
+    digitalWrite(clockPin, LOW);
+  }
+  return value;
+}
+
+inline void noInterrupts() {
+  mockPins().disabled = true;
+}
+
+inline void interrupts() {
+  mockPins().disabled = false;
+  mockServiceInterrupts();
+}
+
+inline int digitalPinToInterrupt(uint8_t pin) {
+  return pin < MockPins::kCount ? pin : -1;
+}
+
+inline void attachInterrupt(int interrupt, void (*handler)(), int mode) {
+  MockPins& pins = mockPins();
+  pins.handlers[interrupt] = handler;
+  pins.modes[interrupt] = mode;
+  pins.pending[interrupt] = false;
+}
+
+inline void detachInterrupt(int interrupt) {
+  MockPins& pins = mockPins();
+  pins.handlers[interrupt] = nullptr;
+  pins.pending[interrupt] = false;
+}
+
+/**
+ * @brief Arduino Stream, writes to stdout
+ */
+class Stream : public Print {
+public:
+  using Print::write;
+  size_t write(uint8_t c) {
+    if(c == '\r') return 1; // Line ends are CR LF on Arduino
+    return putchar(c) == EOF ? 0 : 1;
+  }
+};
+
+extern Stream Serial;
+
+#endif
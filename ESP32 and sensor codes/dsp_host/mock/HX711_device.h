@@ -0,0 +1,115 @@
+// Pin level simulation of an HX711 for the mock Arduino core
+//
+// Conversions complete at the output data rate as mock time advances. DOUT
+// falls when one is ready, each rising PD_SCK edge shifts out the next bit
+// MSB first and the 25th sets DOUT high again until the next conversion. A
+// conversion that is not clocked out before the next one is lost. Conversion
+// n reads as n - 0x400000, so a reader can check for lost or repeated
+// readings and the sign extension is exercised.
+#ifndef MOCK_HX711_DEVICE_H
+#define MOCK_HX711_DEVICE_H
+
+#include "Arduino.h"
+
+class MockHX711 : public MockPinDevice {
+  const uint8_t dout_;
+  const uint8_t sck_;
+  const unsigned long period_us_;
+  unsigned long next_us_;
+  uint32_t conversions_;
+  uint32_t reads_;
+  uint32_t lost_;
+  long value_;
+  bool ready_;
+  bool clock_;
+  uint8_t clocks_;
+  unsigned long ready_us_;
+  unsigned long worst_latency_us_;
+
+  int dataLevel() const {
+    if(!ready_) return HIGH;
+    if(clocks_ == 0) return LOW;
+    return (value_ >> (24 - clocks_)) & 1 ? HIGH : LOW;
+  }
+
+public:
+  /**
+   * @param dout Pin of DOUT
+   * @param sck Pin of PD_SCK
+   * @param rate Output data rate in SPS, 10 or 80
+   */
+  MockHX711(uint8_t dout, uint8_t sck, unsigned long rate) :
+    dout_(dout),
+    sck_(sck),
+    period_us_(1000000 / rate),
+    next_us_(micros() + 1000000 / rate),
+    conversions_(0),
+    reads_(0),
+    lost_(0),
+    value_(0),
+    ready_(false),
+    clock_(false),
+    clocks_(0),
+    ready_us_(0),
+    worst_latency_us_(0) {}
+
+  static long valueOf(uint32_t conversion) {
+    return (long)conversion - 0x400000;
+  }
+
+  // The library sign extends to 32 bits, long is wider on most hosts
+  static uint32_t conversionOf(long value) {
+    return (uint32_t)((int32_t)value + 0x400000);
+  }
+
+  int read(uint8_t pin) {
+    return pin == dout_ ? dataLevel() : (clock_ ? HIGH : LOW);
+  }
+
+  void write(uint8_t pin, uint8_t value) {
+    if(pin != sck_) return;
+    bool rising = value && !clock_;
+    clock_ = value != 0;
+    if(!rising || !ready_) return;
+
+    if(clocks_ == 0) {
+      unsigned long latency = micros() - ready_us_;
+      if(latency > worst_latency_us_) worst_latency_us_ = latency;
+    }
+    clocks_++;
+    if(clocks_ == 25) {
+      ready_ = false;
+      clocks_ = 0;
+      reads_++;
+    }
+    mockPinChanged(dout_, dataLevel());
+  }
+
+  void update() {
+    while((long)(micros() - next_us_) >= 0) {
+      next_us_ += period_us_;
+      conversions_++;
+      if(clocks_ > 0) {
+        // Clocking out the previous one, this conversion never shows up
+        lost_++;
+        continue;
+      }
+      if(ready_) lost_++;
+      value_ = valueOf(conversions_) & 0xFFFFFF;
+      ready_ = true;
+      ready_us_ = micros();
+      mockPinChanged(dout_, dataLevel());
+    }
+  }
+
+  uint32_t conversions() const { return conversions_; }
+  uint32_t reads() const { return reads_; }
+  uint32_t lost() const { return lost_; }
+
+  /**
+   * @brief Longest time from data ready to the first clock
+   */
+  unsigned long worstLatencyUs() const { return worst_latency_us_; }
+};
+
+#endif
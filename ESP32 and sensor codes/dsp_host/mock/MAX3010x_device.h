@@ -0,0 +1,231 @@
+// Register level simulation of a MAX30102/MAX30105 on the mock TwoWire
+//
+// Samples are produced at the configured sampling rate as mock time advances.
+// Every slot value encodes the running sample number, so a reader can check
+// for lost or repeated samples: slot s of sample n is (n * 4 + s) & 0x3FFFF.
+// With setTissue() the slots instead follow the LED currents and ADC range of
+// slot s like a finger with a 1.2 Hz pulse would.
+#ifndef MOCK_MAX3010X_DEVICE_H
+#define MOCK_MAX3010X_DEVICE_H
+
+#include "Wire.h"
+
+#include <math.h>
+
+class MockMAX3010x : public MockI2CDevice {
+  static const uint8_t kIntStatus1 = 0x00;
+  static const uint8_t kIntStatus2 = 0x01;
+  static const uint8_t kFifoWritePointer = 0x04;
+  static const uint8_t kFifoOverflow = 0x05;
+  static const uint8_t kFifoReadPointer = 0x06;
+  static const uint8_t kFifoData = 0x07;
+  static const uint8_t kFifoConfig = 0x08;
+  static const uint8_t kModeConfig = 0x09;
+  static const uint8_t kSpO2Config = 0x0A;
+  static const uint8_t kLedConfig = 0x0C;
+  static const uint8_t kMultiLedConfig = 0x11;
+  static const uint8_t kTempConfig = 0x21;
+  static const uint8_t kPartId = 0xFF;
+  static const uint8_t kFifoSize = 32;
+  static const uint8_t kSampleSize = 3;
+
+  uint8_t registers_[256];
+  uint8_t pointer_;
+  uint8_t byte_index_;
+  uint8_t count_;
+  uint8_t fifo_[kFifoSize][kSampleSize * 4];
+  uint32_t produced_;
+  float tissue_[2];
+  unsigned long last_us_;
+  unsigned long pending_us_;
+
+  uint8_t activeSlots() const {
+    uint8_t mode = registers_[kModeConfig] & 0x7;
+    if(mode == 0x2) return 1;
+    if(mode == 0x3) return 2;
+    if(mode != 0x7) return 0;
+
+    uint8_t slots = 0;
+    for(int i = 0; i < 4; i++) {
+      uint8_t slot = (registers_[kMultiLedConfig + i / 2] >> (4 * (i % 2))) & 0x7;
+      if(slot != 0 && slot != 4) slots++;
+    }
+    return slots;
+  }
+
+  unsigned long samplePeriodUs() const {
+    static const unsigned long kRates[] = { 50, 100, 200, 400, 800, 1000, 1600, 3200 };
+    unsigned long rate = kRates[(registers_[kSpO2Config] >> 2) & 0x7];
+    uint8_t averaging = (registers_[kFifoConfig] >> 5) & 0x7;
+    if(averaging > 5) averaging = 5;
+    return (1000000UL << averaging) / rate;
+  }
+
+  void pushSample() {
+    uint8_t slots = activeSlots();
+    if(count_ == kFifoSize) {
+      if(registers_[kFifoOverflow] < 0x1F) registers_[kFifoOverflow]++;
+      if(!(registers_[kFifoConfig] & 0x10)) {
+        // Rollover disabled, the new sample is lost
+        produced_++;
+        return;
+      }
+      // Rollover overwrites the oldest sample
+      registers_[kFifoReadPointer] = (registers_[kFifoReadPointer] + 1) % kFifoSize;
+      count_--;
+    }
+
+    uint8_t* data = fifo_[registers_[kFifoWritePointer]];
+    for(uint8_t s = 0; s < slots; s++) {
+      uint32_t value = (produced_ * 4 + s) & 0x3FFFF;
+      if(tissue_[0] > 0 && s < 2) value = opticalValue(s);
+      data[s * kSampleSize + 0] = (uint8_t)(value >> 16);
+      data[s * kSampleSize + 1] = (uint8_t)(value >> 8);
+      data[s * kSampleSize + 2] = (uint8_t)value;
+    }
+    produced_++;
+    registers_[kFifoWritePointer] = (registers_[kFifoWritePointer] + 1) % kFifoSize;
+    count_++;
+
+    registers_[kIntStatus1] |= 0x40; // PPG_RDY
+    uint8_t threshold = registers_[kFifoConfig] & 0xF;
+    if(kFifoSize - count_ <= threshold) registers_[kIntStatus1] |= 0x80; // A_FULL
+  }
+
+  uint32_t opticalValue(uint8_t slot) const {
+    static const float kRangeNa[] = { 2048, 4096, 8192, 16384 };
+    float current_ma = registers_[kLedConfig + slot] * 0.2f;
+    float range = kRangeNa[(registers_[kSpO2Config] >> 5) & 0x3];
+    float t = produced_ * (samplePeriodUs() / 1e6f);
+    float value = tissue_[slot] * current_ma * (16384 / range) * (1 + 0.01f * sinf(2 * 3.14159265f * 1.2f * t));
+    return value >= 0x3FFFF ? 0x3FFFF : (uint32_t)value;
+  }
+
+  void update() {
+    unsigned long now = micros();
+    unsigned long elapsed = now - last_us_;
+    last_us_ = now;
+    if(activeSlots() == 0 || (registers_[kModeConfig] & 0x80)) {
+      pending_us_ = 0;
+      return;
+    }
+
+    unsigned long period = samplePeriodUs();
+    pending_us_ += elapsed;
+    while(pending_us_ >= period) {
+      pending_us_ -= period;
+      pushSample();
+    }
+  }
+
+  void syncCount() {
+    count_ = (kFifoSize + registers_[kFifoWritePointer] - registers_[kFifoReadPointer]) % kFifoSize;
+    byte_index_ = 0;
+  }
+
+  void writeRegister(uint8_t reg, uint8_t value) {
+    if(reg == kModeConfig && (value & 0x40)) {
+      // The rest of the transaction continues at the next register
+      uint8_t pointer = pointer_;
+      reset();
+      pointer_ = pointer;
+      return;
+    }
+    registers_[reg] = value;
+
+    if(reg == kFifoWritePointer || reg == kFifoReadPointer) {
+      registers_[reg] &= kFifoSize - 1;
+      syncCount();
+    }
+    else if(reg == kTempConfig && (value & 0x01)) {
+      registers_[kTempConfig] = 0;
+      registers_[0x1F] = 30;
+      registers_[kIntStatus2] |= 0x02;
+    }
+  }
+public:
+  MockMAX3010x() {
+    tissue_[0] = 0;
+    tissue_[1] = 0;
+    reset();
+  }
+
+  /**
+   * @brief Simulate a finger on the sensor
+   * @param red Red counts per mA of LED current in the 16384 nA range
+   * @param ir IR counts per mA of LED current in the 16384 nA range
+   */
+  void setTissue(float red, float ir) {
+    tissue_[0] = red;
+    tissue_[1] = ir;
+  }
+
+  /**
+   * @brief Power on state
+   */
+  void reset() {
+    memset(registers_, 0, sizeof(registers_));
+    memset(fifo_, 0, sizeof(fifo_));
+    registers_[kPartId] = 0x15;
+    registers_[kIntStatus1] = 0x01; // PWR_RDY, latched until the status is read
+    pointer_ = 0;
+    byte_index_ = 0;
+    count_ = 0;
+    produced_ = 0;
+    last_us_ = micros();
+    pending_us_ = 0;
+  }
+
+  /**
+   * @brief Number of samples produced since the last reset
+   */
+  uint32_t produced() const {
+    return produced_;
+  }
+
+  /**
+   * @brief Interrupt pin level, active low like the open drain output
+   * @remark PWR_RDY cannot be masked
+   */
+  bool interruptPin() {
+    update();
+    uint8_t enabled1 = registers_[0x02] | 0x01;
+    uint8_t enabled2 = registers_[0x03];
+    return !((registers_[kIntStatus1] & enabled1) || (registers_[kIntStatus2] & enabled2));
+  }
+
+  void receive(const uint8_t* data, size_t length) override {
+    update();
+    if(length == 0) return;
+    pointer_ = data[0];
+    byte_index_ = 0;
+    for(size_t i = 1; i < length; i++) {
+      writeRegister(pointer_, data[i]);
+      if(pointer_ != kFifoData) pointer_++;
+    }
+  }
+
+  uint8_t transmit() override {
+    if(pointer_ == kFifoData) {
+      uint8_t sample_bytes = kSampleSize * activeSlots();
+      if(count_ == 0 || sample_bytes == 0) return 0;
+      registers_[kIntStatus1] &= ~0x80; // Reading FIFO data clears A_FULL
+      uint8_t value = fifo_[registers_[kFifoReadPointer]][byte_index_++];
+      if(byte_index_ >= sample_bytes) {
+        byte_index_ = 0;
+        registers_[kFifoReadPointer] = (registers_[kFifoReadPointer] + 1) % kFifoSize;
+        registers_[kFifoOverflow] = 0; // Cleared whenever a sample is popped
+        count_--;
+      }
+      return value;
+    }
+
+    uint8_t value = registers_[pointer_];
+    // Reading a status register clears it
+    if(pointer_ == kIntStatus1 || pointer_ == kIntStatus2) registers_[pointer_] = 0;
+    pointer_++;
+    return value;
+  }
+};
+
+#endif
@@ -0,0 +1,123 @@
+// SMBus level simulation of an MLX90614 on the mock TwoWire
+//
+// The RAM registers TA and TOBJ1 are refreshed once per measurement, whose
+// length follows the FIR setting of the configuration register like the
+// datasheet table. Every refresh n reads as a raw value that encodes n, so a
+// reader can tell new and repeated words apart: TOBJ1 is 0x3C00 + n and
+// TA 0x3900 + n, both modulo 0x100. Each read word is sent with its PEC,
+// setBitErrorRate() corrupts data bytes on the wire after the PEC was
+// computed.
+#ifndef MOCK_MLX90614_DEVICE_H
+#define MOCK_MLX90614_DEVICE_H
+
+#include "Wire.h"
+
+class MockMLX90614 : public MockI2CDevice {
+  static const uint8_t kTa = 0x06;
+  static const uint8_t kTobj1 = 0x07;
+  static const uint8_t kConfig = 0x25;
+
+  const uint8_t address_;
+  uint16_t config_;
+  uint8_t command_;
+  uint8_t frame_[3];
+  uint8_t byte_index_;
+  unsigned long next_us_;
+  uint32_t refreshes_;
+  uint32_t error_threshold_;
+  uint32_t random_;
+  uint32_t corrupted_;
+
+  static uint8_t crc8(const uint8_t* data, size_t length) {
+    uint8_t crc = 0;
+    for(size_t i = 0; i < length; i++) {
+      crc ^= data[i];
+      for(int bit = 0; bit < 8; bit++) crc = crc & 0x80 ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+  }
+
+  uint32_t nextRandom() {
+    random_ = random_ * 1664525u + 1013904223u;
+    return random_;
+  }
+
+  void update() {
+    while((long)(micros() - next_us_) >= 0) {
+      next_us_ += periodUs();
+      refreshes_++;
+    }
+  }
+
+  uint16_t word(uint8_t command) const {
+    if(command == kTobj1) return 0x3C00 + (refreshes_ & 0xFF);
+    if(command == kTa) return 0x3900 + (refreshes_ & 0xFF);
+    if(command == kConfig) return config_;
+    return 0;
+  }
+
+public:
+  explicit MockMLX90614(uint8_t address = 0x5A) :
+    address_(address),
+    config_(0x9FB4), // Factory default, FIR 1024 and IIR 100%
+    command_(0),
+    byte_index_(0),
+    next_us_(0),
+    refreshes_(0),
+    error_threshold_(0),
+    random_(1),
+    corrupted_(0) {
+    next_us_ = micros() + periodUs();
+  }
+
+  /**
+   * @brief Time between two refreshes of the RAM registers
+   */
+  unsigned long periodUs() const {
+    // About 100 ms at FIR 1024, proportional to the FIR length
+    unsigned long fir = 8UL << ((config_ >> 8) & 0x7);
+    unsigned long period = 100000UL * fir / 1024;
+    return period < 10000 ? 10000 : period;
+  }
+
+  /**
+   * @brief Probability that a data byte of a read word has a flipped bit
+   */
+  void setBitErrorRate(double rate) {
+    error_threshold_ = (uint32_t)(rate * 4294967295.0);
+  }
+
+  void receive(const uint8_t* data, size_t length) {
+    if(length == 0) return;
+    update();
+    command_ = data[0];
+    byte_index_ = 0;
+
+    uint16_t value = word(command_);
+    uint8_t pec[5] = { (uint8_t)(address_ << 1), command_, (uint8_t)((address_ << 1) | 1),
+                       (uint8_t)value, (uint8_t)(value >> 8) };
+    frame_[0] = pec[3];
+    frame_[1] = pec[4];
+    frame_[2] = crc8(pec, 5);
+    for(int i = 0; i < 2; i++) {
+      if(nextRandom() < error_threshold_) {
+        frame_[i] ^= (uint8_t)(1 << (nextRandom() >> 29));
+        corrupted_++;
+      }
+    }
+  }
+
+  uint8_t transmit() {
+    return byte_index_ < 3 ? frame_[byte_index_++] : 0xFF;
+  }
+
+  uint32_t refreshes() const { return refreshes_; }
+  uint32_t corrupted() const { return corrupted_; }
+
+  /**
+   * @brief TOBJ1 word of the last refresh, without corruption on the wire
+   */
+  uint16_t objectWord() const { return word(kTobj1); }
+};
+
+#endif
@@ -0,0 +1,49 @@
+// Arduino Print on the host, everything ends up in write(uint8_t)
+#ifndef MOCK_PRINT_H
+#define MOCK_PRINT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+
+class Print {
+  size_t format(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char text[32];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    return print(text);
+  }
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+
+  virtual size_t write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while(written < length && write(data[written])) written++;
+    return written;
+  }
+
+  size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+
+  size_t print(const char* text) { return write(text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC) { return base == HEX ? format("%lX", value) : format("%ld", value); }
+  size_t print(unsigned long value, int base = DEC) { return base == HEX ? format("%lX", value) : format("%lu", value); }
+  size_t print(double value, int digits = 2) { return format("%.*f", digits, value); }
+
+  size_t println() { return print("\r\n"); }
+  template<typename T> size_t println(T value) { return print(value) + println(); }
+  template<typename T> size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+#endif
@@ -0,0 +1,32 @@
+// Host SPIClass so that libraries with optional SPI support compile, no devices
+#ifndef MOCK_SPI_H
+#define MOCK_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+class SPISettings {
+public:
+  SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0) {
+    (void)clock;
+    (void)bitOrder;
+    (void)dataMode;
+  }
+};
+
+class SPIClass {
+public:
+  void begin() {}
+  void beginTransaction(SPISettings settings) { (void)settings; }
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data) { (void)data; return 0xFF; }
+  void transfer(void* buffer, size_t length) { memset(buffer, 0xFF, length); }
+};
+
+extern SPIClass SPI;
+
+#endif
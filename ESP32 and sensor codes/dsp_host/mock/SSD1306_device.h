@@ -0,0 +1,96 @@
+// Simulated SSD1306 on the mock TwoWire, keeps the GDDRAM to check what a driver sent
+//
+// Supports the horizontal addressing mode the Adafruit driver sets up: data
+// bytes go to the column and page pointers, which wrap inside the window of
+// the last PAGEADDR and COLUMNADDR commands.
+#ifndef MOCK_SSD1306_DEVICE_H
+#define MOCK_SSD1306_DEVICE_H
+
+#include "Wire.h"
+
+class MockSSD1306 : public MockI2CDevice {
+  uint8_t width_;
+  uint8_t pages_;
+  uint8_t ram_[128 * 8];
+  uint8_t command_[7];
+  uint8_t command_length_;
+  uint8_t page_start_, page_end_, column_start_, column_end_;
+  uint8_t page_, column_;
+  unsigned long data_bytes_;
+
+  // Argument bytes following a command byte
+  static uint8_t argumentCount(uint8_t command) {
+    switch(command) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+      return 1;
+    case 0x21: case 0x22: case 0xA3:
+      return 2;
+    case 0x29: case 0x2A:
+      return 5;
+    case 0x26: case 0x27:
+      return 6;
+    default:
+      return 0;
+    }
+  }
+
+  void command(uint8_t c) {
+    command_[command_length_++] = c;
+    if(command_length_ <= argumentCount(command_[0])) return;
+    command_length_ = 0;
+    if(command_[0] == 0x21) {
+      column_start_ = column_ = command_[1] < width_ ? command_[1] : width_ - 1;
+      column_end_ = command_[2] < width_ ? command_[2] : width_ - 1;
+    } else if(command_[0] == 0x22) {
+      page_start_ = page_ = command_[1] < pages_ ? command_[1] : pages_ - 1;
+      page_end_ = command_[2] < pages_ ? command_[2] : pages_ - 1;
+    }
+  }
+
+  void data(uint8_t d) {
+    ram_[page_ * width_ + column_] = d;
+    data_bytes_++;
+    if(column_ < column_end_) {
+      column_++;
+      return;
+    }
+    column_ = column_start_;
+    page_ = page_ < page_end_ ? page_ + 1 : page_start_;
+  }
+public:
+  MockSSD1306(uint8_t width, uint8_t height) :
+    width_(width),
+    pages_((height + 7) / 8),
+    command_length_(0),
+    page_start_(0), page_end_(pages_ - 1), column_start_(0), column_end_(width - 1),
+    page_(0), column_(0),
+    data_bytes_(0) {
+    // Power up contents are undefined
+    for(size_t i = 0; i < sizeof(ram_); i++) ram_[i] = (uint8_t)(i * 37 + 11);
+  }
+
+  /**
+   * @brief Display RAM, page * width + column
+   */
+  const uint8_t* ram() const { return ram_; }
+
+  /**
+   * @brief Data bytes written so far
+   */
+  unsigned long dataBytes() const { return data_bytes_; }
+
+  void receive(const uint8_t* bytes, size_t length) {
+    // Control byte: D/C# in bit 6, continuation in bit 7 is not used by the driver
+    if(length == 0) return;
+    bool is_data = bytes[0] & 0x40;
+    for(size_t i = 1; i < length; i++) {
+      if(is_data) data(bytes[i]);
+      else command(bytes[i]);
+    }
+  }
+
+  uint8_t transmit() { return 0xFF; }
+};
+
+#endif
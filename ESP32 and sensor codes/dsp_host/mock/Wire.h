@@ -0,0 +1,146 @@
+// Host TwoWire that routes transactions to simulated devices and counts them
+#ifndef MOCK_WIRE_H
+#define MOCK_WIRE_H
+
+#include "Arduino.h"
+
+#ifndef I2C_BUFFER_LENGTH
+#define I2C_BUFFER_LENGTH 128
+#endif
+
+/**
+ * @brief Simulated I2C target
+ */
+class MockI2CDevice {
+public:
+  virtual ~MockI2CDevice() {}
+
+  /**
+   * @brief Bytes written by the controller in one transaction
+   */
+  virtual void receive(const uint8_t* data, size_t length) = 0;
+
+  /**
+   * @brief Next byte for a controller read
+   */
+  virtual uint8_t transmit() = 0;
+};
+
+/**
+ * @brief Bus statistics
+ */
+struct MockI2CStats {
+  unsigned long transactions; // START conditions, writes and reads
+  unsigned long writes;
+  unsigned long reads;
+  unsigned long bytes;        // Including address bytes
+
+  /**
+   * @brief Time on the bus, 9 clocks per byte plus START and STOP
+   */
+  double busMicros(uint32_t clock) const {
+    return (bytes * 9.0 + transactions * 2.0) * 1e6 / clock;
+  }
+};
+
+class TwoWire {
+  MockI2CDevice* devices_[128];
+  uint8_t address_;
+  uint8_t tx_[I2C_BUFFER_LENGTH];
+  size_t tx_length_;
+  uint8_t rx_[I2C_BUFFER_LENGTH];
+  size_t rx_length_;
+  size_t rx_index_;
+  uint32_t clock_;
+  MockI2CStats stats_;
+public:
+  TwoWire() :
+    address_(0),
+    tx_length_(0),
+    rx_length_(0),
+    rx_index_(0),
+    clock_(100000) {
+    memset(devices_, 0, sizeof(devices_));
+    resetStats();
+  }
+
+  void attach(uint8_t address, MockI2CDevice* device) {
+    devices_[address & 0x7F] = device;
+  }
+
+  const MockI2CStats& stats() const {
+    return stats_;
+  }
+
+  void resetStats() {
+    memset(&stats_, 0, sizeof(stats_));
+  }
+
+  bool begin() { return true; }
+  void end() {}
+  void setClock(uint32_t clock) { clock_ = clock; }
+  uint32_t getClock() { return clock_; }
+
+  void beginTransmission(uint8_t address) {
+    address_ = address & 0x7F;
+    tx_length_ = 0;
+  }
+
+  void beginTransmission(int address) {
+    beginTransmission((uint8_t)address);
+  }
+
+  size_t write(uint8_t data) {
+    if(tx_length_ >= sizeof(tx_)) return 0;
+    tx_[tx_length_++] = data;
+    return 1;
+  }
+
+  size_t write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while(written < length && write(data[written])) written++;
+    return written;
+  }
+
+  uint8_t endTransmission(bool sendStop = true) {
+    (void)sendStop;
+    stats_.transactions++;
+    stats_.writes++;
+    stats_.bytes += 1 + tx_length_;
+    MockI2CDevice* device = devices_[address_];
+    if(!device) return 2; // NACK on address
+    device->receive(tx_, tx_length_);
+    return 0;
+  }
+
+  size_t requestFrom(uint8_t address, size_t quantity, bool sendStop = true) {
+    (void)sendStop;
+    stats_.transactions++;
+    stats_.reads++;
+    stats_.bytes += 1;
+    rx_length_ = 0;
+    rx_index_ = 0;
+    MockI2CDevice* device = devices_[address & 0x7F];
+    if(!device) return 0;
+    if(quantity > sizeof(rx_)) quantity = sizeof(rx_);
+    for(size_t i = 0; i < quantity; i++) {
+      rx_[i] = device->transmit();
+    }
+    rx_length_ = quantity;
+    stats_.bytes += quantity;
+    return quantity;
+  }
+
+  int available() {
+    return (int)(rx_length_ - rx_index_);
+  }
+
+  int read() {
+    if(rx_index_ >= rx_length_) return -1;
+    return rx_[rx_index_++];
+  }
+};
+
+extern TwoWire Wire;
+
+#endif
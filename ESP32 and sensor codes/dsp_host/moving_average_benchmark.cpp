@@ -0,0 +1,101 @@
+// Cost per sample of MovingAverageFilter across window sizes
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -o moving_average_benchmark dsp_host/moving_average_benchmark.cpp
+//   ./moving_average_benchmark
+//
+// Compares the running sum filter with the previous implementation that re-summed
+// the whole buffer on every sample, and reports the largest deviation of the float
+// running sum from an exact average.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Arduino definitions used by filters.h
+using std::isnan;
+using std::max;
+using std::min;
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#include "../FinalIntegration/filters.h"
+
+// Previous MovingAverageFilter, O(window) per sample
+template<int kBufferSize> class ResummingMovingAverageFilter {
+  int index_;
+  int count_;
+  float values_[kBufferSize];
+public:
+  ResummingMovingAverageFilter() :
+    index_(0),
+    count_(0){}
+
+  float process(float value) {
+    values_[index_] = value;
+    index_ = (index_ + 1) % kBufferSize;
+    if(count_ < kBufferSize) {
+      count_++;
+    }
+    float sum = 0.0;
+    for(int i = 0; i < count_; i++) {
+      sum += values_[i];
+    }
+    return sum / count_;
+  }
+};
+
+static const size_t kSamples = 1 << 18;
+
+template<typename Filter, typename T> static double nanosecondsPerSample(const std::vector<T>& input, float& checksum) {
+  Filter* filter = new Filter();
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < input.size(); i++) {
+    checksum += filter->process(input[i]);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  delete filter;
+  return seconds * 1e9 / input.size();
+}
+
+template<int kWindow> static void benchmark(const std::vector<float>& input, const std::vector<int16_t>& input_int) {
+  float checksum = 0;
+  double resumming = nanosecondsPerSample<ResummingMovingAverageFilter<kWindow> >(input, checksum);
+  double running = nanosecondsPerSample<MovingAverageFilter<kWindow> >(input, checksum);
+  double running_int = nanosecondsPerSample<MovingAverageFilter<kWindow, int16_t> >(input_int, checksum);
+
+  // Drift of the float running sum against an exact average
+  MovingAverageFilter<kWindow>* filter = new MovingAverageFilter<kWindow>();
+  double sum = 0;
+  double error = 0;
+  for(size_t i = 0; i < input.size(); i++) {
+    sum += input[i];
+    if(i >= (size_t)kWindow) sum -= input[i - kWindow];
+    double exact = sum / std::min(i + 1, (size_t)kWindow);
+    error = std::max(error, std::fabs(filter->process(input[i]) - exact));
+  }
+  delete filter;
+
+  printf("%6d  %10.1f  %10.1f  %10.1f  %10.2e  (%g)\n", kWindow, resumming, running, running_int, error, checksum);
+}
+
+int main() {
+  // ECG-like input: 10 bit samples with baseline wander
+  std::vector<float> input(kSamples);
+  std::vector<int16_t> input_int(kSamples);
+  unsigned int seed = 1;
+  for(size_t i = 0; i < kSamples; i++) {
+    seed = seed * 1103515245 + 12345;
+    input_int[i] = (int16_t)(512 + 200 * sin(i * 0.001) + (seed >> 16) % 64);
+    input[i] = input_int[i];
+  }
+
+  printf("window  resum ns    float ns    int16 ns    float drift\n");
+  benchmark<5>(input, input_int);
+  benchmark<50>(input, input_int);
+  benchmark<500>(input, input_int);
+  benchmark<5000>(input, input_int);
+  return 0;
+}
@@ -0,0 +1,171 @@
+// Scheduler state hooks and PeriodicTask timing against a fake clock
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -o scheduler_test dsp_host/scheduler_test.cpp
+//   ./scheduler_test
+//
+// Steps the scheduler of FinalIntegration by hand. Checks the order of the
+// enter/tick/exit hooks and that a transition is applied at the end of the
+// tick that requested it, and the catch-up rule of PeriodicTask: a late run
+// keeps the phase unless it fell behind by a whole period. Exits with 1 on
+// the first failed check.
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "../FinalIntegration/scheduler.h"
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if(!(condition)) {                                                    \
+      printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition);        \
+      exit(1);                                                            \
+    }                                                                     \
+  } while(0)
+
+static unsigned long fakeNow = 0;
+static unsigned long fakeClock() { return fakeNow; }
+
+static std::string events;
+static int transitionTo = -1;
+
+enum TestState { STATE_A, STATE_B, STATE_COUNT };
+
+static Scheduler<4>* scheduler = nullptr;
+
+static void log(const char* event) {
+  if(!events.empty()) events += " ";
+  events += event;
+}
+
+static void enterA() { log("A.enter"); }
+static void tickA() {
+  log("A.tick");
+  if(transitionTo >= 0) scheduler->transition(transitionTo);
+  transitionTo = -1;
+}
+static void exitA() { log("A.exit"); }
+static void enterB() { log("B.enter"); }
+static void tickB() { log("B.tick"); }
+
+static const StateHooks kStates[STATE_COUNT] = {
+  { enterA, tickA, exitA },
+  { enterB, tickB, nullptr }
+};
+
+static int taskRuns = 0;
+static void countRun() { taskRuns++; }
+static void logTask() { log("task"); }
+
+static void testStateHooks() {
+  fakeNow = 1000;
+  Scheduler<4> machine(fakeClock, kStates, STATE_COUNT);
+  scheduler = &machine;
+  PeriodicTask task(logTask, 0);
+  machine.addTask(task);
+  task.start(fakeNow);
+
+  events.clear();
+  machine.begin(STATE_A);
+  CHECK(events == "A.enter");
+  CHECK(machine.state() == STATE_A);
+
+  // Tasks run before the state tick
+  events.clear();
+  fakeNow = 1010;
+  machine.tick();
+  CHECK(events == "task A.tick");
+  CHECK(machine.elapsed() == 10);
+
+  // The transition is applied at the end of the requesting tick
+  events.clear();
+  fakeNow = 1020;
+  transitionTo = STATE_B;
+  machine.tick();
+  CHECK(events == "task A.tick A.exit B.enter");
+  CHECK(machine.state() == STATE_B);
+  CHECK(machine.elapsed() == 0);
+
+  // A state without an exit hook, transitions requested between ticks wait for the next one
+  events.clear();
+  fakeNow = 1030;
+  machine.transition(STATE_A);
+  CHECK(events.empty());
+  machine.tick();
+  CHECK(events == "task B.tick A.enter");
+
+  // Out of range states are ignored
+  events.clear();
+  fakeNow = 1040;
+  machine.transition(STATE_COUNT);
+  machine.tick();
+  CHECK(events == "task A.tick");
+  CHECK(machine.state() == STATE_A);
+  scheduler = nullptr;
+}
+
+// Poll at the given time, return whether the task ran
+static bool pollAt(PeriodicTask& task, unsigned long now) {
+  int before = taskRuns;
+  bool ran = task.poll(now);
+  CHECK(ran == (taskRuns == before + 1));
+  return ran;
+}
+
+static void testCatchUp(unsigned long origin) {
+  PeriodicTask task(countRun, 10);
+  CHECK(!pollAt(task, origin));
+
+  // The first run happens on the first tick after start()
+  task.start(origin);
+  CHECK(pollAt(task, origin));
+  CHECK(!pollAt(task, origin + 9));
+  CHECK(pollAt(task, origin + 10));
+
+  // 5 ms late, the next run stays on the 10 ms grid
+  CHECK(pollAt(task, origin + 25));
+  CHECK(!pollAt(task, origin + 29));
+  CHECK(pollAt(task, origin + 30));
+
+  // A run missed for less than two periods is made up right away, once
+  CHECK(pollAt(task, origin + 49));
+  CHECK(!pollAt(task, origin + 49));
+  CHECK(pollAt(task, origin + 50));
+
+  // Behind by more than a period, the grid restarts at the late run
+  CHECK(pollAt(task, origin + 75));
+  CHECK(!pollAt(task, origin + 80));
+  CHECK(!pollAt(task, origin + 84));
+  CHECK(pollAt(task, origin + 85));
+
+  task.stop();
+  CHECK(!task.running());
+  CHECK(!pollAt(task, origin + 200));
+
+  // A new period applies from the last run on
+  task.start(origin + 200);
+  task.setPeriod(20);
+  CHECK(!pollAt(task, origin + 200));
+  CHECK(pollAt(task, origin + 210));
+  CHECK(!pollAt(task, origin + 229));
+  CHECK(pollAt(task, origin + 230));
+}
+
+static void testEveryTick() {
+  PeriodicTask task(countRun, 0);
+  task.start(5);
+  CHECK(pollAt(task, 5));
+  CHECK(pollAt(task, 5));
+  CHECK(pollAt(task, 6));
+}
+
+int main() {
+  testStateHooks();
+  testCatchUp(0);
+  // millis() wraps after 49.7 days
+  testCatchUp(ULONG_MAX - 30);
+  testEveryTick();
+  printf("scheduler: all checks passed\n");
+  return 0;
+}
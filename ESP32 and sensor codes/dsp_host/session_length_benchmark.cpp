@@ -0,0 +1,226 @@
+// Length of a FinalIntegration session from WEIGHT to the end of ECG
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -o session_length_benchmark dsp_host/session_length_benchmark.cpp
+//   ./session_length_benchmark
+//
+// Runs the state sequence of the sketch (WEIGHT, result hold, SPO2, TEMP,
+// result hold, ECG) on the Scheduler with a fake clock and 10 ms ticks. The
+// weight goes through the 3 sample median and SettlingDetector at 10 SPS, the
+// temperature through the 5 sample median and ExponentialApproachEstimator at
+// 10 Hz, with the same load cell and thermometer traces as
+// weight_settling_benchmark and temperature_prediction_benchmark. SpO2 is not
+// simulated sample by sample: the first beat is counted 2 s after the finger
+// is on (finger cooldown, gain control and filter settling) and the state ends
+// on the fifth averaged beat. ECG always takes its 30 s window. The original
+// sketch took about 91 s for the same sequence with its fixed windows and
+// "Next in 2 sec" pauses.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Arduino definitions used by filters.h
+using std::isnan;
+using std::max;
+using std::min;
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#include "../FinalIntegration/filters.h"
+#include "../FinalIntegration/scheduler.h"
+
+static const double kOriginalSessionS = 91.0;
+static const unsigned long kTickMs = 10;
+
+// Same as FinalIntegration
+static const unsigned long kResultHoldMs = 1000;
+static const unsigned long kWeightTimeoutMs = 6000;
+static const unsigned long kSpO2WindowMs = 15000;
+static const unsigned long kTempWindowMs = 10000;
+static const unsigned long kEcgWindowMs = 30000;
+static const int kWeightStableSamples = 10;
+static const float kWeightToleranceG = 2.0;
+static const float kWeightDriftG = 1.0;
+static const float kWeightMinimumG = 10.0;
+static const float kTempToleranceC = 0.15;
+static const float kTempMinimumC = 30.0;
+static const int kTempFitSamples = 64;
+static const int kSampleThreshold = 5;
+
+static const double kFingerToFirstBeatS = 2.0;
+static const double kAmbientC = 24.0;
+
+struct Session {
+  const char* name;
+  double weight;       // Load in g, 0 for an empty scale
+  double weightPlaced; // Time the load is put on after WEIGHT starts in s
+  double creep;        // Slow increase of the reading as share of the load
+  double sway;         // Amplitude in g of a load that keeps moving
+  double fingerOn;     // Time the finger is on after SPO2 starts in s, negative if never
+  double bpm;          // Heart rate
+  double skinC;        // Final thermometer reading, 0 if nobody looks at it
+  double tempPlaced;   // Time the forehead comes into view after TEMP starts in s
+  double tau;          // Time constant of the thermometer approach in s
+};
+
+static const Session kSessions[] = {
+  { "typical", 500, 0.3, 0, 0, 0.5, 72, 36.6, 0.5, 1.0 },
+  { "quick", 500, 0.3, 0, 0, 0.3, 90, 36.6, 0.3, 0.5 },
+  { "slow", 2000, 1.0, 0.004, 0, 1.5, 55, 36.6, 1.0, 2.0 },
+  { "all timeouts", 500, 0.3, 0, 8, -1, 72, 0, 0, 1.0 }
+};
+
+enum SessionState { WEIGHT, RESULT, SPO2, TEMP, ECG, DONE, STATE_COUNT };
+
+static unsigned long fakeNow = 0;
+static unsigned long fakeClock() { return fakeNow; }
+
+static const Session* session = nullptr;
+static uint32_t noiseState = 1;
+static SessionState resultNextState = DONE;
+static unsigned long stateMs[STATE_COUNT];
+
+// Deterministic Gaussian noise
+static double noise() {
+  double u[2];
+  for(int i = 0; i < 2; i++) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    u[i] = ((noiseState >> 8) + 1.0) / 16777217.0;
+  }
+  return sqrt(-2.0 * log(u[0])) * cos(2 * PI * u[1]);
+}
+
+static void enterWeight();
+static void tickWeight();
+static void tickResult();
+static void enterSPO2();
+static void tickSPO2();
+static void enterTemperature();
+static void tickTemperature();
+static void tickECG();
+
+static const StateHooks kStates[STATE_COUNT] = {
+  { enterWeight, tickWeight, nullptr },
+  { nullptr, tickResult, nullptr },
+  { enterSPO2, tickSPO2, nullptr },
+  { enterTemperature, tickTemperature, nullptr },
+  { nullptr, tickECG, nullptr },
+  { nullptr, nullptr, nullptr }
+};
+
+static Scheduler<2> scheduler(fakeClock, kStates, STATE_COUNT);
+
+static void holdResult(SessionState next) {
+  resultNextState = next;
+  scheduler.transition(RESULT);
+}
+
+static void tickResult() {
+  if(scheduler.elapsed() >= kResultHoldMs) scheduler.transition(resultNextState);
+}
+
+// Weight, one HX711 conversion every 100 ms
+static SettlingDetector<kWeightStableSamples> weightSettling(kWeightToleranceG, kWeightDriftG, kWeightMinimumG);
+static SlidingMedianFilter<3> weightDespike;
+
+static void sampleWeight() {
+  double t = scheduler.elapsed() / 1000.0;
+  double value = 0.5 * noise();
+  if(session->weight > 0 && t >= session->weightPlaced) {
+    double since = t - session->weightPlaced;
+    value += session->weight * (1 - exp(-since / 0.25) * cos(2 * PI * 4 * since));
+    value += session->weight * session->creep * (1 - exp(-since / 2.0));
+    value += session->sway * sin(2 * PI * 0.7 * t);
+  }
+  weightSettling.process(weightDespike.process((float)value));
+}
+
+static PeriodicTask weightTask(sampleWeight, 100);
+
+static void enterWeight() {
+  weightSettling.reset();
+  weightDespike.reset();
+  weightTask.start(scheduler.now());
+}
+
+static void tickWeight() {
+  if(!weightSettling.settled() && scheduler.elapsed() < kWeightTimeoutMs) return;
+  weightTask.stop();
+  stateMs[WEIGHT] = scheduler.elapsed();
+  holdResult(SPO2);
+}
+
+// SpO2, ends on the fifth averaged beat
+static void enterSPO2() {}
+
+static void tickSPO2() {
+  unsigned long done = kSpO2WindowMs;
+  if(session->fingerOn >= 0) {
+    double firstBeat = session->fingerOn + kFingerToFirstBeatS;
+    done = std::min(done, (unsigned long)((firstBeat + kSampleThreshold * 60.0 / session->bpm) * 1000));
+  }
+  if(scheduler.elapsed() < done) return;
+  stateMs[SPO2] = scheduler.elapsed();
+  scheduler.transition(TEMP);
+}
+
+// Temperature, one MLX90614 reading every 100 ms
+static ExponentialApproachEstimator<kTempFitSamples> tempPrediction(kTempToleranceC, kTempMinimumC);
+static SlidingMedianFilter<5> tempDespike;
+
+static void sampleTemperature() {
+  double t = scheduler.elapsed() / 1000.0;
+  double value = kAmbientC + 0.03 * noise();
+  if(session->skinC > 0 && t >= session->tempPlaced) {
+    value += (session->skinC - kAmbientC) * (1 - exp(-(t - session->tempPlaced) / session->tau));
+  }
+  if(!tempPrediction.settled()) tempPrediction.process((float)t, tempDespike.process((float)value));
+}
+
+static PeriodicTask tempTask(sampleTemperature, 100);
+
+static void enterTemperature() {
+  tempPrediction.reset();
+  tempDespike.reset();
+  tempTask.start(scheduler.now());
+}
+
+static void tickTemperature() {
+  if(!tempPrediction.settled() && scheduler.elapsed() < kTempWindowMs) return;
+  tempTask.stop();
+  stateMs[TEMP] = scheduler.elapsed();
+  holdResult(ECG);
+}
+
+static void tickECG() {
+  if(scheduler.elapsed() < kEcgWindowMs) return;
+  stateMs[ECG] = scheduler.elapsed();
+  scheduler.transition(DONE);
+}
+
+int main() {
+  scheduler.addTask(weightTask);
+  scheduler.addTask(tempTask);
+
+  printf("Session from WEIGHT to the end of ECG, %.0f s for the original sketch\n\n", kOriginalSessionS);
+  printf("session          weight   SpO2     temp     ECG      holds    total    shorter\n");
+  int sessions = sizeof(kSessions) / sizeof(kSessions[0]);
+  for(int s = 0; s < sessions; s++) {
+    session = &kSessions[s];
+    noiseState = 12345 + s;
+    fakeNow = 0;
+    scheduler.begin(WEIGHT);
+    while(scheduler.state() != DONE) {
+      fakeNow += kTickMs;
+      scheduler.tick();
+    }
+
+    double total = fakeNow / 1000.0;
+    printf("%-15s", session->name);
+    printf("  %4.1f s   %4.1f s   %4.1f s   %4.1f s   %4.1f s   %4.1f s   %3.0f%%\n", stateMs[WEIGHT] / 1000.0,
+           stateMs[SPO2] / 1000.0, stateMs[TEMP] / 1000.0, stateMs[ECG] / 1000.0, 2 * kResultHoldMs / 1000.0,
+           total, 100 * (1 - total / kOriginalSessionS));
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Two-thread stress test of SpscQueue and the sampling jitter behind it
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -pthread -o spsc_queue_test dsp_host/spsc_queue_test.cpp
+//   ./spsc_queue_test
+// Add -fsanitize=thread -g to run the same test under ThreadSanitizer.
+//
+// The first part pushes sequence numbered elements through a small queue as
+// fast as possible while the consumer pops in bursts with random pauses, so
+// the queue runs full and empty all the time. Every element carries a payload
+// derived from its sequence number, a torn or stale read shows up as a
+// mismatch. The producer retries a full queue, so every element has to arrive
+// exactly once and in order, and dropped() has to count the failed pushes.
+//
+// The second part runs the ECG sampler pattern of FinalIntegration: a 250 Hz
+// producer thread paced with sleep_until() pushes timestamps while the
+// consumer stalls for 30 ms at a time, like a full SSD1306 frame push. It
+// reports how late each sample was taken and how long push() took. On a host
+// the lateness is mostly the OS scheduler, what the queue adds is the push
+// time. Exits with 1 on the first failed check.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../FinalIntegration/spsc_queue.h"
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if(!(condition)) {                                                    \
+      printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition);        \
+      exit(1);                                                            \
+    }                                                                     \
+  } while(0)
+
+typedef std::chrono::steady_clock Clock;
+
+struct Element {
+  uint32_t sequence;
+  uint32_t payload[7];
+};
+
+static uint32_t payloadOf(uint32_t sequence, int i) {
+  return sequence * 2654435761u + (uint32_t)i;
+}
+
+static void testSingleThread() {
+  SpscQueue<int, 4> queue;
+  int value;
+  CHECK(queue.empty());
+  CHECK(!queue.pop(value));
+  for(int i = 0; i < 4; i++) CHECK(queue.push(i));
+  CHECK(!queue.push(4));
+  CHECK(queue.dropped() == 1);
+  CHECK(queue.size() == 4);
+  CHECK(queue.pop(value) && value == 0);
+  CHECK(queue.push(5));
+  queue.clear();
+  CHECK(queue.empty());
+  CHECK(queue.push(6));
+  CHECK(queue.pop(value) && value == 6);
+}
+
+static void testStress(uint32_t count) {
+  static SpscQueue<Element, 16> queue;
+  unsigned long failed = 0;
+
+  std::thread producer([&]() {
+    for(uint32_t sequence = 0; sequence < count; sequence++) {
+      Element element;
+      element.sequence = sequence;
+      for(int i = 0; i < 7; i++) element.payload[i] = payloadOf(sequence, i);
+      while(!queue.push(element)) {
+        failed++;
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  bool ok = true;
+  uint32_t seed = 1;
+  while(expected < count) {
+    // Pop a random burst, then pause so the producer fills the queue
+    seed = seed * 1664525u + 1013904223u;
+    int burst = 1 + (seed >> 27);
+    Element element;
+    for(int i = 0; i < burst && queue.pop(element); i++) {
+      if(element.sequence != expected) ok = false;
+      for(int j = 0; j < 7; j++) {
+        if(element.payload[j] != payloadOf(element.sequence, j)) ok = false;
+      }
+      expected++;
+    }
+    if((seed >> 20) % 64 == 0) std::this_thread::yield();
+  }
+  producer.join();
+
+  Element element;
+  CHECK(ok);
+  CHECK(expected == count);
+  CHECK(!queue.pop(element));
+  CHECK(queue.dropped() == failed);
+  printf("stress: %u elements in order, %lu pushes retried on a full queue\n", count, failed);
+}
+
+static void testJitter() {
+  const int kRateHz = 250;
+  const int kSamples = 2500;
+  const auto kPeriod = std::chrono::microseconds(1000000 / kRateHz);
+  static SpscQueue<Clock::time_point, 64> queue;
+  std::atomic<bool> done(false);
+  std::vector<double> late_us, push_us;
+  late_us.reserve(kSamples);
+  push_us.reserve(kSamples);
+
+  std::thread sampler([&]() {
+    Clock::time_point next = Clock::now();
+    for(int i = 0; i < kSamples; i++) {
+      next += kPeriod;
+      std::this_thread::sleep_until(next);
+      Clock::time_point taken = Clock::now();
+      late_us.push_back(std::chrono::duration<double, std::micro>(taken - next).count());
+      queue.push(taken);
+      push_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - taken).count());
+    }
+    done = true;
+  });
+
+  // Stall 30 ms, then drain, like the transport task pushing a frame
+  unsigned long received = 0;
+  while(!done || !queue.empty()) {
+    Clock::time_point until = Clock::now() + std::chrono::milliseconds(30);
+    while(Clock::now() < until) {}
+    Clock::time_point sample;
+    while(queue.pop(sample)) received++;
+  }
+  sampler.join();
+
+  CHECK(received == (unsigned long)kSamples);
+  CHECK(queue.dropped() == 0);
+  std::sort(late_us.begin(), late_us.end());
+  std::sort(push_us.begin(), push_us.end());
+  printf("jitter: %d samples at %d Hz, consumer stalls 30 ms\n", kSamples, kRateHz);
+  printf("  sample taken late  median %7.1f us  99.9%% %7.1f us  max %7.1f us\n", late_us[kSamples / 2],
+         late_us[kSamples * 999 / 1000], late_us[kSamples - 1]);
+  printf("  push()             median %7.3f us  99.9%% %7.3f us  max %7.3f us\n", push_us[kSamples / 2],
+         push_us[kSamples * 999 / 1000], push_us[kSamples - 1]);
+}
+
+int main() {
+  testSingleThread();
+  testStress(2000000);
+  testJitter();
+  printf("spsc_queue: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,157 @@
+// SSD1306 bus traffic per screen update, whole frames vs dirty windows, and
+// how long the drawing side waits for it
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -DARDUINO=10819 -I dsp_host/mock -I libraries/Adafruit_BusIO -I libraries/Adafruit_GFX_Library -I libraries/Adafruit_SSD1306 -o ssd1306_dirty_benchmark dsp_host/ssd1306_dirty_benchmark.cpp libraries/Adafruit_SSD1306/Adafruit_SSD1306.cpp libraries/Adafruit_GFX_Library/Adafruit_GFX.cpp libraries/Adafruit_BusIO/Adafruit_I2CDevice.cpp libraries/Adafruit_BusIO/Adafruit_SPIDevice.cpp libraries/Adafruit_BusIO/Adafruit_GenericDevice.cpp
+//   ./ssd1306_dirty_benchmark
+//
+// Draws the screens of FinalIntegration the way the sketch does: the SpO2
+// screen rewrites its values over a black background, the temperature and
+// weight screens clear the buffer and redraw everything. Every update is
+// checked against the RAM of the simulated panel. Double buffered, display()
+// only hands the frame over and the chunks are pushed afterwards, as the
+// transport task on core 0 does, while the next frame is already drawn.
+#include <cstdio>
+
+#include <Adafruit_SSD1306.h>
+
+#include "SSD1306_device.h"
+
+TwoWire Wire;
+Stream Serial;
+SPIClass SPI;
+
+static const uint8_t kWidth = 128;
+static const uint8_t kHeight = 64;
+static const uint8_t kAddress = 0x3C;
+static const int kUpdates = 200;
+static const uint16_t kChunk = 212; // I2CBus::displayChunkBytes(10) at 400 kHz and 2 ms
+
+enum Refresh {
+  REFRESH_WHOLE,  // Every update pushes the whole frame, as before
+  REFRESH_DISPLAY, // display()
+  REFRESH_CHUNKS, // displayChunk() loop of refreshDisplay()
+  REFRESH_DOUBLE  // Double buffered display(), then the displayChunk() loop
+};
+
+static void header(Adafruit_SSD1306& display) {
+  display.clearDisplay();
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  display.setCursor(0, 0);
+  display.println("");
+  display.setCursor(5, display.getCursorY());
+  display.setTextSize(2);
+  display.println("BPM  %SpO2");
+}
+
+static void drawSpO2(Adafruit_SSD1306& display, int i) {
+  if(i == 0) header(display);
+  display.setCursor(5, 35);
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  display.setTextSize(3);
+  display.print(70 + (i * 7) % 23);
+  display.print(" ");
+  display.print(95 + i / 5 % 5);
+  display.println("    ");
+}
+
+static void drawTemperature(Adafruit_SSD1306& display, int i) {
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE);
+  display.setCursor(0, 0);
+  display.setTextSize(2);
+  display.print("Temp:");
+  display.setCursor(0, 30);
+  display.print(34.0 + i * 0.013, 1);
+  display.print(" C");
+}
+
+static void drawWeight(Adafruit_SSD1306& display, int i) {
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE);
+  display.setCursor(0, 0);
+  display.setTextSize(2);
+  display.print("Weight:");
+  display.setCursor(0, 30);
+  display.print(500.0 + (i % 9) * 0.01, 2);
+  display.print(" g");
+}
+
+struct Result {
+  MockI2CStats stats;
+  double draw_us; // Bus time inside display(), the drawing task waits for it
+  unsigned long data_bytes;
+  int mismatches;
+};
+
+static Result run(void (*draw)(Adafruit_SSD1306&, int), Refresh refresh) {
+  TwoWire wire;
+  MockSSD1306 panel(kWidth, kHeight);
+  wire.attach(kAddress, &panel);
+  Adafruit_SSD1306 display(kWidth, kHeight, &wire);
+  Result result = {};
+  if(!display.begin(SSD1306_SWITCHCAPVCC, kAddress)) {
+    printf("display setup failed\n");
+    return result;
+  }
+  display.display(); // Splash
+  draw(display, 0);
+  display.display();
+  if(refresh == REFRESH_DOUBLE) display.setDoubleBuffer(true);
+
+  wire.resetStats();
+  unsigned long data_before = panel.dataBytes();
+  for(int i = 1; i <= kUpdates; i++) {
+    draw(display, i);
+    if(refresh == REFRESH_WHOLE) display.markDirty();
+    if(refresh != REFRESH_CHUNKS) {
+      double before = wire.stats().busMicros(400000);
+      display.display();
+      result.draw_us += wire.stats().busMicros(400000) - before;
+    }
+    uint8_t shown[kWidth * kHeight / 8];
+    memcpy(shown, display.getBuffer(), sizeof(shown));
+    if(refresh == REFRESH_CHUNKS || refresh == REFRESH_DOUBLE) {
+      bool drawn = refresh != REFRESH_DOUBLE;
+      for(uint16_t offset = 0; offset < sizeof(shown);) {
+        offset = display.displayChunk(offset, kChunk);
+        // Must not show up before the next display()
+        if(!drawn) draw(display, i + kUpdates);
+        drawn = true;
+      }
+    }
+    if(memcmp(panel.ram(), shown, sizeof(shown)) != 0) result.mismatches++;
+  }
+  result.stats = wire.stats();
+  result.data_bytes = panel.dataBytes() - data_before;
+  return result;
+}
+
+int main() {
+  struct Screen {
+    const char* name;
+    void (*draw)(Adafruit_SSD1306&, int);
+  };
+  const Screen kScreens[] = { { "SpO2 values", drawSpO2 }, { "temperature", drawTemperature }, { "weight", drawWeight } };
+  const char* kRefreshNames[] = { "whole frame", "display()", "displayChunk()", "double buffer" };
+
+  printf("%d updates per screen, %dx%d, per update averages\n\n", kUpdates, kWidth, kHeight);
+  printf("screen        refresh          trans  data bytes  bus bytes  us at 400 kHz  display() us  panel\n");
+  for(const Screen& screen : kScreens) {
+    double whole_bytes = 0;
+    for(int refresh = REFRESH_WHOLE; refresh <= REFRESH_DOUBLE; refresh++) {
+      Result result = run(screen.draw, (Refresh)refresh);
+      double bytes = (double)result.stats.bytes / kUpdates;
+      if(refresh == REFRESH_WHOLE) whole_bytes = bytes;
+      char draw_us[16] = "-";
+      if(refresh != REFRESH_CHUNKS) snprintf(draw_us, sizeof(draw_us), "%.0f", result.draw_us / kUpdates);
+      printf("%-13s %-15s %6.1f  %10.1f  %9.1f  %13.0f  %12s  %s", screen.name, kRefreshNames[refresh],
+             (double)result.stats.transactions / kUpdates, (double)result.data_bytes / kUpdates, bytes,
+             result.stats.busMicros(400000) / kUpdates, draw_us, result.mismatches ? "DIFFERENT" : "same");
+      if(refresh != REFRESH_WHOLE) printf("  %.1fx fewer bytes", whole_bytes / bytes);
+      printf("\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,173 @@
+// Time and error of the body temperature, 10 s average vs ExponentialApproachEstimator
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -o temperature_prediction_benchmark dsp_host/temperature_prediction_benchmark.cpp
+//   ./temperature_prediction_benchmark
+//
+// Object temperature traces at the 10 Hz update rate of the MLX90614 with its
+// default filters: the reading sits at the ambient temperature until the
+// forehead comes into view, then approaches the skin temperature with a time
+// constant of a few tenths of a second to 2 s, with 0.03 C of noise. Some
+// traces add a second, slower time constant, a target that is already in view
+// or one that leaves the view for a moment. They are modelled on the readings
+// of the FinalIntegration thermometer, no recording is kept in the tree. Each
+// trace is measured the way the sketch did (average of the median filtered
+// readings over 10 s) and with the estimator behind the same median. The last
+// table runs 500 random traces of the first kind.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Arduino definitions used by filters.h
+using std::isnan;
+using std::max;
+using std::min;
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#include "../FinalIntegration/filters.h"
+
+static const double kRate = 10.0;
+static const double kWindowS = 10.0;
+static const double kAmbientC = 24.0;
+static const double kNoiseC = 0.03;
+
+// Same as FinalIntegration
+static const float kTempToleranceC = 0.15;
+static const float kTempMinimumC = 30.0;
+static const int kTempFitSamples = 64;
+
+struct Trace {
+  const char* name;
+  double target;  // Final reading in C
+  double placed;  // Time the target comes into view in s, negative if it already is
+  double tau;     // Time constant of the approach in s
+  double slow;    // Share of the approach with a 4 s time constant
+  double away;    // Time the target leaves the view for 0.5 s, 0 if never
+};
+
+static const Trace kTraces[] = {
+  { "36.6 C, tau 0.5 s", 36.6, 0.3, 0.5, 0, 0 },
+  { "36.6 C, tau 1 s", 36.6, 0.8, 1.0, 0, 0 },
+  { "36.6 C, tau 2 s", 36.6, 0.5, 2.0, 0, 0 },
+  { "38.9 C, tau 1 s", 38.9, 0.5, 1.0, 0, 0 },
+  { "already in view", 36.6, -10, 1.0, 0, 0 },
+  { "10% at tau 4 s", 36.6, 0.5, 0.6, 0.1, 0 },
+  { "looks away at 2 s", 36.6, 0.5, 0.8, 0, 2.0 }
+};
+
+// Deterministic Gaussian noise
+static double noise(uint32_t& state) {
+  double u[2];
+  for(int i = 0; i < 2; i++) {
+    state = state * 1664525u + 1013904223u;
+    u[i] = ((state >> 8) + 1.0) / 16777217.0;
+  }
+  return sqrt(-2.0 * log(u[0])) * cos(2 * PI * u[1]);
+}
+
+static double reading(const Trace& trace, double t, uint32_t& state) {
+  double value = kAmbientC + kNoiseC * noise(state);
+  if(t < trace.placed) return value;
+  if(trace.away > 0 && t >= trace.away && t < trace.away + 0.5) return value;
+
+  // Looking away restarts the approach
+  double since = t - (trace.away > 0 && t >= trace.away ? trace.away + 0.5 : trace.placed);
+  double rise = (1 - trace.slow) * (1 - exp(-since / trace.tau)) + trace.slow * (1 - exp(-since / 4.0));
+  return value + (trace.target - kAmbientC) * rise;
+}
+
+struct Result {
+  double seconds;
+  double value;
+  bool settled;
+};
+
+static Result average(const std::vector<double>& samples) {
+  SlidingMedianFilter<5> despike;
+  double sum = 0;
+  for(size_t i = 0; i < samples.size(); i++) sum += despike.process((float)samples[i]);
+  Result result = { kWindowS, sum / samples.size(), false };
+  return result;
+}
+
+static Result predict(const std::vector<double>& samples) {
+  ExponentialApproachEstimator<kTempFitSamples> estimator(kTempToleranceC, kTempMinimumC);
+  SlidingMedianFilter<5> despike;
+  for(size_t i = 0; i < samples.size(); i++) {
+    if(estimator.process(i / kRate, despike.process((float)samples[i]))) {
+      Result result = { (i + 1) / kRate, estimator.value(), true };
+      return result;
+    }
+  }
+  Result result = { kWindowS, estimator.value(), false };
+  return result;
+}
+
+static std::vector<double> sample(const Trace& trace, uint32_t seed) {
+  std::vector<double> samples((size_t)(kWindowS * kRate));
+  for(size_t i = 0; i < samples.size(); i++) samples[i] = reading(trace, i / kRate, seed);
+  return samples;
+}
+
+int main() {
+  printf("%.0f Hz, final when the 95%% interval is within %.2f C, readings above %.0f C, timeout %.0f s\n\n",
+         kRate, kTempToleranceC, kTempMinimumC, kWindowS);
+  printf("trace               10 s average        predicted\n");
+  int traces = sizeof(kTraces) / sizeof(kTraces[0]);
+  for(int t = 0; t < traces; t++) {
+    std::vector<double> samples = sample(kTraces[t], 12345 + t);
+    Result results[2] = { average(samples), predict(samples) };
+    printf("%-18s", kTraces[t].name);
+    for(int m = 0; m < 2; m++) {
+      printf("  %4.1f s %+7.2f C%s", results[m].seconds, results[m].value - kTraces[t].target,
+             m == 1 && !results[m].settled ? " timeout" : "  ");
+    }
+    printf("\n");
+  }
+
+  // Random targets, time constants and placements
+  const int kRuns = 500;
+  std::vector<double> errors[2], times;
+  uint32_t state = 1;
+  int timeouts = 0;
+  double fit_seconds = 0;
+  long fits = 0;
+  for(int run = 0; run < kRuns; run++) {
+    state = state * 1664525u + 1013904223u;
+    double target = 35.5 + 3.0 * (state >> 8) / 16777216.0;
+    state = state * 1664525u + 1013904223u;
+    double tau = 0.3 + 1.7 * (state >> 8) / 16777216.0;
+    state = state * 1664525u + 1013904223u;
+    double placed = (state >> 8) / 16777216.0;
+    Trace trace = { "", target, placed, tau, 0, 0 };
+    std::vector<double> samples = sample(trace, run);
+
+    auto start = std::chrono::steady_clock::now();
+    Result predicted = predict(samples);
+    fit_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fits += (long)(predicted.seconds * kRate);
+
+    errors[0].push_back(fabs(average(samples).value - target));
+    errors[1].push_back(fabs(predicted.value - target));
+    times.push_back(predicted.seconds - placed);
+    if(!predicted.settled) timeouts++;
+  }
+  for(int m = 0; m < 2; m++) std::sort(errors[m].begin(), errors[m].end());
+  std::sort(times.begin(), times.end());
+  double mean_time = 0;
+  for(double time : times) mean_time += time / kRuns;
+
+  printf("\n%d traces, 35.5 to 38.5 C, tau 0.3 to 2 s, in view after 0 to 1 s\n", kRuns);
+  printf("                    10 s average   predicted\n");
+  printf("median error        %10.2f C  %8.2f C\n", errors[0][kRuns / 2], errors[1][kRuns / 2]);
+  printf("95th pct error      %10.2f C  %8.2f C\n", errors[0][kRuns * 95 / 100], errors[1][kRuns * 95 / 100]);
+  printf("worst error         %10.2f C  %8.2f C\n", errors[0][kRuns - 1], errors[1][kRuns - 1]);
+  printf("time after in view  %10s    %6.1f s mean, %.1f s 95th pct, %d timeouts\n", "-", mean_time,
+         times[kRuns * 95 / 100], timeouts);
+  printf("cost per sample     %10s    %6.1f us on this host\n", "-", fit_seconds * 1e6 / fits);
+  return 0;
+}
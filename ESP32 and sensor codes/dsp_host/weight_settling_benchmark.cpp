@@ -0,0 +1,151 @@
+// Time until the weight is reported, fixed windows vs SettlingDetector
+//
+// Build and run from the "ESP32 and sensor codes" folder:
+//   g++ -std=c++11 -O2 -o weight_settling_benchmark dsp_host/weight_settling_benchmark.cpp
+//   ./weight_settling_benchmark
+//
+// Load cell traces at the 10 SPS of the HX711, in grams after calibration:
+// the load is put on at some point, rings for about half a second and
+// settles, with 0.5 g of noise. Some traces add creep of the load cell, a
+// hand that keeps touching the load or a load that never stops swaying. They
+// are modelled on the readings of the FinalIntegration scale, no recording is
+// kept in the tree. Each trace is measured three ways: the original sketch
+// (2 s message, 2 s delay, 5 s average), the scheduler version (1 s wait, 5 s
+// average) and SettlingDetector behind the 3 sample median of FinalIntegration.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Arduino definitions used by filters.h
+using std::isnan;
+using std::max;
+using std::min;
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#include "../FinalIntegration/filters.h"
+
+static const double kRate = 10.0;
+static const double kTraceSeconds = 10.0;
+
+// Same as FinalIntegration
+static const int kWeightStableSamples = 10;
+static const float kWeightToleranceG = 2.0;
+static const float kWeightDriftG = 1.0;
+static const float kWeightMinimumG = 10.0;
+static const double kWeightTimeoutS = 6.0;
+
+struct Trace {
+  const char* name;
+  double weight;   // Final load in g, 0 for an empty scale
+  double placed;   // Time the load is put on in s
+  double creep;    // Slow increase of the reading as share of the load
+  double wobble;   // Amplitude in g of a hand touching the load for 2 s
+  double sway;     // Amplitude in g of a load that keeps moving
+};
+
+static const Trace kTraces[] = {
+  { "500 g at 0.3 s", 500, 0.3, 0, 0, 0 },
+  { "500 g at 1.5 s", 500, 1.5, 0, 0, 0 },
+  { "2 kg with creep", 2000, 0.4, 0.004, 0, 0 },
+  { "200 g, hand on it", 200, 0.3, 0, 15, 0 },
+  { "50 g at 0.8 s", 50, 0.8, 0, 0, 0 },
+  { "500 g, swaying", 500, 0.3, 0, 0, 8 },
+  { "empty scale", 0, 0, 0, 0, 0 }
+};
+
+// Deterministic Gaussian noise
+static double noise(uint32_t& state) {
+  double u[2];
+  for(int i = 0; i < 2; i++) {
+    state = state * 1664525u + 1013904223u;
+    u[i] = ((state >> 8) + 1.0) / 16777217.0;
+  }
+  return sqrt(-2.0 * log(u[0])) * cos(2 * PI * u[1]);
+}
+
+static double reading(const Trace& trace, double t, uint32_t& state) {
+  double value = 0.5 * noise(state);
+  if(t < trace.placed || trace.weight == 0) return value;
+
+  double since = t - trace.placed;
+  value += trace.weight * (1 - exp(-since / 0.25) * cos(2 * PI * 4 * since));
+  value += trace.weight * trace.creep * (1 - exp(-since / 2.0));
+  if(since < 2.0) value += trace.wobble * sin(2 * PI * 1.3 * since);
+  value += trace.sway * sin(2 * PI * 0.7 * t);
+  return value;
+}
+
+struct Result {
+  double seconds;
+  double weight;
+  bool settled;
+};
+
+// Average over [start, end) and report at end
+static Result fixedWindow(const double* samples, double start, double end) {
+  double sum = 0;
+  int count = 0;
+  for(int i = (int)(start * kRate); i < (int)(end * kRate); i++) {
+    sum += samples[i];
+    count++;
+  }
+  Result result = { end, count > 0 ? sum / count : 0, false };
+  return result;
+}
+
+static Result settling(const double* samples) {
+  SettlingDetector<kWeightStableSamples> detector(kWeightToleranceG, kWeightDriftG, kWeightMinimumG);
+  SlidingMedianFilter<3> despike;
+  for(int i = 0; i < (int)(kWeightTimeoutS * kRate); i++) {
+    if(detector.process(despike.process((float)samples[i]))) {
+      Result result = { (i + 1) / kRate, detector.value(), true };
+      return result;
+    }
+  }
+  Result result = { kWeightTimeoutS, detector.value(), false };
+  return result;
+}
+
+int main() {
+  const int count = (int)(kTraceSeconds * kRate);
+  printf("%.0f SPS, settled when %d samples are within %.1f g (std dev), their line moves by at most %.1f g\n"
+         "across the window and they are above %.0f g, timeout %.0f s\n\n", kRate, kWeightStableSamples, kWeightToleranceG,
+         kWeightDriftG, kWeightMinimumG, kWeightTimeoutS);
+  printf("trace                2+2+5 s             1+5 s               settling\n");
+
+  double total[3] = {};
+  double worst[3] = {};
+  double afterPlacement = 0;
+  int settled = 0;
+  int traces = sizeof(kTraces) / sizeof(kTraces[0]);
+  for(int t = 0; t < traces; t++) {
+    const Trace& trace = kTraces[t];
+    double samples[100];
+    uint32_t state = 12345 + t;
+    for(int i = 0; i < count; i++) samples[i] = reading(trace, i / kRate, state);
+
+    Result results[3] = { fixedWindow(samples, 4.0, 9.0), fixedWindow(samples, 1.0, 6.0), settling(samples) };
+    double target = trace.weight * (1 + trace.creep);
+    printf("%-18s", trace.name);
+    for(int m = 0; m < 3; m++) {
+      double error = results[m].weight - target;
+      total[m] += results[m].seconds;
+      worst[m] = std::max(worst[m], fabs(error));
+      printf("  %4.1f s %+7.2f g%s", results[m].seconds, error, m == 2 && !results[m].settled ? " timeout" : "  ");
+    }
+    printf("\n");
+    if(results[2].settled) {
+      afterPlacement += results[2].seconds - trace.placed;
+      settled++;
+    }
+  }
+  printf("%-18s", "average time");
+  for(int m = 0; m < 3; m++) printf("  %4.1f s %9s  ", total[m] / traces, "");
+  printf("\n%-18s", "worst error");
+  for(int m = 0; m < 3; m++) printf("         %7.2f g  ", worst[m]);
+  printf("\n\nsettling, average time after the load was put on: %.1f s over %d traces\n",
+         afterPlacement / settled, settled);
+  return 0;
+}
@@ -0,0 +1,125 @@
+"""Python binding for the serial frame decoder (frame_decoder.cpp).
+
+Build the shared library once from the "ESP32 and sensor codes" folder:
+
+    g++ -O2 -shared -fPIC -o frame_decoder/libframe_decoder.so \
+        frame_decoder/frame_decoder.cpp -x c FinalIntegration/crc16.c
+
+On Windows name the output frame_decoder/frame_decoder.dll instead.
+"""
+import ctypes
+import os
+import struct
+import sys
+
+# Frame types, see FinalIntegration/frame_protocol.h
+FRAME_WEIGHT = 0x01
+FRAME_SPO2 = 0x02
+FRAME_PULSE = 0x03
+FRAME_TEMP = 0x04
+FRAME_ECG_START = 0x10
+FRAME_ECG_SAMPLES = 0x11
+FRAME_DATA_END = 0x1F
+
+_EVENT_FRAME = 0
+_EVENT_TEXT = 1
+_EVENT_DATA_SIZE = 256
+_MAX_ECG_SAMPLES = 256
+
+
+class _FrameEvent(ctypes.Structure):
+    _fields_ = [
+        ("kind", ctypes.c_uint8),
+        ("type", ctypes.c_uint8),
+        ("seq", ctypes.c_uint8),
+        ("length", ctypes.c_uint16),
+        ("data", ctypes.c_uint8 * _EVENT_DATA_SIZE),
+    ]
+
+
+def _load_library():
+    directory = os.path.dirname(os.path.abspath(__file__))
+    if sys.platform == "win32":
+        names = ["frame_decoder.dll", "libframe_decoder.dll"]
+    elif sys.platform == "darwin":
+        names = ["libframe_decoder.dylib", "libframe_decoder.so"]
+    else:
+        names = ["libframe_decoder.so"]
+    for name in names:
+        path = os.path.join(directory, name)
+        if os.path.exists(path):
+            return ctypes.CDLL(path)
+    raise ImportError("frame decoder library not built, see frame_decoder/__init__.py")
+
+
+_lib = _load_library()
+_lib.frame_decoder_create.restype = ctypes.c_void_p
+_lib.frame_decoder_destroy.argtypes = [ctypes.c_void_p]
+_lib.frame_decoder_feed.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+_lib.frame_decoder_next.argtypes = [ctypes.c_void_p, ctypes.POINTER(_FrameEvent)]
+_lib.frame_decoder_next.restype = ctypes.c_int
+_lib.frame_decoder_crc_errors.argtypes = [ctypes.c_void_p]
+_lib.frame_decoder_crc_errors.restype = ctypes.c_ulong
+_lib.frame_decoder_lost_frames.argtypes = [ctypes.c_void_p]
+_lib.frame_decoder_lost_frames.restype = ctypes.c_ulong
+_lib.frame_decode_ecg.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_uint32),
+                                  ctypes.POINTER(ctypes.c_int16), ctypes.c_size_t]
+_lib.frame_decode_ecg.restype = ctypes.c_size_t
+
+
+class Frame:
+    """A decoded frame with its payload as bytes."""
+
+    def __init__(self, type, seq, payload):
+        self.type = type
+        self.seq = seq
+        self.payload = payload
+
+    def float_value(self):
+        """Payload of FRAME_WEIGHT, FRAME_SPO2, FRAME_PULSE and FRAME_TEMP."""
+        return struct.unpack("<f", self.payload[:4])[0]
+
+    def rate(self):
+        """Payload of FRAME_ECG_START, sampling rate in Hz."""
+        return struct.unpack("<H", self.payload[:2])[0]
+
+    def ecg_samples(self):
+        """Payload of FRAME_ECG_SAMPLES, returns (index of the first sample, samples)."""
+        first_index = ctypes.c_uint32()
+        samples = (ctypes.c_int16 * _MAX_ECG_SAMPLES)()
+        count = _lib.frame_decode_ecg(self.payload, len(self.payload), ctypes.byref(first_index),
+                                      samples, _MAX_ECG_SAMPLES)
+        return first_index.value, list(samples[:count])
+
+
+class FrameDecoder:
+    """Splits the serial byte stream into frames and text lines."""
+
+    def __init__(self):
+        self._decoder = _lib.frame_decoder_create()
+        self._event = _FrameEvent()
+
+    def __del__(self):
+        if self._decoder:
+            _lib.frame_decoder_destroy(self._decoder)
+            self._decoder = None
+
+    def feed(self, data):
+        """Feeds received bytes, returns a list of Frame objects and text lines (str)."""
+        _lib.frame_decoder_feed(self._decoder, bytes(data), len(data))
+        events = []
+        while _lib.frame_decoder_next(self._decoder, ctypes.byref(self._event)):
+            data = bytes(self._event.data[:self._event.length])
+            if self._event.kind == _EVENT_TEXT:
+                events.append(data.decode("utf-8", errors="replace"))
+            else:
+                events.append(Frame(self._event.type, self._event.seq, data))
+        return events
+
+    @property
+    def crc_errors(self):
+        return _lib.frame_decoder_crc_errors(self._decoder)
+
+    @property
+    def lost_frames(self):
+        return _lib.frame_decoder_lost_frames(self._decoder)
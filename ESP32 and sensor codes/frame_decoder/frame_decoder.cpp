@@ -0,0 +1,198 @@
+#include "frame_decoder.h"
+
+#include <string.h>
+
+FrameDecoder::FrameDecoder() :
+  state_(SYNC0),
+  rescan_(0),
+  have_seq_(false),
+  next_seq_(0),
+  crc_errors_(0),
+  lost_frames_(0){}
+
+void FrameDecoder::feed(const uint8_t* data, size_t length) {
+  input_.insert(input_.end(), data, data + length);
+  while(!input_.empty()) {
+    uint8_t byte = input_.front();
+    input_.pop_front();
+    process(byte);
+    if(rescan_ > 0 && --rescan_ == 0) {
+      // Text made of the bytes of a rejected frame is noise
+      text_.clear();
+    }
+  }
+}
+
+bool FrameDecoder::next(FrameEvent& event) {
+  if(events_.empty()) return false;
+  event = events_.front();
+  events_.pop_front();
+  return true;
+}
+
+void FrameDecoder::process(uint8_t byte) {
+  switch(state_) {
+    case SYNC0:
+      if(byte == kFrameSync0) {
+        frame_.assign(1, byte);
+        state_ = SYNC1;
+      }
+      else {
+        text(byte);
+      }
+      break;
+
+    case SYNC1:
+      if(byte == kFrameSync1) {
+        // A frame never starts in the middle of a text line
+        text_.clear();
+        frame_.push_back(byte);
+        state_ = HEADER;
+      }
+      else {
+        // Not a frame, look at the byte again
+        state_ = SYNC0;
+        process(byte);
+      }
+      break;
+
+    case HEADER:
+      frame_.push_back(byte);
+      if(frame_.size() == kFrameHeaderSize) {
+        if(frame_[4] > kFrameMaxPayload) {
+          crc_errors_++;
+          resync();
+        }
+        else {
+          state_ = frame_[4] > 0 ? PAYLOAD : CRC;
+        }
+      }
+      break;
+
+    case PAYLOAD:
+      frame_.push_back(byte);
+      if(frame_.size() == kFrameHeaderSize + frame_[4]) state_ = CRC;
+      break;
+
+    case CRC:
+      frame_.push_back(byte);
+      if(frame_.size() == kFrameHeaderSize + frame_[4] + kFrameCrcSize) finishFrame();
+      break;
+  }
+}
+
+void FrameDecoder::text(uint8_t byte) {
+  if(byte == '\r') return;
+  if(byte != '\n') text_.push_back(byte);
+  if(byte != '\n' && text_.size() < kFrameEventDataSize) return;
+  if(text_.empty()) return;
+  if(rescan_ > 0) {
+    // A line ended by a byte of a rejected frame, the device only sends printable ASCII
+    for(uint8_t c : text_) {
+      if(c < 0x20 || c > 0x7E) {
+        text_.clear();
+        return;
+      }
+    }
+  }
+
+  FrameEvent event;
+  event.kind = FRAME_EVENT_TEXT;
+  event.type = 0;
+  event.seq = 0;
+  event.length = (uint16_t)text_.size();
+  memcpy(event.data, text_.data(), text_.size());
+  events_.push_back(event);
+  text_.clear();
+}
+
+void FrameDecoder::finishFrame() {
+  size_t length = frame_[4];
+  unsigned short crc = crc16_data(frame_.data() + 2, (int)(kFrameHeaderSize - 2 + length), 0);
+  unsigned short received = frame_[kFrameHeaderSize + length] | (frame_[kFrameHeaderSize + length + 1] << 8);
+  if(crc != received) {
+    crc_errors_++;
+    resync();
+    return;
+  }
+
+  uint8_t seq = frame_[3];
+  if(have_seq_ && seq != next_seq_) lost_frames_ += (uint8_t)(seq - next_seq_);
+  have_seq_ = true;
+  next_seq_ = seq + 1;
+
+  FrameEvent event;
+  event.kind = FRAME_EVENT_FRAME;
+  event.type = frame_[2];
+  event.seq = seq;
+  event.length = (uint16_t)length;
+  memcpy(event.data, frame_.data() + kFrameHeaderSize, length);
+  events_.push_back(event);
+
+  frame_.clear();
+  state_ = SYNC0;
+}
+
+void FrameDecoder::resync() {
+  // The sync bytes may have been noise, rescan everything after them
+  input_.insert(input_.begin(), frame_.begin() + 1, frame_.end());
+  // feed() counts the current byte off after this, bytes still waiting from an
+  // earlier resync stay in the count
+  rescan_ = frame_.size() - 1 + (rescan_ > 0 ? rescan_ : 1);
+  frame_.clear();
+  state_ = SYNC0;
+}
+
+extern "C" {
+
+void* frame_decoder_create(void) {
+  return new FrameDecoder();
+}
+
+void frame_decoder_destroy(void* decoder) {
+  delete static_cast<FrameDecoder*>(decoder);
+}
+
+void frame_decoder_feed(void* decoder, const uint8_t* data, size_t length) {
+  static_cast<FrameDecoder*>(decoder)->feed(data, length);
+}
+
+int frame_decoder_next(void* decoder, FrameEvent* event) {
+  return static_cast<FrameDecoder*>(decoder)->next(*event) ? 1 : 0;
+}
+
+unsigned long frame_decoder_crc_errors(void* decoder) {
+  return static_cast<FrameDecoder*>(decoder)->crcErrors();
+}
+
+unsigned long frame_decoder_lost_frames(void* decoder) {
+  return static_cast<FrameDecoder*>(decoder)->lostFrames();
+}
+
+size_t frame_decode_ecg(const uint8_t* payload, size_t length, uint32_t* first_index,
+                        int16_t* samples, size_t max_samples) {
+  if(length < 6 || max_samples == 0) return 0;
+
+  *first_index = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24);
+  int16_t value = (int16_t)(payload[4] | (payload[5] << 8));
+  samples[0] = value;
+
+  size_t count = 1;
+  size_t i = 6;
+  while(i < length && count < max_samples) {
+    uint16_t zigzag = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+      byte = payload[i++];
+      zigzag |= (uint16_t)((byte & 0x7F) << shift);
+      shift += 7;
+    } while((byte & 0x80) && i < length);
+
+    value = (int16_t)(value + (int16_t)((zigzag >> 1) ^ -(zigzag & 1)));
+    samples[count++] = value;
+  }
+  return count;
+}
+
+}
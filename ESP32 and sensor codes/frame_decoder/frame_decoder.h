@@ -0,0 +1,106 @@
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "../FinalIntegration/frame_protocol.h"
+
+// Frame payloads and text lines (longer lines are split)
+const size_t kFrameEventDataSize = 256;
+static_assert(kFrameEventDataSize >= kFrameMaxPayload, "frame payload does not fit into an event");
+
+/**
+ * @brief Event produced by the decoder
+ */
+struct FrameEvent {
+  uint8_t kind;                      //!< FRAME_EVENT_FRAME or FRAME_EVENT_TEXT
+  uint8_t type;                      //!< Frame type (frames only)
+  uint8_t seq;                       //!< Sequence number (frames only)
+  uint16_t length;                   //!< Number of bytes in data
+  uint8_t data[kFrameEventDataSize]; //!< Frame payload or text line without line ending
+};
+
+const uint8_t FRAME_EVENT_FRAME = 0;
+const uint8_t FRAME_EVENT_TEXT = 1;
+
+/**
+ * @brief Host side decoder for the frames of frame_protocol.h
+ * @remark Bytes outside of frames are collected into text lines. After a CRC
+ * error the decoder resynchronizes on the next sync bytes. Text never shares a
+ * line with a frame, so a partial line is dropped when a frame starts, and so is
+ * text made of the bytes of a rejected frame.
+ */
+class FrameDecoder {
+  enum State { SYNC0, SYNC1, HEADER, PAYLOAD, CRC };
+
+  State state_;
+  std::vector<uint8_t> frame_;
+  std::vector<uint8_t> text_;
+  std::deque<uint8_t> input_;
+  size_t rescan_; // Bytes at the front of input_ that belonged to a rejected frame
+  std::deque<FrameEvent> events_;
+  bool have_seq_;
+  uint8_t next_seq_;
+  unsigned long crc_errors_;
+  unsigned long lost_frames_;
+
+  void process(uint8_t byte);
+  void text(uint8_t byte);
+  void finishFrame();
+  void resync();
+public:
+  FrameDecoder();
+
+  /**
+   * @brief Feed received bytes
+   * @param data Received bytes
+   * @param length Number of bytes
+   */
+  void feed(const uint8_t* data, size_t length);
+
+  /**
+   * @brief Get the next decoded event
+   * @param event Reference to store the event in
+   * @return true if an event was available, otherwise false
+   */
+  bool next(FrameEvent& event);
+
+  /**
+   * @brief Get number of frames dropped because of a CRC error
+   * @return Number of CRC errors
+   */
+  unsigned long crcErrors() const { return crc_errors_; }
+
+  /**
+   * @brief Get number of frames missing according to the sequence numbers
+   * @return Number of lost frames
+   */
+  unsigned long lostFrames() const { return lost_frames_; }
+};
+
+// C interface, used by the Python binding
+extern "C" {
+void* frame_decoder_create(void);
+void frame_decoder_destroy(void* decoder);
+void frame_decoder_feed(void* decoder, const uint8_t* data, size_t length);
+int frame_decoder_next(void* decoder, struct FrameEvent* event);
+unsigned long frame_decoder_crc_errors(void* decoder);
+unsigned long frame_decoder_lost_frames(void* decoder);
+
+/**
+ * @brief Decode a FRAME_ECG_SAMPLES payload
+ * @param payload Frame payload
+ * @param length Payload length
+ * @param first_index Index of the first sample
+ * @param samples Output buffer
+ * @param max_samples Size of the output buffer
+ * @return Number of decoded samples
+ */
+size_t frame_decode_ecg(const uint8_t* payload, size_t length, uint32_t* first_index,
+                        int16_t* samples, size_t max_samples);
+
+}
+
+#endif // FRAME_DECODER_H
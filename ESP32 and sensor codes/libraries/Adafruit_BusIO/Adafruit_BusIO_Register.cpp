@@ -116,6 +116,7 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
  * uncheckable)
  */
 bool Adafruit_BusIO_Register::write(uint8_t *buffer, uint8_t len) {
+  _shadowValid = false;
   uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
                            (uint8_t)(_address >> 8)};
   if (_i2cdevice) {
@@ -177,15 +178,21 @@ bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
     }
     value >>= 8;
   }
-  return write(_buffer, numbytes);
+  bool ok = write(_buffer, numbytes);
+  _shadowValid = ok && (numbytes == _width);
+  return ok;
 }
 
 /*!
  *    @brief  Read data from the register location. This does not do any error
- * checking!
+ * checking! With enableShadow() the bus is only read the first time.
  *    @return Returns 0xFFFFFFFF on failure, value otherwise
  */
 uint32_t Adafruit_BusIO_Register::read(void) {
+  if (_shadow && _shadowValid) {
+    return _cached;
+  }
+
   if (!read(_buffer, _width)) {
     return -1;
   }
@@ -201,6 +208,10 @@ uint32_t Adafruit_BusIO_Register::read(void) {
     }
   }
 
+  if (_shadow) {
+    _cached = value;
+    _shadowValid = true;
+  }
   return value;
 }
 
@@ -210,6 +221,24 @@ uint32_t Adafruit_BusIO_Register::read(void) {
  */
 uint32_t Adafruit_BusIO_Register::readCached(void) { return _cached; }
 
+/*!
+ *    @brief  Keep a write-through copy of the register value. read() then only
+ * touches the bus the first time, so Adafruit_BusIO_RegisterBits::write() turns
+ * into a single bus write. Only for registers the device never changes by
+ * itself, such as configuration registers.
+ *    @param  enable True to use the copy, false to always read the device
+ */
+void Adafruit_BusIO_Register::enableShadow(bool enable) {
+  _shadow = enable;
+  _shadowValid = false;
+}
+
+/*!
+ *    @brief  Forget the shadow copy, the next read() goes to the device again.
+ * Call after the device was reset.
+ */
+void Adafruit_BusIO_Register::invalidateShadow(void) { _shadowValid = false; }
+
 /*!
    @brief Read a number of bytes from a register into a buffer
    @param buffer Buffer to read data into
@@ -363,7 +392,10 @@ uint8_t Adafruit_BusIO_Register::width(void) { return _width; }
  *    @brief  Set the default width of data
  *    @param width the default width of data read from register
  */
-void Adafruit_BusIO_Register::setWidth(uint8_t width) { _width = width; }
+void Adafruit_BusIO_Register::setWidth(uint8_t width) {
+  _width = width;
+  _shadowValid = false;
+}
 
 /*!
  *    @brief  Set register address
@@ -371,6 +403,7 @@ void Adafruit_BusIO_Register::setWidth(uint8_t width) { _width = width; }
  */
 void Adafruit_BusIO_Register::setAddress(uint16_t address) {
   _address = address;
+  _shadowValid = false;
 }
 
 /*!
@@ -68,6 +68,8 @@ public:
   bool read(uint16_t *value);
   uint32_t read(void);
   uint32_t readCached(void);
+  void enableShadow(bool enable = true);
+  void invalidateShadow(void);
   bool write(uint8_t *buffer, uint8_t len);
   bool write(uint32_t value, uint8_t numbytes = 0);
 
@@ -90,6 +92,8 @@ private:
   uint8_t _buffer[4]; // we won't support anything larger than uint32 for
                       // non-buffered read
   uint32_t _cached = 0;
+  bool _shadow = false;      // read() answers from _cached once it is known
+  bool _shadowValid = false; // _cached matches the device register
 };
 
 /*!
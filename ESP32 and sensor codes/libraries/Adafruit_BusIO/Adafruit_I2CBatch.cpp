@@ -0,0 +1,175 @@
+#include "Adafruit_I2CBatch.h"
+
+/*!
+ *    @brief  Create a batch for an I2C device
+ *    @param  i2cdevice The I2CDevice to use for the bus transactions
+ *    @param  address_width The width of the register address itself, defaults
+ * to 1 byte
+ */
+Adafruit_I2CBatch::Adafruit_I2CBatch(Adafruit_I2CDevice *i2cdevice,
+                                     uint8_t address_width) {
+  _i2cdevice = i2cdevice;
+  _addrwidth = address_width;
+  clear();
+}
+
+/*!
+ *    @brief  Queue a write of a buffer starting at a register. If the queue is
+ * full the pending operations are flushed first. A write that repeats the
+ * registers of the write right before it replaces the queued value, only the
+ * last value is sent. Call flush() in between when the device has to see
+ * every value, e.g. a reset bit followed by the configuration.
+ *    @param  reg_addr The first register to write
+ *    @param  buffer Pointer to data to write, copied right away
+ *    @param  len Number of bytes to write
+ *    @return False if the data can never fit into one write or an automatic
+ * flush failed
+ */
+bool Adafruit_I2CBatch::write(uint16_t reg_addr, const uint8_t *buffer,
+                              uint8_t len) {
+  if ((len == 0) || (len > BUSIO_BATCH_BUFFER_SIZE) ||
+      ((size_t)(len + _addrwidth) > _i2cdevice->maxBufferSize())) {
+    return false;
+  }
+
+  if (_count > 0) {
+    Operation &last = _ops[_count - 1];
+
+    // Replace the value of the write just before this one. Only its own
+    // registers at the end of the last operation are replaced, anything
+    // queued after an earlier value would otherwise reach the device first.
+    if (!last.buffer && (reg_addr >= _lastreg) &&
+        (reg_addr + len == last.reg + last.len)) {
+      memcpy(_data + _datalen - len, buffer, len);
+      _lastreg = reg_addr;
+      return true;
+    }
+
+    // Extend the last write if the registers follow on, its data is at the
+    // end of _data
+    if (!last.buffer && (last.reg + last.len == reg_addr) &&
+        (_datalen + len <= BUSIO_BATCH_BUFFER_SIZE) &&
+        ((size_t)(last.len + len + _addrwidth) <=
+         _i2cdevice->maxBufferSize())) {
+      memcpy(_data + _datalen, buffer, len);
+      _datalen += len;
+      last.len += len;
+      _lastreg = reg_addr;
+      return true;
+    }
+  }
+
+  if ((_count == BUSIO_BATCH_MAX_OPS) ||
+      (_datalen + len > BUSIO_BATCH_BUFFER_SIZE)) {
+    if (!flush()) {
+      return false;
+    }
+  }
+
+  Operation &op = _ops[_count++];
+  op.reg = reg_addr;
+  op.len = len;
+  op.offset = _datalen;
+  op.buffer = nullptr;
+  memcpy(_data + _datalen, buffer, len);
+  _datalen += len;
+  _lastreg = reg_addr;
+  return true;
+}
+
+/*!
+ *    @brief  Queue a write of one byte to a register
+ *    @param  reg_addr The register to write
+ *    @param  value The byte to write
+ *    @return False if an automatic flush failed
+ */
+bool Adafruit_I2CBatch::write(uint16_t reg_addr, uint8_t value) {
+  return write(reg_addr, &value, 1);
+}
+
+/*!
+ *    @brief  Queue a read starting at a register. If the queue is full the
+ * pending operations are flushed first.
+ *    @param  reg_addr The first register to read
+ *    @param  buffer Pointer to the destination, must stay valid until flush()
+ *    @param  len Number of bytes to read
+ *    @return False if an automatic flush failed
+ */
+bool Adafruit_I2CBatch::read(uint16_t reg_addr, uint8_t *buffer,
+                             uint8_t len) {
+  if ((len == 0) || (buffer == nullptr)) {
+    return false;
+  }
+
+  if (_count == BUSIO_BATCH_MAX_OPS) {
+    if (!flush()) {
+      return false;
+    }
+  }
+
+  Operation &op = _ops[_count++];
+  op.reg = reg_addr;
+  op.len = len;
+  op.offset = 0;
+  op.buffer = buffer;
+  return true;
+}
+
+/*!
+ *    @brief  Send the queued operations in order. Reads of consecutive
+ * registers are done with one write_then_read().
+ *    @return True if every transaction succeeded. The queue is empty
+ * afterwards either way, the remaining operations are dropped after the first
+ * failure.
+ */
+bool Adafruit_I2CBatch::flush(void) {
+  bool ok = true;
+  uint8_t i = 0;
+  while (ok && (i < _count)) {
+    const Operation &op = _ops[i];
+    uint8_t addrbuffer[2] = {(uint8_t)(op.reg & 0xFF), (uint8_t)(op.reg >> 8)};
+
+    if (!op.buffer) {
+      ok = _i2cdevice->write(_data + op.offset, op.len, true, addrbuffer,
+                             _addrwidth);
+      i++;
+      continue;
+    }
+
+    // Collect the reads that continue where this one ends
+    uint8_t end = i + 1;
+    size_t len = op.len;
+    while ((end < _count) && _ops[end].buffer &&
+           (_ops[end].reg == op.reg + len) &&
+           (len + _ops[end].len <= BUSIO_BATCH_BUFFER_SIZE)) {
+      len += _ops[end].len;
+      end++;
+    }
+
+    if (end == i + 1) {
+      ok = _i2cdevice->write_then_read(addrbuffer, _addrwidth, op.buffer,
+                                       op.len);
+    } else {
+      uint8_t merged[BUSIO_BATCH_BUFFER_SIZE];
+      ok = _i2cdevice->write_then_read(addrbuffer, _addrwidth, merged, len);
+      size_t pos = 0;
+      for (uint8_t j = i; ok && (j < end); j++) {
+        memcpy(_ops[j].buffer, merged + pos, _ops[j].len);
+        pos += _ops[j].len;
+      }
+    }
+    i = end;
+  }
+
+  clear();
+  return ok;
+}
+
+/*!
+ *    @brief  Drop all queued operations without sending them
+ */
+void Adafruit_I2CBatch::clear(void) {
+  _count = 0;
+  _datalen = 0;
+  _lastreg = 0;
+}
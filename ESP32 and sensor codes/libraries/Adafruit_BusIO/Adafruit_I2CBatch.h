@@ -0,0 +1,54 @@
+#ifndef Adafruit_I2CBatch_h
+#define Adafruit_I2CBatch_h
+
+#include <Adafruit_I2CDevice.h>
+#include <Arduino.h>
+
+#ifndef BUSIO_BATCH_MAX_OPS
+#define BUSIO_BATCH_MAX_OPS 16 ///< Reads and writes held before a flush
+#endif
+
+#ifndef BUSIO_BATCH_BUFFER_SIZE
+#define BUSIO_BATCH_BUFFER_SIZE 32 ///< Bytes of queued write data
+#endif
+
+/*!
+ * @brief Queues register reads and writes for one I2C device and sends them
+ * with as few bus transactions as possible. Writes to consecutive registers
+ * become one auto-increment write, reads of consecutive registers one burst
+ * read, and a write that repeats the registers of the write right before it
+ * replaces the queued value, so the device only sees the last one. Writes are
+ * never reordered. Nothing is sent before flush().
+ */
+class Adafruit_I2CBatch {
+public:
+  Adafruit_I2CBatch(Adafruit_I2CDevice *i2cdevice, uint8_t address_width = 1);
+
+  bool write(uint16_t reg_addr, const uint8_t *buffer, uint8_t len);
+  bool write(uint16_t reg_addr, uint8_t value);
+  bool read(uint16_t reg_addr, uint8_t *buffer, uint8_t len);
+  bool flush(void);
+  void clear(void);
+
+  /*!   @brief  Number of queued operations after merging
+   *    @return The number of bus transactions flush() needs at most */
+  uint8_t pending(void) { return _count; }
+
+private:
+  struct Operation {
+    uint16_t reg;    ///< First register
+    uint8_t len;     ///< Number of bytes
+    uint8_t offset;  ///< Position of the write data in _data
+    uint8_t *buffer; ///< Destination of a read, nullptr for a write
+  };
+
+  Adafruit_I2CDevice *_i2cdevice;
+  uint8_t _addrwidth;
+  Operation _ops[BUSIO_BATCH_MAX_OPS];
+  uint8_t _count;
+  uint8_t _data[BUSIO_BATCH_BUFFER_SIZE];
+  uint8_t _datalen;
+  uint16_t _lastreg; ///< First register of the most recent write
+};
+
+#endif // Adafruit_I2CBatch_h
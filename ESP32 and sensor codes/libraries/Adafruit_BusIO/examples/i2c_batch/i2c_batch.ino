@@ -0,0 +1,52 @@
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_I2CBatch.h>
+#include <Adafruit_I2CDevice.h>
+
+// MAX30102 pulse oximeter
+#define I2C_ADDRESS 0x57
+Adafruit_I2CDevice i2c_dev = Adafruit_I2CDevice(I2C_ADDRESS);
+Adafruit_I2CBatch batch = Adafruit_I2CBatch(&i2c_dev);
+
+// Only written by us, so the value can be kept instead of read back
+Adafruit_BusIO_Register spo2_config = Adafruit_BusIO_Register(&i2c_dev, 0x0A);
+Adafruit_BusIO_RegisterBits adc_range =
+    Adafruit_BusIO_RegisterBits(&spo2_config, 2, 5);
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("I2C batch test");
+
+  if (!i2c_dev.begin()) {
+    Serial.print("Did not find device at 0x");
+    Serial.println(i2c_dev.address(), HEX);
+    while (1)
+      ;
+  }
+
+  spo2_config.enableShadow();
+  adc_range.write(3); // one read and one write
+  adc_range.write(2); // one write
+
+  // Red and IR LED current, sent as one write
+  batch.write(0x0C, 0x24);
+  batch.write(0x0D, 0x24);
+  batch.flush();
+}
+
+void loop() {
+  // FIFO write pointer, overflow counter and read pointer in one read
+  uint8_t write_ptr, overflow, read_ptr;
+  batch.read(0x04, &write_ptr, 1);
+  batch.read(0x05, &overflow, 1);
+  batch.read(0x06, &read_ptr, 1);
+  if (batch.flush()) {
+    Serial.print("Samples in FIFO: ");
+    Serial.print((write_ptr - read_ptr) & 0x1F);
+    Serial.print(", lost: ");
+    Serial.println(overflow);
+  }
+  delay(500);
+}
@@ -34,7 +34,19 @@ bool Adafruit_MLX90614::begin(uint8_t addr, TwoWire *wire) {
   if (i2c_dev)
     delete i2c_dev;
   i2c_dev = new Adafruit_I2CDevice(addr, wire);
-  return i2c_dev->begin();
+  if (!i2c_dev->begin())
+    return false;
+
+  // The filters set how often the RAM registers are refreshed
+  uint16_t config;
+  if (read16(MLX90614_CONFIG, &config)) {
+    // One measurement takes about 100 ms with the default FIR length of 1024
+    // and scales with it
+    uint16_t fir = 8 << ((config >> 8) & 0x7);
+    _updatePeriod = max(10, MLX90614_DEFAULT_UPDATE_PERIOD * fir / 1024);
+  }
+  _hasReading = false;
+  return true;
 }
 
 /**
@@ -114,28 +126,111 @@ double Adafruit_MLX90614::readAmbientTempC(void) {
   return readTemp(MLX90614_TA);
 }
 
+/**
+ * @brief Read object and ambient temperature in one pass, unless the sensor
+ * has not refreshed them since the last pass. Both words are checked against
+ * their PEC, the previous values are kept if either fails.
+ *
+ * @param force Read even if the update period has not passed yet
+ * @return True if new values were read, false if the last ones are still
+ * current or the read failed
+ */
+bool Adafruit_MLX90614::performReading(bool force) {
+  uint32_t now = millis();
+  if (!force && _hasReading && (now - _lastReading < _updatePeriod))
+    return false;
+
+  float object, ambient;
+  if (!readTemp(MLX90614_TOBJ1, &object) || !readTemp(MLX90614_TA, &ambient))
+    return false;
+
+  _object = object;
+  _ambient = ambient;
+  _lastReading = now;
+  _hasReading = true;
+  return true;
+}
+
+/**
+ * @brief Get the object temperature of the last performReading()
+ *
+ * @return double The temperature in degrees Celcius or NAN before the first
+ * successful performReading()
+ */
+double Adafruit_MLX90614::getObjectTempC(void) { return _object; }
+
+/**
+ * @brief Get the ambient temperature of the last performReading()
+ *
+ * @return double The temperature in degrees Celcius or NAN before the first
+ * successful performReading()
+ */
+double Adafruit_MLX90614::getAmbientTempC(void) { return _ambient; }
+
+/**
+ * @brief Set how often performReading() reads the sensor. begin() derives it
+ * from the FIR length in the configuration register.
+ *
+ * @param ms Time between two reads in ms
+ */
+void Adafruit_MLX90614::setUpdatePeriod(uint16_t ms) { _updatePeriod = ms; }
+
+/**
+ * @brief Get how often performReading() reads the sensor
+ *
+ * @return uint16_t Time between two reads in ms
+ */
+uint16_t Adafruit_MLX90614::getUpdatePeriod(void) { return _updatePeriod; }
+
+/**
+ * @brief Get the number of words that were dropped for a wrong PEC
+ *
+ * @return uint32_t Number of PEC errors since the start
+ */
+uint32_t Adafruit_MLX90614::getPECErrors(void) { return _pecErrors; }
+
 float Adafruit_MLX90614::readTemp(uint8_t reg) {
   float temp;
-
-  temp = read16(reg);
-  if (temp == 0)
+  if (!readTemp(reg, &temp))
     return NAN;
-  temp *= .02;
-  temp -= 273.15;
   return temp;
 }
 
+bool Adafruit_MLX90614::readTemp(uint8_t reg, float *temp) {
+  uint16_t raw;
+  // The MSB flags an error of the measurement
+  if (!read16(reg, &raw) || (raw == 0) || (raw & 0x8000))
+    return false;
+  *temp = raw * .02 - 273.15;
+  return true;
+}
+
 /*********************************************************************/
 
 uint16_t Adafruit_MLX90614::read16(uint8_t a) {
+  uint16_t value;
+  if (!read16(a, &value))
+    return 0;
+  return value;
+}
+
+bool Adafruit_MLX90614::read16(uint8_t a, uint16_t *value) {
   uint8_t buffer[3];
   buffer[0] = a;
   // read two bytes of data + pec
   bool status = i2c_dev->write_then_read(buffer, 1, buffer, 3);
   if (!status)
-    return 0;
-  // return data, ignore pec
-  return uint16_t(buffer[0]) | (uint16_t(buffer[1]) << 8);
+    return false;
+
+  // The PEC covers both addresses, the command and the data
+  uint8_t frame[5] = {(uint8_t)(_addr << 1), a, (uint8_t)((_addr << 1) | 1),
+                      buffer[0], buffer[1]};
+  if (crc8(frame, 5) != buffer[2]) {
+    _pecErrors++;
+    return false;
+  }
+  *value = uint16_t(buffer[0]) | (uint16_t(buffer[1]) << 8);
+  return true;
 }
 
 byte Adafruit_MLX90614::crc8(byte *addr, byte len)
@@ -39,6 +39,10 @@
 #define MLX90614_ID3 0x3E
 #define MLX90614_ID4 0x3F
 
+/** Update period assumed by performReading() when the configuration register
+ * cannot be read, in ms */
+#define MLX90614_DEFAULT_UPDATE_PERIOD 100
+
 /**
  * @brief Class to read from and control a MLX90614 Temp Sensor
  *
@@ -57,12 +61,28 @@ public:
   double readEmissivity(void);
   void writeEmissivity(double emissivity);
 
+  bool performReading(bool force = false);
+  double getObjectTempC(void);
+  double getAmbientTempC(void);
+  void setUpdatePeriod(uint16_t ms);
+  uint16_t getUpdatePeriod(void);
+  uint32_t getPECErrors(void);
+
 private:
   Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
   float readTemp(uint8_t reg);
+  bool readTemp(uint8_t reg, float *temp);
 
   uint16_t read16(uint8_t addr);
+  bool read16(uint8_t addr, uint16_t *value);
   void write16(uint8_t addr, uint16_t data);
   byte crc8(byte *addr, byte len);
   uint8_t _addr;
+
+  float _object = NAN;      ///< Object temperature of the last performReading()
+  float _ambient = NAN;     ///< Ambient temperature of the last performReading()
+  uint32_t _lastReading = 0; ///< millis() of the last performReading()
+  bool _hasReading = false;
+  uint16_t _updatePeriod = MLX90614_DEFAULT_UPDATE_PERIOD;
+  uint32_t _pecErrors = 0;
 };
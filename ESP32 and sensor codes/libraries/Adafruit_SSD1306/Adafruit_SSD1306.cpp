@@ -136,6 +136,17 @@
     }                                                                          \
   } ///< Wire, SPI or bitbang transfer end
 
+// With double buffering, display() and the push functions may run in tasks
+// on different cores. The front buffer, the dirty windows and the shadow are
+// only touched under this lock, the transfers themselves run without it.
+#if defined(ESP32)
+#define FRAME_LOCK portENTER_CRITICAL(&frameLock);  ///< Take the frame lock
+#define FRAME_UNLOCK portEXIT_CRITICAL(&frameLock); ///< Release it
+#else
+#define FRAME_LOCK   ///< Dummy stand-in define
+#define FRAME_UNLOCK ///< keeps compiler happy
+#endif
+
 // CONSTRUCTORS, DESTRUCTOR ------------------------------------------------
 
 /*!
@@ -175,7 +186,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi,
                                    int8_t rst_pin, uint32_t clkDuring,
                                    uint32_t clkAfter)
     : Adafruit_GFX(w, h), spi(NULL), wire(twi ? twi : &Wire), buffer(NULL),
-      mosiPin(-1), clkPin(-1), dcPin(-1), csPin(-1), rstPin(rst_pin)
+      shadow(NULL), frame(NULL), mosiPin(-1), clkPin(-1), dcPin(-1),
+      csPin(-1), rstPin(rst_pin)
 #if ARDUINO >= 157
       ,
       wireClk(clkDuring), restoreClk(clkAfter)
@@ -214,8 +226,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, int8_t mosi_pin,
                                    int8_t sclk_pin, int8_t dc_pin,
                                    int8_t rst_pin, int8_t cs_pin)
     : Adafruit_GFX(w, h), spi(NULL), wire(NULL), buffer(NULL),
-      mosiPin(mosi_pin), clkPin(sclk_pin), dcPin(dc_pin), csPin(cs_pin),
-      rstPin(rst_pin) {}
+      shadow(NULL), frame(NULL), mosiPin(mosi_pin), clkPin(sclk_pin),
+      dcPin(dc_pin), csPin(cs_pin), rstPin(rst_pin) {}
 
 /*!
     @brief  Constructor for SPI SSD1306 displays, using native hardware SPI.
@@ -247,8 +259,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, SPIClass *spi_ptr,
                                    int8_t dc_pin, int8_t rst_pin, int8_t cs_pin,
                                    uint32_t bitrate)
     : Adafruit_GFX(w, h), spi(spi_ptr ? spi_ptr : &SPI), wire(NULL),
-      buffer(NULL), mosiPin(-1), clkPin(-1), dcPin(dc_pin), csPin(cs_pin),
-      rstPin(rst_pin) {
+      buffer(NULL), shadow(NULL), frame(NULL), mosiPin(-1), clkPin(-1),
+      dcPin(dc_pin), csPin(cs_pin), rstPin(rst_pin) {
 #ifdef SPI_HAS_TRANSACTION
   spiSettings = SPISettings(bitrate, MSBFIRST, SPI_MODE0);
 #endif
@@ -283,8 +295,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, SPIClass *spi_ptr,
 Adafruit_SSD1306::Adafruit_SSD1306(int8_t mosi_pin, int8_t sclk_pin,
                                    int8_t dc_pin, int8_t rst_pin, int8_t cs_pin)
     : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT), spi(NULL), wire(NULL),
-      buffer(NULL), mosiPin(mosi_pin), clkPin(sclk_pin), dcPin(dc_pin),
-      csPin(cs_pin), rstPin(rst_pin) {}
+      buffer(NULL), shadow(NULL), frame(NULL), mosiPin(mosi_pin),
+      clkPin(sclk_pin), dcPin(dc_pin), csPin(cs_pin), rstPin(rst_pin) {}
 
 /*!
     @brief  DEPRECATED constructor for SPI SSD1306 displays, using native
@@ -309,8 +321,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t mosi_pin, int8_t sclk_pin,
 */
 Adafruit_SSD1306::Adafruit_SSD1306(int8_t dc_pin, int8_t rst_pin, int8_t cs_pin)
     : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT), spi(&SPI), wire(NULL),
-      buffer(NULL), mosiPin(-1), clkPin(-1), dcPin(dc_pin), csPin(cs_pin),
-      rstPin(rst_pin) {
+      buffer(NULL), shadow(NULL), frame(NULL), mosiPin(-1), clkPin(-1),
+      dcPin(dc_pin), csPin(cs_pin), rstPin(rst_pin) {
 #ifdef SPI_HAS_TRANSACTION
   spiSettings = SPISettings(8000000, MSBFIRST, SPI_MODE0);
 #endif
@@ -332,8 +344,8 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t dc_pin, int8_t rst_pin, int8_t cs_pin)
 */
 Adafruit_SSD1306::Adafruit_SSD1306(int8_t rst_pin)
     : Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT), spi(NULL), wire(&Wire),
-      buffer(NULL), mosiPin(-1), clkPin(-1), dcPin(-1), csPin(-1),
-      rstPin(rst_pin) {}
+      buffer(NULL), shadow(NULL), frame(NULL), mosiPin(-1), clkPin(-1),
+      dcPin(-1), csPin(-1), rstPin(rst_pin) {}
 
 /*!
     @brief  Destructor for Adafruit_SSD1306 object.
@@ -343,6 +355,14 @@ Adafruit_SSD1306::~Adafruit_SSD1306(void) {
     free(buffer);
     buffer = NULL;
   }
+  if (shadow) {
+    free(shadow);
+    shadow = NULL;
+  }
+  if (frame) {
+    free(frame);
+    frame = NULL;
+  }
 }
 
 // LOW-LEVEL UTILS ---------------------------------------------------------
@@ -498,6 +518,13 @@ bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset,
   if ((!buffer) && !(buffer = (uint8_t *)malloc(WIDTH * ((HEIGHT + 7) / 8))))
     return false;
 
+#ifndef SSD1306_NO_SHADOW
+  // Optional, without it display() sends the dirty windows as they are
+  if (!shadow)
+    shadow = (uint8_t *)malloc(WIDTH * ((HEIGHT + 7) / 8));
+#endif
+
+  markDirty(); // Whatever the panel shows after power up or reset
   clearDisplay();
 
 #ifndef SSD1306_NO_SPLASH
@@ -658,6 +685,7 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
       y = HEIGHT - y - 1;
       break;
     }
+    markDirty(y / 8, x, x);
     switch (color) {
     case SSD1306_WHITE:
       buffer[x + (y / 8) * WIDTH] |= (1 << (y & 7));
@@ -681,6 +709,45 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
 */
 void Adafruit_SSD1306::clearDisplay(void) {
   memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+  for (uint8_t page = 0; page < (HEIGHT + 7) / 8; page++)
+    markDirty(page, 0, WIDTH - 1);
+}
+
+/*!
+    @brief  Forget what the panel shows, so that the next display() pushes
+            the whole buffer.
+    @return None (void).
+    @note   Call after writing to the buffer from getBuffer() directly, or
+            after the panel RAM was changed in any other way.
+*/
+void Adafruit_SSD1306::markDirty(void) {
+  FRAME_LOCK
+  for (uint8_t page = 0; page < (HEIGHT + 7) / 8; page++) {
+    dirtyLo[page] = drawnLo[page] = 0;
+    dirtyHi[page] = drawnHi[page] = WIDTH - 1;
+  }
+  shadowPages = 0;
+  FRAME_UNLOCK
+}
+
+/*!
+    @brief  Add columns of a page to the area the next display() pushes.
+    @param  page
+            Page (row of 8 pixels) of the change.
+    @param  first
+            First changed column.
+    @param  last
+            Last changed column.
+    @return None (void).
+*/
+void Adafruit_SSD1306::markDirty(uint8_t page, uint8_t first, uint8_t last) {
+  // Double buffered, the drawing is pushed after the next display()
+  uint8_t *lo = frame ? drawnLo : dirtyLo;
+  uint8_t *hi = frame ? drawnHi : dirtyHi;
+  if (first < lo[page])
+    lo[page] = first;
+  if (last > hi[page])
+    hi[page] = last;
 }
 
 /*!
@@ -760,6 +827,7 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w,
       w = (WIDTH - x);
     }
     if (w > 0) { // Proceed only if width is positive
+      markDirty(y / 8, x, x + w - 1);
       uint8_t *pBuf = &buffer[(y / 8) * WIDTH + x], mask = 1 << (y & 7);
       switch (color) {
       case SSD1306_WHITE:
@@ -863,6 +931,8 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
       // use local byte registers for faster juggling
       uint8_t y = __y, h = __h;
       uint8_t *pBuf = &buffer[(y / 8) * WIDTH + x];
+      for (uint8_t page = y / 8; page <= (y + h - 1) / 8; page++)
+        markDirty(page, x, x);
 
       // do the first partial byte, if necessary - this requires some masking
       uint8_t mod = (y & 7);
@@ -991,8 +1061,73 @@ uint8_t *Adafruit_SSD1306::getBuffer(void) { return buffer; }
     @note   Drawing operations are not visible until this function is
             called. Call after each graphics command, or after a whole set
             of graphics commands, as best needed by one's own application.
+            When double buffered (see setDoubleBuffer()) the changes are
+            only copied to the front buffer, which flush() or
+            displayChunk() push from another task, and the call returns
+            right away.
 */
 void Adafruit_SSD1306::display(void) {
+  if (!frame) {
+    flush();
+    return;
+  }
+
+  FRAME_LOCK
+  for (uint8_t page = 0; page < (HEIGHT + 7) / 8; page++) {
+    uint8_t first = drawnLo[page], last = drawnHi[page];
+    if (first > last)
+      continue;
+    memcpy(frame + page * WIDTH + first, buffer + page * WIDTH + first,
+           last - first + 1);
+    if (first < dirtyLo[page])
+      dirtyLo[page] = first;
+    if (last > dirtyHi[page])
+      dirtyHi[page] = last;
+    drawnLo[page] = 0xFF;
+    drawnHi[page] = 0;
+  }
+  FRAME_UNLOCK
+}
+
+/*!
+    @brief  Push the frame to the SSD1306 and wait for the transfer. This is
+            display() for a single buffered display, double buffered it
+            pushes the front buffer.
+    @return None (void).
+    @note   Only the columns changed since the last push are sent, each
+            page in its own address window. The whole buffer goes out in
+            one transfer when everything is dirty and there is nothing to
+            compare with.
+*/
+void Adafruit_SSD1306::flush(void) {
+  uint8_t pages = (HEIGHT + 7) / 8;
+  uint16_t count = WIDTH * pages;
+  uint8_t *ptr = frame ? frame : buffer;
+  bool whole = true;
+  FRAME_LOCK
+  for (uint8_t page = 0; whole && (page < pages); page++) {
+    whole = (dirtyLo[page] == 0) && (dirtyHi[page] == WIDTH - 1) &&
+            !(shadow && (shadowPages & (1 << page)));
+  }
+  if (whole) {
+    // Drawing from here on is pushed by the next call
+    for (uint8_t page = 0; page < pages; page++) {
+      dirtyLo[page] = 0xFF;
+      dirtyHi[page] = 0;
+    }
+    if (shadow) {
+      memcpy(shadow, ptr, count);
+      shadowPages = 0xFF;
+      ptr = shadow;
+    }
+  }
+  FRAME_UNLOCK
+  if (!whole) {
+    for (uint16_t offset = 0; offset < count;)
+      offset = displayChunk(offset, count);
+    return;
+  }
+
   TRANSACTION_START
   static const uint8_t PROGMEM dlist1[] = {
       SSD1306_PAGEADDR,
@@ -1011,8 +1146,6 @@ void Adafruit_SSD1306::display(void) {
   // 32-byte transfer condition below.
   yield();
 #endif
-  uint16_t count = WIDTH * ((HEIGHT + 7) / 8);
-  uint8_t *ptr = buffer;
   if (wire) { // I2C
     wire->beginTransmission(i2caddr);
     WIRE_WRITE((uint8_t)0x40);
@@ -1039,6 +1172,172 @@ void Adafruit_SSD1306::display(void) {
 #endif
 }
 
+/*!
+    @brief  Push the next changed part of the frame to the SSD1306, so that
+            other devices on the same bus can be served between the parts
+            of a frame. Call with the returned offset until the buffer size
+            is returned.
+    @param  offset
+            Buffer position to continue from (page * WIDTH + column), 0 to
+            start a frame. Pages before it are not looked at.
+    @param  count
+            Maximum number of bytes to push. A part never crosses the end of
+            a page, so fewer bytes may be sent.
+    @return Offset of the next part, the buffer size once nothing is left to
+            push.
+    @note   Columns outside the dirty windows are skipped, and with a shadow
+            so are bytes the panel already shows. Double buffered, the
+            front buffer is pushed.
+*/
+uint16_t Adafruit_SSD1306::displayChunk(uint16_t offset, uint16_t count) {
+  uint8_t pages = (HEIGHT + 7) / 8;
+  uint16_t next = WIDTH * pages;
+  if (offset >= next || count == 0)
+    return next;
+
+  uint8_t page, first = 0, last = 0;
+  const uint8_t *data = NULL;
+  FRAME_LOCK
+  for (page = offset / WIDTH; page < pages; page++) {
+    first = dirtyLo[page];
+    last = dirtyHi[page];
+    if (first > last)
+      continue;
+
+    uint8_t *ptr = (frame ? frame : buffer) + page * WIDTH;
+    if (shadow && (shadowPages & (1 << page))) {
+      // Trim the window to the bytes that differ from the panel
+      uint8_t *shown = shadow + page * WIDTH;
+      while ((first < last) && (ptr[first] == shown[first]))
+        first++;
+      while ((last > first) && (ptr[last] == shown[last]))
+        last--;
+      if (ptr[first] == shown[first]) {
+        dirtyLo[page] = 0xFF;
+        dirtyHi[page] = 0;
+        continue;
+      }
+    }
+    if (last - first >= count)
+      last = first + count - 1;
+
+    // The rest of the window is pushed by the next call
+    if (last < dirtyHi[page]) {
+      dirtyLo[page] = last + 1;
+    } else {
+      dirtyLo[page] = 0xFF;
+      dirtyHi[page] = 0;
+      shadowPages |= 1 << page; // The whole window went out since markDirty()
+    }
+    if (shadow) {
+      memcpy(shadow + page * WIDTH + first, ptr + first, last - first + 1);
+      ptr = shadow + page * WIDTH;
+    }
+    data = ptr + first;
+    next = page * WIDTH + last + 1;
+    break;
+  }
+  FRAME_UNLOCK
+
+  if (data)
+    sendWindow(page, first, last, data);
+  return next;
+}
+
+/*!
+    @brief  Switch double buffering on or off. Drawing always goes to the
+            buffer returned by getBuffer(). Double buffered, display() copies
+            the changes to a second, front buffer and returns, and flush()
+            or displayChunk() push the front buffer from another task. The
+            drawing task then never waits for the bus and never races with a
+            transfer.
+    @param  enable
+            true to allocate the front buffer, false to free it.
+    @return true on success, false if the front buffer could not be
+            allocated (the display stays single buffered).
+    @note   Call after begin(). Until display() the front buffer keeps the
+            frame from before.
+*/
+bool Adafruit_SSD1306::setDoubleBuffer(bool enable) {
+  uint8_t pages = (HEIGHT + 7) / 8;
+  if (enable && !frame) {
+    uint8_t *front = (uint8_t *)malloc(WIDTH * pages);
+    if (!front)
+      return false;
+    FRAME_LOCK
+    memcpy(front, buffer, WIDTH * pages);
+    for (uint8_t page = 0; page < pages; page++) {
+      drawnLo[page] = 0xFF;
+      drawnHi[page] = 0;
+    }
+    frame = front;
+    FRAME_UNLOCK
+  } else if (!enable && frame) {
+    FRAME_LOCK
+    uint8_t *front = frame;
+    frame = NULL;
+    // The buffer only differs from the front buffer in the drawn windows
+    for (uint8_t page = 0; page < pages; page++) {
+      if (drawnLo[page] <= drawnHi[page])
+        markDirty(page, drawnLo[page], drawnHi[page]);
+    }
+    FRAME_UNLOCK
+    free(front);
+  }
+  return true;
+}
+
+/*!
+    @brief  Push columns of one page to the SSD1306.
+    @param  page
+            Page (row of 8 pixels) to write.
+    @param  first
+            First column.
+    @param  last
+            Last column.
+    @param  data
+            last - first + 1 bytes for the columns.
+    @return None (void).
+*/
+void Adafruit_SSD1306::sendWindow(uint8_t page, uint8_t first, uint8_t last,
+                                  const uint8_t *data) {
+  // Address window of exactly this part, the GDDRAM pointer wraps inside it
+  uint8_t window[] = {SSD1306_PAGEADDR,   page,  page,
+                      SSD1306_COLUMNADDR, first, last};
+  uint16_t n = last - first + 1;
+
+  TRANSACTION_START
+  if (wire) { // I2C
+    wire->beginTransmission(i2caddr);
+    WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
+    for (uint8_t i = 0; i < sizeof(window); i++)
+      WIRE_WRITE(window[i]);
+    wire->endTransmission();
+
+    wire->beginTransmission(i2caddr);
+    WIRE_WRITE((uint8_t)0x40);
+    uint16_t bytesOut = 1;
+    while (n--) {
+      if (bytesOut >= WIRE_MAX) {
+        wire->endTransmission();
+        wire->beginTransmission(i2caddr);
+        WIRE_WRITE((uint8_t)0x40);
+        bytesOut = 1;
+      }
+      WIRE_WRITE(*data++);
+      bytesOut++;
+    }
+    wire->endTransmission();
+  } else { // SPI
+    for (uint8_t i = 0; i < sizeof(window); i++)
+      ssd1306_command1(window[i]);
+    SSD1306_MODE_DATA
+    while (n--)
+      SPIwrite(*data++);
+  }
+  TRANSACTION_END
+}
+
 // SCROLLING FUNCTIONS -----------------------------------------------------
 
 /*!
@@ -1147,6 +1446,7 @@ void Adafruit_SSD1306::stopscroll(void) {
   TRANSACTION_START
   ssd1306_command1(SSD1306_DEACTIVATE_SCROLL);
   TRANSACTION_END
+  markDirty(); // Scrolling moved the panel RAM, it has to be rewritten
 }
 
 // OTHER HARDWARE SETTINGS -------------------------------------------------
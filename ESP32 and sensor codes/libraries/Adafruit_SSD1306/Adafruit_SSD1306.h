@@ -35,6 +35,13 @@
 // Uncomment to disable Adafruit splash logo
 //#define SSD1306_NO_SPLASH
 
+// Uncomment to disable the copy of the panel contents that limits display()
+// to the bytes that actually changed (costs WIDTH * HEIGHT / 8 bytes of RAM)
+//#define SSD1306_NO_SHADOW
+#if defined(__AVR__) && !defined(SSD1306_NO_SHADOW)
+#define SSD1306_NO_SHADOW ///< Too little RAM for a second frame
+#endif
+
 #if defined(ARDUINO_STM32_FEATHER)
 typedef class HardwareSPI SPIClass;
 #endif
@@ -102,6 +109,8 @@ typedef uint32_t PortMask;
 #define SSD1306_EXTERNALVCC 0x01  ///< External display voltage source
 #define SSD1306_SWITCHCAPVCC 0x02 ///< Gen. display voltage from 3.3V
 
+#define SSD1306_MAX_PAGES 8 ///< 64 rows of 8 pixels at most
+
 #define SSD1306_RIGHT_HORIZONTAL_SCROLL 0x26              ///< Init rt scroll
 #define SSD1306_LEFT_HORIZONTAL_SCROLL 0x27               ///< Init left scroll
 #define SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29 ///< Init diag scroll
@@ -150,6 +159,10 @@ public:
   bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0,
              bool reset = true, bool periphBegin = true);
   void display(void);
+  void flush(void);
+  uint16_t displayChunk(uint16_t offset, uint16_t count);
+  bool setDoubleBuffer(bool enable);
+  void markDirty(void);
   void clearDisplay(void);
   void invertDisplay(bool i);
   void dim(bool dim);
@@ -169,6 +182,9 @@ protected:
   inline void SPIwrite(uint8_t d) __attribute__((always_inline));
   void drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color);
   void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void markDirty(uint8_t page, uint8_t first, uint8_t last);
+  void sendWindow(uint8_t page, uint8_t first, uint8_t last,
+                  const uint8_t *data);
   void ssd1306_command1(uint8_t c);
   void ssd1306_commandList(const uint8_t *c, uint8_t n);
 
@@ -178,6 +194,20 @@ protected:
                    ///< Wire.cpp, Wire.h
   uint8_t *buffer; ///< Buffer data used for display buffer. Allocated when
                    ///< begin method is called.
+  uint8_t *shadow; ///< What the panel shows, NULL if SSD1306_NO_SHADOW or
+                   ///< the allocation failed.
+  uint8_t *frame;  ///< Front buffer pushed to the panel when double
+                   ///< buffered, NULL otherwise.
+  uint8_t dirtyLo[SSD1306_MAX_PAGES]; ///< First changed column of each page
+  uint8_t dirtyHi[SSD1306_MAX_PAGES]; ///< Last changed column of each page,
+                                      ///< below dirtyLo if nothing changed
+  uint8_t shadowPages; ///< Bit per page whose shadow matches the panel
+  uint8_t drawnLo[SSD1306_MAX_PAGES]; ///< First column drawn since display(),
+                                      ///< double buffered only
+  uint8_t drawnHi[SSD1306_MAX_PAGES]; ///< Last column drawn since display()
+#if defined(ESP32)
+  portMUX_TYPE frameLock = portMUX_INITIALIZER_UNLOCKED; ///< See FRAME_LOCK
+#endif
   int8_t i2caddr;  ///< I2C address initialized when begin method is called.
   int8_t vccstate; ///< VCC selection, set by begin method.
   int8_t page_end; ///< not used
@@ -28,6 +28,27 @@
     defined(ARDUINO_ARCH_STM32)   || defined(TEENSYDUINO) \
     )
 
+#if ARCH_ESPRESSIF
+// The continuous mode reads from the DOUT interrupt, the code has to be in IRAM.
+#define HX711_ISR_ATTR IRAM_ATTR
+#else
+#define HX711_ISR_ATTR
+#endif
+
+#if IS_FREE_RTOS
+// Spinlock of the continuous mode, the interrupt may run on the other core.
+#define CONTINUOUS_LOCK(mux) portENTER_CRITICAL(mux)
+#define CONTINUOUS_UNLOCK(mux) portEXIT_CRITICAL(mux)
+#define CONTINUOUS_LOCK_ISR(mux) portENTER_CRITICAL_ISR(mux)
+#define CONTINUOUS_UNLOCK_ISR(mux) portEXIT_CRITICAL_ISR(mux)
+#else
+// Interrupts are off in the interrupt already.
+#define CONTINUOUS_LOCK(mux) noInterrupts()
+#define CONTINUOUS_UNLOCK(mux) interrupts()
+#define CONTINUOUS_LOCK_ISR(mux)
+#define CONTINUOUS_UNLOCK_ISR(mux)
+#endif
+
 #if HAS_ATOMIC_BLOCK
 // Acquire AVR-specific ATOMIC_BLOCK(ATOMIC_RESTORESTATE) macro.
 #include <util/atomic.h>
@@ -40,7 +61,7 @@
 // - https://github.com/bogde/HX711/issues/75
 // - https://github.com/arduino/Arduino/issues/6561
 // - https://community.hiveeyes.org/t/using-bogdans-canonical-hx711-library-on-the-esp32/539
-uint8_t shiftInSlow(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
+HX711_ISR_ATTR uint8_t shiftInSlow(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder) {
     uint8_t value = 0;
     uint8_t i;
 
@@ -109,10 +130,7 @@ long HX711::read() {
 	// Wait for the chip to become ready.
 	wait_ready();
 
-	// Define structures for reading data into.
-	unsigned long value = 0;
-	uint8_t data[3] = { 0 };
-	uint8_t filler = 0x00;
+	long value;
 
 	// Protect the read sequence from system interrupts.  If an interrupt occurs during
 	// the time the PD_SCK signal is high it will stretch the length of the clock pulse.
@@ -144,6 +162,29 @@ long HX711::read() {
 	noInterrupts();
 	#endif
 
+	value = shift_in();
+
+	#if IS_FREE_RTOS
+	// End of critical section.
+	portEXIT_CRITICAL(&mux);
+
+	#elif HAS_ATOMIC_BLOCK
+	}
+
+	#else
+	// Enable interrupts again.
+	interrupts();
+	#endif
+
+	return value;
+}
+
+HX711_ISR_ATTR long HX711::shift_in() {
+	// Define structures for reading data into.
+	unsigned long value = 0;
+	uint8_t data[3] = { 0 };
+	uint8_t filler = 0x00;
+
 	// Pulse the clock pin 24 times to read the data.
 	data[2] = SHIFTIN_WITH_SPEED_SUPPORT(DOUT, PD_SCK, MSBFIRST);
 	data[1] = SHIFTIN_WITH_SPEED_SUPPORT(DOUT, PD_SCK, MSBFIRST);
@@ -161,18 +202,6 @@ long HX711::read() {
 		#endif
 	}
 
-	#if IS_FREE_RTOS
-	// End of critical section.
-	portEXIT_CRITICAL(&mux);
-
-	#elif HAS_ATOMIC_BLOCK
-	}
-
-	#else
-	// Enable interrupts again.
-	interrupts();
-	#endif
-
 	// Replicate the most significant bit to pad out a 32-bit signed integer
 	if (data[2] & 0x80) {
 		filler = 0xFF;
@@ -276,3 +305,129 @@ void HX711::power_down() {
 void HX711::power_up() {
 	digitalWrite(PD_SCK, LOW);
 }
+
+#if !ARCH_ESPRESSIF
+HX711* HX711::continuous_instance = NULL;
+
+HX711_ISR_ATTR void HX711::on_data_ready_instance() {
+	on_data_ready(continuous_instance);
+}
+#endif
+
+HX711_ISR_ATTR void HX711::on_data_ready(void* arg) {
+	HX711* hx711 = static_cast<HX711*>(arg);
+	CONTINUOUS_LOCK_ISR(&hx711->MUX);
+	hx711->take_reading();
+	CONTINUOUS_UNLOCK_ISR(&hx711->MUX);
+}
+
+HX711_ISR_ATTR void HX711::take_reading() {
+	// The data bits clocked out below are falling edges of DOUT as well, the interrupts
+	// they leave pending find DOUT high again once the reading is done.
+	if (!is_ready()) {
+		return;
+	}
+	long value = shift_in();
+
+	uint8_t index = HEAD & (HX711_BUFFER_SIZE - 1);
+	if (FILLED >= WINDOW) {
+		WINDOW_SUM -= BUFFER[(uint8_t)(HEAD - WINDOW) & (HX711_BUFFER_SIZE - 1)];
+	}
+	BUFFER[index] = value;
+	WINDOW_SUM += value;
+	HEAD++;
+	if (FILLED < HX711_BUFFER_SIZE) {
+		FILLED++;
+	}
+
+	// Drop the oldest reading that was not popped
+	if ((uint8_t)(HEAD - TAIL) > HX711_BUFFER_SIZE) {
+		TAIL++;
+		OVERRUNS++;
+	}
+}
+
+bool HX711::start_continuous(byte window) {
+	int interrupt = digitalPinToInterrupt(DOUT);
+	if (interrupt < 0) {
+		return false;
+	}
+	stop_continuous();
+
+	HEAD = 0;
+	TAIL = 0;
+	FILLED = 0;
+	WINDOW_SUM = 0;
+	OVERRUNS = 0;
+	WINDOW = window < 1 ? 1 : (window > HX711_BUFFER_SIZE ? HX711_BUFFER_SIZE : window);
+	CONTINUOUS = true;
+
+	#if ARCH_ESPRESSIF
+	attachInterruptArg(interrupt, on_data_ready, this, FALLING);
+	#else
+	continuous_instance = this;
+	attachInterrupt(interrupt, on_data_ready_instance, FALLING);
+	#endif
+
+	// A reading that is ready already has no falling edge left, take it here.
+	CONTINUOUS_LOCK(&MUX);
+	take_reading();
+	CONTINUOUS_UNLOCK(&MUX);
+	return true;
+}
+
+void HX711::stop_continuous() {
+	if (!CONTINUOUS) {
+		return;
+	}
+	detachInterrupt(digitalPinToInterrupt(DOUT));
+	CONTINUOUS = false;
+	#if !ARCH_ESPRESSIF
+	continuous_instance = NULL;
+	#endif
+}
+
+bool HX711::is_continuous() {
+	return CONTINUOUS;
+}
+
+byte HX711::available() {
+	CONTINUOUS_LOCK(&MUX);
+	uint8_t count = HEAD - TAIL;
+	CONTINUOUS_UNLOCK(&MUX);
+	return count;
+}
+
+bool HX711::pop(long& value) {
+	bool popped = false;
+	CONTINUOUS_LOCK(&MUX);
+	if (HEAD != TAIL) {
+		value = BUFFER[TAIL & (HX711_BUFFER_SIZE - 1)];
+		TAIL++;
+		popped = true;
+	}
+	CONTINUOUS_UNLOCK(&MUX);
+	return popped;
+}
+
+unsigned long HX711::get_overruns() {
+	CONTINUOUS_LOCK(&MUX);
+	unsigned long overruns = OVERRUNS;
+	CONTINUOUS_UNLOCK(&MUX);
+	return overruns;
+}
+
+double HX711::get_value_continuous() {
+	CONTINUOUS_LOCK(&MUX);
+	long sum = WINDOW_SUM;
+	byte count = FILLED < WINDOW ? FILLED : WINDOW;
+	CONTINUOUS_UNLOCK(&MUX);
+	if (count == 0) {
+		return 0;
+	}
+	return (double)sum / count - OFFSET;
+}
+
+float HX711::get_units_continuous() {
+	return get_value_continuous() / SCALE;
+}
@@ -16,6 +16,11 @@
 #include "WProgram.h"
 #endif
 
+// Readings kept by the continuous mode, a power of two up to 128
+#ifndef HX711_BUFFER_SIZE
+#define HX711_BUFFER_SIZE 16
+#endif
+
 class HX711
 {
 	private:
@@ -25,6 +30,30 @@ class HX711
 		long OFFSET = 0;	// used for tare weight
 		float SCALE = 1;	// used to return weight in grams, kg, ounces, whatever
 
+		// Continuous mode, filled by the data ready interrupt
+		volatile long BUFFER[HX711_BUFFER_SIZE];	// last readings
+		volatile uint8_t HEAD = 0;			// readings taken so far, wraps around
+		volatile uint8_t TAIL = 0;			// readings popped so far, wraps around
+		volatile uint8_t FILLED = 0;		// readings in BUFFER, up to HX711_BUFFER_SIZE
+		volatile long WINDOW_SUM = 0;		// sum of the last WINDOW readings
+		volatile unsigned long OVERRUNS = 0;	// readings dropped before they were popped
+		byte WINDOW = 1;					// readings averaged by get_value_continuous()
+		bool CONTINUOUS = false;
+		#if defined(ARDUINO_ARCH_ESP32)
+		portMUX_TYPE MUX = portMUX_INITIALIZER_UNLOCKED;
+		#endif
+
+		// clocks out a reading that is ready and sets the gain for the next one
+		long shift_in();
+
+		// takes a ready reading into BUFFER, called on the falling edge of DOUT
+		void take_reading();
+		static void on_data_ready(void* arg);
+		#if !(defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32))
+		static HX711* continuous_instance;
+		static void on_data_ready_instance();
+		#endif
+
 	public:
 
 		HX711();
@@ -86,6 +115,36 @@ class HX711
 
 		// wakes up the chip after power down mode
 		void power_up();
+
+		// Continuous mode: every falling edge of DOUT (data ready) clocks out the reading from an
+		// interrupt into a ring buffer of HX711_BUFFER_SIZE readings, at the full 10 or 80 SPS of the
+		// chip and without waiting in the sketch. DOUT has to be an interrupt capable pin. Other than
+		// on the ESP8266 and ESP32 only one HX711 can be in continuous mode at a time.
+		// While it runs, read() and the functions based on it must not be used.
+		// window = how many of the last readings get_value_continuous() averages, up to HX711_BUFFER_SIZE
+		// returns false if DOUT has no interrupt
+		bool start_continuous(byte window = 1);
+
+		// stops the continuous mode, the readings that were not popped are dropped
+		void stop_continuous();
+
+		// check if the continuous mode runs
+		bool is_continuous();
+
+		// number of readings that came in since the last pop()
+		byte available();
+
+		// takes the oldest reading that was not popped yet; returns false if there is none
+		bool pop(long& value);
+
+		// readings that were overwritten before pop() took them
+		unsigned long get_overruns();
+
+		// returns the average of the last window readings minus OFFSET in O(1); 0 before the first reading
+		double get_value_continuous();
+
+		// returns get_value_continuous() divided by SCALE
+		float get_units_continuous();
 };
 
 #endif /* HX711_h */
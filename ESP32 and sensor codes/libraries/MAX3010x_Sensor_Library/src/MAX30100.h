@@ -19,6 +19,8 @@ struct MAX30100Sample {
     uint16_t slot[2];   //!< Measurement Values for Slots
   };                    //!< Sample Data
   bool valid;       //!< Indicator whether this sample is valid
+  uint32_t sequence;    //!< Index of the sample since the FIFO was cleared, lost samples included
+  uint16_t lost;        //!< Number of samples lost to a FIFO overflow right before this one
 };
   
 /**
@@ -54,6 +56,7 @@ private:
   static const uint8_t INT_ST_BIT[INT_CNT];       //!< Array to map interrupts to the corresponding status bits
   
   const uint8_t nActiveSlots = 2;                 //!< Number of active LED Slots in FIFO data (always 2 for MAX30100)
+  const bool fifoRollover = false;                //!< The FIFO drops new samples when full
   
   bool setDefaultConfiguration();
   void fillSampleWithData(uint8_t data[SAMPLE_SIZE*MAX_ACTIVE_LEDS], MAX30100Sample& sample);
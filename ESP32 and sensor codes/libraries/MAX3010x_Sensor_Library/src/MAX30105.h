@@ -19,6 +19,8 @@ struct MAX30105Sample {
     uint32_t slot[4];   //!< Measurement Values for Slots
   };                    //!< Sample Data
   bool valid;           //!< Indicator whether this sample is valid
+  uint32_t sequence;    //!< Index of the sample since the FIFO was cleared, lost samples included
+  uint16_t lost;        //!< Number of samples lost to a FIFO overflow right before this one
 };
 
 /**
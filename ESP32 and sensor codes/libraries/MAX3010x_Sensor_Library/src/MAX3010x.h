@@ -23,5 +23,7 @@
 #include "MAX30101.h"
 #include "MAX30102.h"
 #include "MAX30105.h"
+#include "MAX3010x_unpack.h"
+#include "MAX3010x_gain.h"
 
 #endif
@@ -21,6 +21,14 @@ protected:
   static const uint8_t FIFO_RD_PTR_REG = MAX3010xImpl::FIFO_BASE + 2;     //!< FIFO Read Pointer Register
   static const uint8_t FIFO_DATA_REG = MAX3010xImpl::FIFO_BASE +3;        //!< FIFO Data Register
   
+#if defined(I2C_BUFFER_LENGTH) && I2C_BUFFER_LENGTH < 255
+  static const uint8_t WIRE_BUFFER_SIZE = I2C_BUFFER_LENGTH;              //!< Largest read the Wire implementation can buffer (ESP32 core)
+#elif defined(BUFFER_LENGTH) && BUFFER_LENGTH < 255
+  static const uint8_t WIRE_BUFFER_SIZE = BUFFER_LENGTH;                  //!< Largest read the Wire implementation can buffer (AVR core)
+#else
+  static const uint8_t WIRE_BUFFER_SIZE = 32;                             //!< Largest read the Wire implementation can buffer (conservative default)
+#endif
+  
   /**
    * FIFO Registers
    */
@@ -33,6 +41,11 @@ protected:
   const uint8_t _addr; //!< I2C Device Address
   TwoWire& _wire;      //!< I2C Bus Implementation
   
+  uint32_t _readCount;   //!< Samples read since the FIFO was cleared
+  uint32_t _lostCount;   //!< Samples lost since the FIFO was cleared
+  uint32_t _pendingLost; //!< Lost samples not yet assigned to a sample
+  uint32_t _gapAt;       //!< Read count of the sample that follows the pending gap
+  
   /**
    * Read Block
    * @param reg Register
@@ -177,6 +190,65 @@ protected:
     return clearFIFO();
   }
   
+  /**
+   * Number of samples between read and write pointer
+   * @param fifo FIFO Registers
+   * @return Number of samples in the FIFO
+   */
+  static uint8_t fifoCount(const FIFORegisters& fifo) {
+    if(fifo.read == fifo.write) {
+      // FIFO is completely full
+      if(fifo.overflow) {
+        return MAX3010xImpl::FIFO_SIZE;
+      }
+    }
+    return (MAX3010xImpl::FIFO_SIZE+fifo.write-fifo.read) % MAX3010xImpl::FIFO_SIZE;
+  }
+  
+  /**
+   * Record an overflow reported by the FIFO registers
+   * @param fifo FIFO Registers read before the first sample was popped
+   * @param firstRead Read count of the first sample of this read
+   * @remarks
+   * The overflow counter is cleared by the chip when a sample is popped, so this must be
+   * called once per successful read. With rollover the oldest samples were overwritten and
+   * the gap is in front of the FIFO content, so call it before stamping the samples.
+   * Otherwise new samples were discarded and the gap follows the FIFO content, call it
+   * after stamping. The counter saturates at 31, longer outages are reported as 31 lost samples.
+   */
+  void noteOverflow(const FIFORegisters& fifo, uint32_t firstRead) {
+    if(fifo.overflow == 0) return;
+    
+    if(_pendingLost == 0) {
+      _gapAt = firstRead;
+      if(!static_cast<MAX3010xImpl*>(this)->fifoRollover) _gapAt += fifoCount(fifo);
+    }
+    _pendingLost += fifo.overflow;
+  }
+  
+  /**
+   * Advance the sample sequence for a sample read from the FIFO
+   * @param lost Reference to store the number of samples lost right before this one in
+   * @return Sequence index of the sample
+   */
+  uint32_t nextSequence(uint16_t& lost) {
+    lost = 0;
+    if(_pendingLost != 0 && _readCount >= _gapAt) {
+      lost = _pendingLost > 0xFFFF ? 0xFFFF : _pendingLost;
+      _lostCount += _pendingLost;
+      _pendingLost = 0;
+    }
+    return _readCount++ + _lostCount;
+  }
+  
+  /**
+   * Assign sequence index and gap marker to a sample read from the FIFO
+   * @param sample Sample
+   */
+  void stampSample(MAX3010xSample& sample) {
+    sample.sequence = nextSequence(sample.lost);
+  }
+  
   /**
    * Constructor
    * Initializes a new sensor instance
@@ -184,7 +256,7 @@ protected:
    * @param addr Sensor Address
    * @param wire TWI bus instance
    */
-  MAX3010x(uint8_t addr, TwoWire& wire) : _addr(addr), _wire(wire) {}
+  MAX3010x(uint8_t addr, TwoWire& wire) : _addr(addr), _wire(wire), _readCount(0), _lostCount(0), _pendingLost(0), _gapAt(0) {}
 public:  
   /**
   * Initializes the I2C transport (Wire.begin()) and resets the sensor
@@ -260,9 +332,26 @@ public:
   */
   bool waitForInterrupt(uint8_t interrupt, int timeout = 100) {
     if(interrupt >= MAX3010xImpl::INT_CNT) return false;
-    return waitBit(MAX3010xImpl::INT_ST_REG[interrupt], MAX3010xImpl::INT_ST_BIT[interrupt], true, 100);
+    return waitBit(MAX3010xImpl::INT_ST_REG[interrupt], MAX3010xImpl::INT_ST_BIT[interrupt], true, timeout);
   }
-  
+
+  /**
+  * Clear all Interrupt Flags
+  * @return true if successful, otherwise false
+  * @remarks
+  * Reads the status registers, which clears every flag including the power ready
+  * flag latched at power-up. The INT pin stays low while any flag is set, so an
+  * edge triggered pin interrupt only fires again after the flags were cleared.
+  */
+  bool clearInterrupts() {
+    uint8_t count = 0;
+    for(uint8_t i = 0; i < MAX3010xImpl::INT_CNT; i++) {
+      if(MAX3010xImpl::INT_ST_REG[i] >= count) count = MAX3010xImpl::INT_ST_REG[i] + 1;
+    }
+    uint8_t status[2];
+    return readBlock(0x00, count, status);
+  }
+
   /**
   * Reads the Part Id
   * @return Part Id or 0xFF on failure
@@ -326,13 +415,7 @@ public:
     FIFORegisters fifo;
     if(!readBlock(MAX3010xImpl::FIFO_BASE, sizeof(FIFORegisters), reinterpret_cast<uint8_t*>(&fifo))) return 0;
     
-    if(fifo.read == fifo.write) {
-      // FIFO is completely full
-      if(fifo.overflow) {
-        return MAX3010xImpl::FIFO_SIZE;
-      }
-    }
-    return (16+fifo.write-fifo.read) % MAX3010xImpl::FIFO_SIZE;
+    return fifoCount(fifo);
   }
   
   /**
@@ -346,10 +429,24 @@ public:
   }
   
   /**
-  * Clears the FIFO
+  * Reads the number of samples lost to FIFO overflows
+  * @return Number of lost samples since the FIFO was cleared
+  * @remarks Counted as the samples after the gap are read, see MAX3010xSample::lost
+  */
+  uint32_t lostSamples() const {
+    return _lostCount;
+  }
+  
+  /**
+  * Clears the FIFO and restarts the sample sequence at 0
   * @return true if successful, otherwise false
   */
   bool clearFIFO() {
+    _readCount = 0;
+    _lostCount = 0;
+    _pendingLost = 0;
+    _gapAt = 0;
+    
     if(!writeByte(MAX3010xImpl::FIFO_WR_PTR_REG, 0)) return false;
     if(!writeByte(MAX3010xImpl::FIFO_RD_PTR_REG, 0)) return false;
     if(!writeByte(MAX3010xImpl::FIFO_OVF_CNT_REG, 0)) return false;
@@ -359,10 +456,11 @@ public:
   /**
   * Read a sample from the FIFO
   * @return Sample or invalid sample in case of an error
+  * @remarks Samples carry a sequence index, gaps left by FIFO overflows are marked in MAX3010xSample::lost
   */
   MAX3010xSample readSample(int timeout = 0) {
     unsigned long startTime = millis();
-    MAX3010xSample sample = { 0 };
+    MAX3010xSample sample = {};
 
     FIFORegisters fifo;
        
@@ -383,9 +481,120 @@ public:
     }
     
     static_cast<MAX3010xImpl*>(this)->fillSampleWithData(data, sample);
+    const bool rollover = static_cast<MAX3010xImpl*>(this)->fifoRollover;
+    const uint32_t firstRead = _readCount;
+    if(rollover) noteOverflow(fifo, firstRead);
+    stampSample(sample);
+    if(!rollover) noteOverflow(fifo, firstRead);
     
     return sample;
   }
+  
+  /**
+  * Drain the FIFO with burst reads
+  * @param samples Buffer for the samples
+  * @param maxSamples Size of the buffer
+  * @return Number of samples read
+  * @remarks
+  * Reads the FIFO pointers once and fetches all available samples with as few
+  * data reads as the Wire buffer allows, instead of two transactions per sample
+  * as with readSample().
+  */
+  size_t readSamples(MAX3010xSample* samples, size_t maxSamples) {
+    FIFORegisters fifo;
+    if(!readBlock(MAX3010xImpl::FIFO_BASE, sizeof(FIFORegisters), reinterpret_cast<uint8_t*>(&fifo))) return 0;
+    
+    size_t count = fifoCount(fifo);
+    if(count > maxSamples) count = maxSamples;
+    
+    const uint8_t sampleBytes = MAX3010xImpl::SAMPLE_SIZE * static_cast<MAX3010xImpl*>(this)->nActiveSlots;
+    const bool rollover = static_cast<MAX3010xImpl*>(this)->fifoRollover;
+    const uint32_t firstRead = _readCount;
+    const size_t samplesPerRead = WIRE_BUFFER_SIZE / sampleBytes;
+    uint8_t data[WIRE_BUFFER_SIZE];
+    
+    size_t done = 0;
+    while(done < count) {
+      size_t chunk = count - done;
+      if(chunk > samplesPerRead) chunk = samplesPerRead;
+      
+      if(!readBlock(MAX3010xImpl::FIFO_DATA_REG, chunk * sampleBytes, data)) {
+        // Restore read pointer to the first unread sample to allow a retry
+        writeByte(MAX3010xImpl::FIFO_RD_PTR_REG, (fifo.read + done) % MAX3010xImpl::FIFO_SIZE);
+        break;
+      }
+      if(done == 0 && rollover) noteOverflow(fifo, firstRead);
+      
+      for(size_t i = 0; i < chunk; i++) {
+        MAX3010xSample sample = {};
+        static_cast<MAX3010xImpl*>(this)->fillSampleWithData(data + i * sampleBytes, sample);
+        stampSample(sample);
+        samples[done + i] = sample;
+      }
+      done += chunk;
+    }
+    if(done > 0 && !rollover) noteOverflow(fifo, firstRead);
+    
+    return done;
+  }
+  
+  /**
+  * Drain the FIFO with burst reads without unpacking the samples
+  * @param buffer Buffer for the raw FIFO data, maxSamples * bytesPerSample() bytes
+  * @param maxSamples Maximum number of samples
+  * @param sequence Reference to store the sequence index of the first sample in
+  * @param lost Reference to store the number of samples lost right before the first sample in
+  * @return Number of samples read
+  * @remarks
+  * The samples of one call are contiguous, a burst stops in front of a gap. The data
+  * is packed as in the FIFO, see MAX3010xUnpacker for turning it into channels.
+  */
+  size_t readRawSamples(uint8_t* buffer, size_t maxSamples, uint32_t& sequence, uint16_t& lost) {
+    FIFORegisters fifo;
+    lost = 0;
+    if(!readBlock(MAX3010xImpl::FIFO_BASE, sizeof(FIFORegisters), reinterpret_cast<uint8_t*>(&fifo))) return 0;
+    
+    size_t count = fifoCount(fifo);
+    if(count > maxSamples) count = maxSamples;
+    if(_pendingLost != 0 && _gapAt > _readCount && count > _gapAt - _readCount) count = _gapAt - _readCount;
+    
+    const uint8_t sampleBytes = bytesPerSample();
+    const bool rollover = static_cast<MAX3010xImpl*>(this)->fifoRollover;
+    const uint32_t firstRead = _readCount;
+    const size_t samplesPerRead = WIRE_BUFFER_SIZE / sampleBytes;
+    
+    size_t done = 0;
+    while(done < count) {
+      size_t chunk = count - done;
+      if(chunk > samplesPerRead) chunk = samplesPerRead;
+      
+      if(!readBlock(MAX3010xImpl::FIFO_DATA_REG, chunk * sampleBytes, buffer + done * sampleBytes)) {
+        // Restore read pointer to the first unread sample to allow a retry
+        writeByte(MAX3010xImpl::FIFO_RD_PTR_REG, (fifo.read + done) % MAX3010xImpl::FIFO_SIZE);
+        break;
+      }
+      if(done == 0) {
+        if(rollover) noteOverflow(fifo, firstRead);
+        sequence = nextSequence(lost);
+        _readCount += chunk - 1;
+      }
+      else {
+        _readCount += chunk;
+      }
+      done += chunk;
+    }
+    if(done > 0 && !rollover) noteOverflow(fifo, firstRead);
+    
+    return done;
+  }
+  
+  /**
+  * Size of one sample in the FIFO
+  * @return Number of bytes per sample for the active LED slots
+  */
+  uint8_t bytesPerSample() {
+    return MAX3010xImpl::SAMPLE_SIZE * static_cast<MAX3010xImpl*>(this)->nActiveSlots;
+  }
 };
 
 #endif
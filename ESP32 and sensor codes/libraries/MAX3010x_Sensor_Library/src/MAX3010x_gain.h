@@ -0,0 +1,226 @@
+/*!
+ * @file MAX3010x_gain.h
+ */
+
+
+#ifndef _MAX3010x_GAIN_H
+#define _MAX3010x_GAIN_H
+
+#include "Arduino.h"
+
+/**
+ * Automatic LED current and ADC range control for the red and IR channel
+ * 
+ * Averages the DC level of both channels over a block of samples and moves the
+ * LED currents proportionally towards the middle of a target band. If a current
+ * runs out of range the shared ADC range is switched, saturated samples halve
+ * the current right away. After every change one block is skipped so the new
+ * setting is measured with settled samples.
+ * 
+ * The controller does not touch the bus in process(), call apply() when it
+ * returns true so that the caller can hold its bus lock.
+ * 
+ * @tparam MAX3010xImpl Sensor class (MAX30101, MAX30102 or MAX30105)
+ */
+template<class MAX3010xImpl> class MAX3010xGainControl {
+public:
+  static const uint32_t FULL_SCALE = 0x3FFFF;           //!< Largest 18 bit FIFO value
+  static const uint32_t SATURATION = FULL_SCALE - 0x400; //!< Values above are treated as clipped
+  static const uint8_t MIN_CURRENT = 2;                 //!< Smallest LED current (0.4 mA)
+  static const uint8_t MAX_CURRENT = 255;               //!< Largest LED current (51 mA)
+  static const uint8_t LOW_CURRENT = 40;                //!< Below this current the ADC range is increased instead (8 mA)
+  
+  /**
+   * Constructor
+   * @param sensor Sensor instance
+   * @param samplesPerUpdate Number of samples averaged for one control step
+   * @param targetLow Lower end of the DC target band in counts
+   * @param targetHigh Upper end of the DC target band in counts
+   * @param minSignal DC level below which no finger is assumed and the settings are kept
+   */
+  MAX3010xGainControl(MAX3010xImpl& sensor, uint16_t samplesPerUpdate = 40, uint32_t targetLow = 0x10000,
+                      uint32_t targetHigh = 0x24000, uint32_t minSignal = 0x1000) :
+    _sensor(sensor),
+    _samplesPerUpdate(samplesPerUpdate),
+    _targetLow(targetLow),
+    _targetHigh(targetHigh),
+    _minSignal(minSignal) {
+    reset(90, 80, MAX3010xImpl::ADC_RANGE_16384NA);
+  }
+  
+  /**
+   * Start over from the given settings, they are written with the next apply()
+   * @param redCurrent Red LED current in 0.2 mA steps
+   * @param irCurrent IR LED current in 0.2 mA steps
+   * @param range ADC range
+   */
+  void reset(uint8_t redCurrent, uint8_t irCurrent, typename MAX3010xImpl::ADCRange range) {
+    _current[0] = redCurrent;
+    _current[1] = irCurrent;
+    _range = range;
+    _pending = true;
+    _settled = false;
+    restartBlock(1);
+  }
+  
+  /**
+   * Add a sample
+   * @param red Red value
+   * @param ir IR value
+   * @return true if the settings changed and apply() should be called
+   */
+  bool process(uint32_t red, uint32_t ir) {
+    if(_skip > 0) {
+      if(++_count >= _samplesPerUpdate) restartBlock(_skip - 1);
+      return false;
+    }
+    
+    _sum[0] += red;
+    _sum[1] += ir;
+    if(red >= SATURATION) _clipped[0] = true;
+    if(ir >= SATURATION) _clipped[1] = true;
+    if(++_count < _samplesPerUpdate) return false;
+    
+    bool changed = update();
+    restartBlock(changed ? 1 : 0);
+    return changed;
+  }
+  
+  /**
+   * Write the current settings to the sensor
+   * @return true if successful, otherwise false
+   */
+  bool apply() {
+    if(!_sensor.setADCRange(_range)) return false;
+    if(!_sensor.setLedCurrent(MAX3010xImpl::LED_RED, _current[0])) return false;
+    if(!_sensor.setLedCurrent(MAX3010xImpl::LED_IR, _current[1])) return false;
+    _pending = false;
+    return true;
+  }
+  
+  /**
+   * Check for settings not yet written by apply()
+   * @return true if apply() is needed
+   */
+  bool pending() const {
+    return _pending;
+  }
+  
+  /**
+   * Check whether both channels are inside the target band
+   * @return true if the last control step made no change
+   */
+  bool settled() const {
+    return _settled;
+  }
+  
+  /**
+   * Get red LED current
+   * @return Current in 0.2 mA steps
+   */
+  uint8_t redCurrent() const {
+    return _current[0];
+  }
+  
+  /**
+   * Get IR LED current
+   * @return Current in 0.2 mA steps
+   */
+  uint8_t irCurrent() const {
+    return _current[1];
+  }
+  
+  /**
+   * Get ADC range
+   * @return ADC range
+   */
+  typename MAX3010xImpl::ADCRange adcRange() const {
+    return _range;
+  }
+private:
+  MAX3010xImpl& _sensor;
+  const uint16_t _samplesPerUpdate;
+  const uint32_t _targetLow;
+  const uint32_t _targetHigh;
+  const uint32_t _minSignal;
+  
+  uint8_t _current[2];
+  typename MAX3010xImpl::ADCRange _range;
+  bool _pending;
+  bool _settled;
+  
+  uint32_t _sum[2];
+  bool _clipped[2];
+  uint16_t _count;
+  uint8_t _skip;
+  
+  void restartBlock(uint8_t skip) {
+    _sum[0] = _sum[1] = 0;
+    _clipped[0] = _clipped[1] = false;
+    _count = 0;
+    _skip = skip;
+  }
+  
+  /**
+   * One control step at the end of a block
+   * @return true if the settings changed
+   */
+  bool update() {
+    uint32_t dc[2] = { _sum[0] / _count, _sum[1] / _count };
+    
+    // No finger, keep the settings for when it comes back
+    if(dc[0] < _minSignal && dc[1] < _minSignal && !_clipped[0] && !_clipped[1]) {
+      _settled = false;
+      return false;
+    }
+    
+    // Wanted current in the current ADC range, 0.2 mA steps
+    const uint32_t target = (_targetLow + _targetHigh) / 2;
+    uint32_t wanted[2];
+    bool outside = false;
+    for(int i = 0; i < 2; i++) {
+      wanted[i] = _current[i];
+      if(_clipped[i]) {
+        wanted[i] = _current[i] / 2;
+        outside = true;
+      }
+      else if(dc[i] < _targetLow || dc[i] > _targetHigh) {
+        // Proportional step, at most a factor of 4 per step
+        uint32_t dcFloor = dc[i] > target / 4 ? dc[i] : target / 4;
+        wanted[i] = (static_cast<uint32_t>(_current[i]) * target + dcFloor / 2) / dcFloor;
+        if(wanted[i] > 4u * _current[i]) wanted[i] = 4u * _current[i];
+        outside = true;
+      }
+    }
+    
+    _settled = !outside;
+    if(!outside) return false;
+    
+    // Each ADC range step doubles the counts per photo current
+    const typename MAX3010xImpl::ADCRange range = _range;
+    uint32_t largest = wanted[0] > wanted[1] ? wanted[0] : wanted[1];
+    if(largest > MAX_CURRENT && _range > MAX3010xImpl::ADC_RANGE_2048NA) {
+      _range = static_cast<typename MAX3010xImpl::ADCRange>(_range - 1);
+      wanted[0] /= 2;
+      wanted[1] /= 2;
+    }
+    else if(largest < LOW_CURRENT && _range < MAX3010xImpl::ADC_RANGE_16384NA) {
+      _range = static_cast<typename MAX3010xImpl::ADCRange>(_range + 1);
+      wanted[0] *= 2;
+      wanted[1] *= 2;
+    }
+    
+    bool changed = _range != range;
+    for(int i = 0; i < 2; i++) {
+      uint8_t current = wanted[i] > MAX_CURRENT ? MAX_CURRENT : (wanted[i] < MIN_CURRENT ? MIN_CURRENT : wanted[i]);
+      if(current != _current[i]) {
+        _current[i] = current;
+        changed = true;
+      }
+    }
+    _pending = _pending || changed;
+    return changed;
+  }
+};
+
+#endif
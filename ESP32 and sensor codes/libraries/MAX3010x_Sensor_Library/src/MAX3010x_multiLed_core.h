@@ -58,6 +58,7 @@ protected:
   Mode currentMode;                                     //!< Current Mode
   uint8_t nActiveSlots;                                 //!< Number of active LED Slots in FIFO data
   uint8_t nConfiguredSlots;                             //!< Number of configured LED Slots
+  bool fifoRollover;                                    //!< FIFO overwrites the oldest samples when full
   
   /**
    * Constructor
@@ -66,7 +67,7 @@ protected:
    * @param addr Sensor Address
    * @param wire TWI bus instance
    */
-  MAX3010xMultiLed(uint8_t addr, TwoWire& wire) : MAX3010x<MAX3010xImpl, MAX3010xSample>(addr, wire) {}
+  MAX3010xMultiLed(uint8_t addr, TwoWire& wire) : MAX3010x<MAX3010xImpl, MAX3010xSample>(addr, wire), fifoRollover(false) {}
   
   /**
    * Common function for setting the Multi LED Configuration
@@ -74,9 +75,7 @@ protected:
    * @param cfg Configuration bytes
    * @return true if successful, otherwise false
    */
-  bool setMultiLedConfigurationInternal(uint8_t activeSlots, uint8_t cfg[2]) {
-    uint8_t value;
-    
+  bool setMultiLedConfigurationInternal(uint8_t activeSlots, uint8_t (&cfg)[2]) {
     if(!MAX3010x<MAX3010xImpl, MAX3010xSample>::writeBlock(MAX3010xImpl::MULTI_LED_CFG_REG_BASE, sizeof(cfg), cfg)) return false;
     
     nConfiguredSlots = activeSlots;
@@ -208,7 +207,9 @@ public:
   * @return true if successful, otherwise false
   */
   bool enableFIFORollover() {
-    return MAX3010x<MAX3010xImpl, MAX3010xSample>::setBit(FIFO_CFG_REG, FIFO_ROLLOVER_EN_BIT, true);
+    if(!MAX3010x<MAX3010xImpl, MAX3010xSample>::setBit(FIFO_CFG_REG, FIFO_ROLLOVER_EN_BIT, true)) return false;
+    fifoRollover = true;
+    return true;
   }
   
   /**
@@ -216,7 +217,29 @@ public:
   * @return true if successful, otherwise false
   */
   bool disableFIFORollover() {
-    return MAX3010x<MAX3010xImpl, MAX3010xSample>::setBit(FIFO_CFG_REG, FIFO_ROLLOVER_EN_BIT, false);
+    if(!MAX3010x<MAX3010xImpl, MAX3010xSample>::setBit(FIFO_CFG_REG, FIFO_ROLLOVER_EN_BIT, false)) return false;
+    fifoRollover = false;
+    return true;
+  }
+  
+  /**
+   * Set FIFO Almost Full Threshold
+   * @param emptySlots Number of free FIFO entries at which the almost full interrupt fires (0 to 15)
+   * @returns true if successful, otherwise false
+   * @remarks
+   * With a value of 15 the interrupt fires once 17 of 32 samples are stored. The flag
+   * is cleared by reading the interrupt status or the FIFO data register.
+   */
+  bool setFIFOAlmostFull(uint8_t emptySlots) {
+    uint8_t cfg;
+    
+    if(emptySlots & (~ FIFO_A_FULL_MASK)) return false;
+    if(!MAX3010x<MAX3010xImpl, MAX3010xSample>::readByte(FIFO_CFG_REG, cfg)) return false;
+    
+    cfg &= ~(FIFO_A_FULL_MASK << FIFO_A_FULL_BIT);
+    cfg |= (emptySlots & FIFO_A_FULL_MASK) << FIFO_A_FULL_BIT;
+    
+    return MAX3010x<MAX3010xImpl, MAX3010xSample>::writeByte(FIFO_CFG_REG, cfg);
   }
   
   /**
@@ -0,0 +1,77 @@
+/*!
+ * @file MAX3010x_unpack.h
+ */
+
+
+#ifndef _MAX3010x_UNPACK_H
+#define _MAX3010x_UNPACK_H
+
+#include "Arduino.h"
+
+/**
+ * Unrolled loop over the slots of one FIFO sample
+ */
+template<uint8_t kSlot, uint8_t kSlotCount> struct MAX3010xSlotLoop {
+  /**
+   * Unpack the remaining slots of a sample
+   * @param data Raw sample data, 3 bytes per slot
+   * @param channels One output array per slot
+   * @param index Index of the sample in the output arrays
+   */
+  static inline void unpack(const uint8_t* data, uint32_t* const* channels, size_t index) {
+    channels[kSlot][index] = (static_cast<uint32_t>(data[3*kSlot]) << 16) | (static_cast<uint32_t>(data[3*kSlot + 1]) << 8) | static_cast<uint32_t>(data[3*kSlot + 2]);
+    MAX3010xSlotLoop<kSlot + 1, kSlotCount>::unpack(data, channels, index);
+  }
+};
+
+/**
+ * End of the unrolled slot loop
+ */
+template<uint8_t kSlotCount> struct MAX3010xSlotLoop<kSlotCount, kSlotCount> {
+  static inline void unpack(const uint8_t*, uint32_t* const*, size_t) {}
+};
+
+/**
+ * Unpacks raw FIFO data of the multi LED parts into one array per slot
+ * 
+ * The slot set is fixed at compile time, so the number of slots and the byte
+ * offsets are constants and the per sample loop is fully unrolled.
+ * 
+ * @tparam MAX3010xImpl Sensor class (MAX30101, MAX30102 or MAX30105)
+ * @tparam kSlots Active slots in FIFO order, e.g. SLOT_RED, SLOT_IR, SLOT_GREEN
+ */
+template<class MAX3010xImpl, typename MAX3010xImpl::SlotConfiguration... kSlots> class MAX3010xUnpacker {
+public:
+  static const uint8_t SLOT_COUNT = sizeof...(kSlots);     //!< Number of active slots
+  static const uint8_t SAMPLE_BYTES = 3 * SLOT_COUNT;     //!< Bytes per sample in the FIFO
+  
+  static_assert(SLOT_COUNT > 0 && SLOT_COUNT <= 4, "1 to 4 slots are supported");
+  
+  /**
+   * Multi LED configuration with the slots of this unpacker
+   * @return Configuration for setMultiLedConfiguration()
+   */
+  static typename MAX3010xImpl::MultiLedConfiguration configuration() {
+    typename MAX3010xImpl::MultiLedConfiguration cfg {};
+    const typename MAX3010xImpl::SlotConfiguration slots[] = { kSlots... };
+    for(uint8_t i = 0; i < SLOT_COUNT; i++) {
+      cfg.slot[i] = slots[i];
+    }
+    return cfg;
+  }
+  
+  /**
+   * Unpack a burst of samples
+   * @param data Raw FIFO data as returned by readRawSamples()
+   * @param count Number of samples
+   * @param channels One output array per slot in slot order, each with space for count values
+   */
+  static void unpack(const uint8_t* data, size_t count, uint32_t* const* channels) {
+    for(size_t i = 0; i < count; i++) {
+      MAX3010xSlotLoop<0, SLOT_COUNT>::unpack(data, channels, i);
+      data += SAMPLE_BYTES;
+    }
+  }
+};
+
+#endif
@@ -2,6 +2,8 @@ import tkinter as tk
 import serial
 import time
 import threading
+import queue
+import json
 import matplotlib
 matplotlib.use('Agg')
 import matplotlib.pyplot as plt
@@ -9,6 +11,8 @@ from datetime import datetime
 from supabase import create_client, Client
 from dotenv import load_dotenv
 import os
+from frame_decoder import (FrameDecoder, FRAME_WEIGHT, FRAME_SPO2, FRAME_PULSE, FRAME_TEMP,
+                           FRAME_ECG_START, FRAME_ECG_SAMPLES, FRAME_DATA_END)
 
 load_dotenv()  # Load environment variables from .env file
 SUPABASE_URL = os.getenv("SUPABASE_URL")
@@ -56,73 +60,213 @@ print("ESP32 synchronization complete")
 # ----------------- Global Variables -----------------
 vitals = {}
 ecg_values = []
+ecg_sample_rate = 50  # Hz, overridden by the ECG start frame from the ESP32
+
+# ----------------- Local Spool -----------------
+# Each session is written to disk while it is captured and the ECG is uploaded in
+# chunks as it arrives. The ESP32 is acknowledged as soon as the session is on disk,
+# rendering and the final upload run in the background. Sessions whose upload did
+# not finish are picked up again on the next start.
+SPOOL_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "spool")
+ECG_CHUNK_SECONDS = 2
+upload_queue = queue.Queue()
+
+def write_spool_file(path, data):
+    # Write to a temporary file first so that a crash never leaves half a file
+    tmp_path = path + ".tmp"
+    with open(tmp_path, "w") as f:
+        json.dump(data, f)
+        f.flush()
+        os.fsync(f.fileno())
+    os.replace(tmp_path, path)
+
+def read_spool_file(path):
+    with open(path) as f:
+        return json.load(f)
+
+def start_spool_session(patient_id, patient_name):
+    session_dir = os.path.join(SPOOL_DIR, f"{patient_id}_{datetime.now().strftime('%Y%m%d_%H%M%S')}")
+    os.makedirs(session_dir, exist_ok=True)
+    write_spool_file(os.path.join(session_dir, "session.json"),
+                     {"patient_id": patient_id, "patient_name": patient_name, "complete": False})
+    return session_dir
+
+def spool_ecg_chunk(session_dir, first_index, samples):
+    path = os.path.join(session_dir, f"ecg_{first_index:08d}.json")
+    write_spool_file(path, {"first_index": first_index, "samples": samples})
+    upload_queue.put(("chunk", session_dir, path))
+
+def finish_spool_session(session_dir, vitals, sample_rate):
+    path = os.path.join(session_dir, "session.json")
+    session = read_spool_file(path)
+    session.update(vitals=vitals, sample_rate=sample_rate, complete=True)
+    write_spool_file(path, session)
+    upload_queue.put(("session", session_dir, None))
+
+def load_spooled_ecg(session_dir):
+    ecg_data = []
+    for name in sorted(os.listdir(session_dir)):
+        if name.startswith("ecg_") and name.endswith(".json"):
+            chunk = read_spool_file(os.path.join(session_dir, name))
+            if chunk["first_index"] > len(ecg_data):
+                # Lost frames, keep the time axis by leaving a gap in the plot
+                ecg_data.extend([float('nan')] * (chunk["first_index"] - len(ecg_data)))
+            ecg_data.extend(chunk["samples"])
+    return ecg_data
+
+def upload_ecg_chunk(session_dir, path):
+    storage_path = f"chunks/{os.path.basename(session_dir)}/{os.path.basename(path)}"
+    with open(path, "rb") as f:
+        supabase.storage.from_("ecg-images").upload(path=storage_path, file=f.read(), file_options={"content-type": "application/json"})
+    print("ECG chunk uploaded:", storage_path)
+
+def upload_spooled_session(session_dir):
+    session = read_spool_file(os.path.join(session_dir, "session.json"))
+    ecg_data = load_spooled_ecg(session_dir)
+    ecg_image_filename = generate_ecg_graph(session["patient_id"], session["patient_name"], ecg_data, session["sample_rate"])
+    if upload_to_supabase(session["patient_id"], session["patient_name"], session["vitals"], ecg_image_filename):
+        write_spool_file(os.path.join(session_dir, "uploaded.json"), {"uploaded": datetime.now().isoformat()})
+    else:
+        print("Upload failed, session kept in", session_dir)
+
+def upload_worker():
+    while True:
+        kind, session_dir, path = upload_queue.get()
+        try:
+            if kind == "chunk":
+                upload_ecg_chunk(session_dir, path)
+            else:
+                upload_spooled_session(session_dir)
+        except Exception as e:
+            # The spool keeps everything, the session upload renders from local files
+            print("Upload error:", e)
+        finally:
+            upload_queue.task_done()
+
+def resume_spool():
+    if not os.path.isdir(SPOOL_DIR):
+        return
+    for name in sorted(os.listdir(SPOOL_DIR)):
+        session_dir = os.path.join(SPOOL_DIR, name)
+        session_path = os.path.join(session_dir, "session.json")
+        if not os.path.exists(session_path) or os.path.exists(os.path.join(session_dir, "uploaded.json")):
+            continue
+        if read_spool_file(session_path).get("complete"):
+            print("Resuming upload of", session_dir)
+            upload_queue.put(("session", session_dir, None))
 
 # ----------------- Function Definitions -----------------
 def read_sensor_data(patient_id, patient_name):
-    global ecg_values, vitals
+    global ecg_values, vitals, ecg_sample_rate
     print("Waiting for sensor data from ESP32...")
     
-    recording_ecg = False
+    decoder = FrameDecoder()
+    data_end = False
+    session_dir = start_spool_session(patient_id, patient_name)
+    chunk_first_index = 0
+    chunk_samples = []
     
-    while True:
+    while not data_end:
         try:
-            line = ser.readline().decode('utf-8').strip()
-            if not line:
+            # Read everything that arrived in one call, the decoder reassembles the frames
+            data = ser.read(ser.in_waiting or 1)
+            if not data:
                 continue
-            print("Received:", line)
             
-            if line.startswith("WEIGHT:"):
-                vitals["weight"] = float(line.split("WEIGHT:")[1])
-            elif line.startswith("SPO2:"):
-                vitals["spo2"] = float(line.split("SPO2:")[1])
-            elif line.startswith("PULSE:"):
-                vitals["pulse"] = int(line.split("PULSE:")[1])
-            elif line.startswith("TEMP:"):
-                vitals["temperature"] = float(line.split("TEMP:")[1])
-            elif line == "ECG_START":
-                print("ECG recording started...")
-                recording_ecg = True
-                continue
-            elif line == "DATA_END":
-                break
-            elif recording_ecg:
-                try:
-                    ecg_values.append(int(line))
-                except ValueError:
-                    pass
+            for event in decoder.feed(data):
+                if isinstance(event, str):
+                    if event.startswith("SPO2_LOSS:"):
+                        lost, total = (int(v) for v in event[len("SPO2_LOSS:"):].split("/"))
+                        share = 100.0 * lost / total if total else 0.0
+                        print(f"SpO2 acquisition: {lost} of {total} samples lost ({share:.1f}%)")
+                    elif event.startswith("ECG_LOSS:"):
+                        lost, total = (int(v) for v in event[len("ECG_LOSS:"):].split("/"))
+                        share = 100.0 * lost / total if total else 0.0
+                        print(f"ECG acquisition: {lost} of {total} samples lost ({share:.1f}%)")
+                    elif event.startswith("OUTPUT_LOSS:"):
+                        lost, total = (int(v) for v in event[len("OUTPUT_LOSS:"):].split("/"))
+                        print(f"Device output: {lost} of {total} lines and frames dropped on a full queue")
+                    elif event.startswith("WEIGHT_STABLE_MS:"):
+                        print(f"Weight settled after {int(event[len('WEIGHT_STABLE_MS:'):]) / 1000:.1f} s")
+                    elif event == "WEIGHT_UNSTABLE":
+                        print("Weight did not settle, reporting the last second")
+                    elif event.startswith("TEMP_PREDICTED_MS:"):
+                        print(f"Temperature predicted after {int(event[len('TEMP_PREDICTED_MS:'):]) / 1000:.1f} s")
+                    elif event == "TEMP_UNSETTLED":
+                        print("Temperature prediction did not converge, reporting the latest estimate")
+                    elif event.startswith("TEMP_PEC_ERRORS:"):
+                        print(f"Temperature: {int(event[len('TEMP_PEC_ERRORS:'):])} reads dropped for a wrong PEC")
+                    else:
+                        print("Received:", event)
+                elif event.type == FRAME_WEIGHT:
+                    vitals["weight"] = round(event.float_value(), 2)
+                elif event.type == FRAME_SPO2:
+                    vitals["spo2"] = float(round(event.float_value()))
+                elif event.type == FRAME_PULSE:
+                    vitals["pulse"] = int(round(event.float_value()))
+                elif event.type == FRAME_TEMP:
+                    vitals["temperature"] = round(event.float_value(), 1)
+                elif event.type == FRAME_ECG_START:
+                    ecg_sample_rate = event.rate()
+                    print(f"ECG recording started at {ecg_sample_rate} Hz...")
+                elif event.type == FRAME_ECG_SAMPLES:
+                    first_index, samples = event.ecg_samples()
+                    if first_index > len(ecg_values):
+                        # Lost frame, keep the time axis by leaving a gap in the plot
+                        ecg_values.extend([float('nan')] * (first_index - len(ecg_values)))
+                    ecg_values.extend(samples)
+                    
+                    # Chunks are contiguous, a gap starts a new one
+                    if chunk_samples and first_index != chunk_first_index + len(chunk_samples):
+                        spool_ecg_chunk(session_dir, chunk_first_index, chunk_samples)
+                        chunk_samples = []
+                    if not chunk_samples:
+                        chunk_first_index = first_index
+                    chunk_samples.extend(samples)
+                    if len(chunk_samples) >= ECG_CHUNK_SECONDS * ecg_sample_rate:
+                        spool_ecg_chunk(session_dir, chunk_first_index, chunk_samples)
+                        chunk_samples = []
+                elif event.type == FRAME_DATA_END:
+                    data_end = True
+                    break
+                if not isinstance(event, str) and event.type != FRAME_ECG_SAMPLES:
+                    print("Received frame:", hex(event.type), vitals)
         except Exception as e:
             print("Error reading serial:", e)
             break
+    
+    if decoder.crc_errors or decoder.lost_frames:
+        print(f"Serial link: {decoder.crc_errors} CRC errors, {decoder.lost_frames} lost frames")
 
     print("Sensor data capture complete.")
     print("Vitals:", vitals)
     print("ECG data length:", len(ecg_values))
-    ecg_image_filename = generate_ecg_graph(patient_id, patient_name, ecg_values)
-    upload_success = upload_to_supabase(patient_id, patient_name, vitals, ecg_image_filename)
-    if upload_success:
-        # Send confirmation to ESP32
+    if chunk_samples:
+        spool_ecg_chunk(session_dir, chunk_first_index, chunk_samples)
+    
+    if data_end:
+        finish_spool_session(session_dir, vitals, ecg_sample_rate)
+        # Send confirmation to ESP32 as soon as the session is safe on disk
         try:
             ser.write(b"DATA_UPLOADED\n")
             ser.flush()
-            print("Sent upload confirmation to ESP32")
-            time.sleep(2)
-            return
+            print("Sent confirmation to ESP32, upload continues in the background")
         except Exception as e:
             print("Failed to send confirmation:", e)
     
+    upload_queue.join()
     ser.close()
     
 
-def generate_ecg_graph(patient_id, patient_name, ecg_data):
+def generate_ecg_graph(patient_id, patient_name, ecg_data, samples_per_second):
     if not ecg_data:
         print("No ECG data captured.")
         return None
     
-    # Keep only the last 15 seconds of data (50 samples/sec * 15 sec = 750 samples)
-    samples_per_second = 50
+    # Keep only the last 15 seconds of data (e.g. 250 samples/sec * 15 sec = 3750 samples)
     desired_seconds = 15
     desired_samples = desired_seconds * samples_per_second
-    ecg_data = ecg_data[-desired_samples:]  # Get last 750 samples or all if less
+    ecg_data = ecg_data[-desired_samples:]  # Get last 15 seconds or all if less
     
     # Calculate sampling parameters based on trimmed data
     sampling_rate = samples_per_second
@@ -218,6 +362,10 @@ def send_patient_info():
         root.destroy()
         threading.Thread(target=read_sensor_data, args=(patient_id, patient_name)).start()
 
+# ----------------- Background Upload -----------------
+threading.Thread(target=upload_worker, daemon=True).start()
+resume_spool()
+
 # ----------------- GUI Setup -----------------
 root = tk.Tk()
 root.title("Enter Patient Information")